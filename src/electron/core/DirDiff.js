@@ -343,6 +343,82 @@ export class DirDiff {
         return sideNode;
     }
 
+    /**
+     * 由原生diffFolderTree的扁平先序数组还原左右对齐树
+     * 父节点下标总小于子节点，单遍即可挂接；一侧不存在的节点填充为空节点
+     */
+    buildTreesFromFlat(flat) {
+        const FLAG_FOLDER = 1;
+        const FLAG_LEFT = 2;
+        const FLAG_RIGHT = 4;
+        const diffTypeOf = (status) => {
+            if (status === DiffStatus.IDENTICAL) return 'same';
+            if (status === DiffStatus.DIFFERENT) return 'different';
+            return 'only';
+        };
+
+        const count = flat.parent.length;
+        const leftNodes = new Array(count);
+        const rightNodes = new Array(count);
+        const relPaths = new Array(count);
+
+        const makeNode = (i, side, rootPath, exists) => {
+            const relativePath = relPaths[i];
+            const diffStatus = flat.status[i];
+            if (!exists) {
+                return {
+                    ...EMPTY_NODE,
+                    id: `${side}_${i}`,
+                    relativePath,
+                    level: flat.level[i],
+                    diffStatus,
+                    children: [],
+                    hasDiff: true
+                };
+            }
+            const isLeft = side === 'left';
+            return {
+                id: `${side}_${i}`,
+                name: i === 0 ? path.basename(rootPath) : flat.names[i],
+                path: i === 0 ? rootPath : path.join(rootPath, relativePath),
+                relativePath,
+                isFolder: (flat.flags[i] & FLAG_FOLDER) !== 0,
+                size: isLeft ? flat.sizeA[i] : flat.sizeB[i],
+                mtime: isLeft ? flat.mtimeA[i] : flat.mtimeB[i],
+                level: flat.level[i],
+                diffStatus,
+                diffType: diffTypeOf(diffStatus),
+                children: [],
+                // 目录状态已由原生按子项聚合
+                hasDiff: diffStatus !== DiffStatus.IDENTICAL
+            };
+        };
+
+        for (let i = 0; i < count; i++) {
+            const parent = i === 0 ? -1 : flat.parent[i];
+            relPaths[i] = i === 0 ? '.' : (parent === 0 ? flat.names[i] : `${relPaths[parent]}/${flat.names[i]}`);
+            leftNodes[i] = makeNode(i, 'left', flat.rootA, (flat.flags[i] & FLAG_LEFT) !== 0);
+            rightNodes[i] = makeNode(i, 'right', flat.rootB, (flat.flags[i] & FLAG_RIGHT) !== 0);
+            if (parent >= 0) {
+                leftNodes[parent].children.push(leftNodes[i]);
+                rightNodes[parent].children.push(rightNodes[i]);
+            }
+        }
+
+        const stats = {
+            ...flat.stats,
+            totalCompared: flat.stats.leftOnlyCount + flat.stats.rightOnlyCount +
+                flat.stats.differentCount + flat.stats.identicalCount
+        };
+
+        return {
+            success: true,
+            leftTree: leftNodes[0] || null,
+            rightTree: rightNodes[0] || null,
+            stats
+        };
+    }
+
     /**
      * 核心入口：轻量文件夹对比
      */
@@ -1,6 +1,7 @@
 import { ipcMain, dialog } from 'electron';
 import { diffFileContent } from '../core/FileDiff.js';
 import { DirDiff } from '../core/DirDiff.js';
+import native from '../service/DevtoolNative.js';
 // import FileOperationManager from '../service/FileOperationManager.js';
 
 class FileCompareHandler {
@@ -65,9 +66,40 @@ class FileCompareHandler {
             return await dirDiff.scanDirRecursive(dirPath);
         });
 
-        ipcMain.handle('diff-folder', async (event, folderA, folderB, ignorePatterns = [/\.DS_Store$/, /Thumbs\.db$/]) => {
+        // ignorePatterns为gitignore语法的模式，由原生扫描在遍历时剪枝；useGitignore读取各级.gitignore
+        // 默认不读.gitignore：比较构建产物等被忽略的文件也是常见用途，需要时由调用方显式开启
+        ipcMain.handle('diff-folder', async (event, folderA, folderB, ignorePatterns = ['.DS_Store', 'Thumbs.db'], useGitignore = false) => {
             const dirDiff = new DirDiff();
-            return await dirDiff.compareFolders(folderA, folderB);
+            // 原生扫描只认gitignore语法，正则等其它类型的模式无法等价转换，直接报错而不是悄悄丢掉
+            const unsupported = ignorePatterns.find(p => typeof p !== 'string');
+            if (unsupported !== undefined) {
+                return {
+                    success: false,
+                    error: `ignorePatterns只支持gitignore语法的字符串，不支持: ${String(unsupported)}`,
+                    leftTree: null,
+                    rightTree: null,
+                    stats: null
+                };
+            }
+            // 原生模块在C++中完成遍历、比对与两侧对齐；未加载时退回JS实现
+            if (!native.isLoaded) {
+                return await dirDiff.compareFolders(folderA, folderB);
+            }
+            try {
+                const flat = await native.diffFolderTree(folderA, folderB, false, {
+                    ignorePatterns,
+                    gitignore: useGitignore
+                });
+                return dirDiff.buildTreesFromFlat(flat);
+            } catch (error) {
+                return {
+                    success: false,
+                    error: error.message,
+                    leftTree: null,
+                    rightTree: null,
+                    stats: null
+                };
+            }
         });
     }
 }
@@ -187,7 +187,7 @@ contextBridge.exposeInMainWorld('channel', {
     // 选择文件夹
     selectFolder: () => ipcRenderer.invoke('select-folder'),
     loadFolder: (dirPath) => ipcRenderer.invoke('load-folder', dirPath),
-    diffFolder: (folderA, folderB) => ipcRenderer.invoke('diff-folder', folderA, folderB),
+    diffFolder: (folderA, folderB, ignorePatterns, useGitignore) => ipcRenderer.invoke('diff-folder', folderA, folderB, ignorePatterns, useGitignore),
     // 股票行情
     searchShares: (keyword) => ipcRenderer.invoke('mini-stock:search-shares', keyword),
     getKline: (codes, market, period, startDate, endDate) => ipcRenderer.invoke('mini-stock:kline', codes, market, period, startDate, endDate),
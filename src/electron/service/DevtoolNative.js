@@ -12,6 +12,7 @@ class DevtoolNative {
         this.isLoaded = false;
         this.platform = process.platform;
         this.arch = process.arch;
+        this.rpcView = null; // rpcConnect后指向原生RPC响应缓冲
     }
 
     // 获取当前平台的模块文件名
@@ -260,6 +261,252 @@ class DevtoolNative {
         }
     }
 
+    // 两侧对齐的目录差异树（扁平先序数组，见DirDiff.buildTreesFromFlat）
+    // options: { ignorePatterns: gitignore语法的模式数组, gitignore: 是否读取各级.gitignore }
+    diffFolderTree(folderA, folderB, ignoreHidden = false, options = {}) {
+        if (!this.isLoaded) {
+            return Promise.reject(new Error(`Native module not loaded for platform ${this.platform}`));
+        }
+        return new Promise((resolve, reject) => {
+            this.nativeModule.diffFolderTree(folderA, folderB, ignoreHidden, options, (err, result) => {
+                if (err) reject(err);
+                else resolve(result);
+            });
+        });
+    }
+
+    // 查找重复文件：onGroup每确认一组收到{size, hash, paths}（大文件组优先），Promise最终返回统计
+    findDuplicates(roots, options = {}, onGroup = () => {}) {
+        if (!this.isLoaded) {
+            return Promise.reject(new Error(`Native module not loaded for platform ${this.platform}`));
+        }
+        return new Promise((resolve, reject) => {
+            this.nativeModule.findDuplicates(roots, options, onGroup, (err, result) => {
+                if (err) reject(err);
+                else resolve(result);
+            });
+        });
+    }
+
+    // 二进制区域对比：返回{sizeA, sizeB, chunkSize, crcA, crcB, ranges: [{offset, length}]}
+    diffFileRegions(fileA, fileB, chunkSize = 0) {
+        if (!this.isLoaded) {
+            return Promise.reject(new Error(`Native module not loaded for platform ${this.platform}`));
+        }
+        return new Promise((resolve, reject) => {
+            this.nativeModule.diffFileRegions(fileA, fileB, chunkSize, (err, result) => {
+                if (err) reject(err);
+                else resolve(result);
+            });
+        });
+    }
+
+    // 实时文件夹对比（Linux）：onDelta收到{initial, changed, removed}，Promise返回{id, ...统计}，用unwatchCompare(id)结束
+    watchCompare(folderA, folderB, ignoreHidden = false, options = {}, onDelta = () => {}) {
+        if (!this.isLoaded) {
+            return Promise.reject(new Error(`Native module not loaded for platform ${this.platform}`));
+        }
+        return new Promise((resolve, reject) => {
+            this.nativeModule.watchCompare(folderA, folderB, ignoreHidden, options, onDelta, (err, result) => {
+                if (err) reject(err);
+                else resolve(result);
+            });
+        });
+    }
+
+    unwatchCompare(id) {
+        if (!this.isLoaded) {
+            return false;
+        }
+        return this.nativeModule.unwatchCompare(id);
+    }
+
+    // 共享内存通道：等待readerId有新消息（timeoutMs<0不超时），resolve为true表示有消息可读、false表示超时
+    waitRead(readerId, timeoutMs = -1) {
+        if (!this.isLoaded) {
+            return Promise.reject(new Error(`Native module not loaded for platform ${this.platform}`));
+        }
+        return new Promise((resolve, reject) => {
+            this.nativeModule.waitRead(readerId, timeoutMs, (err, ready) => {
+                if (err) reject(err);
+                else resolve(ready);
+            });
+        });
+    }
+
+    // 共享内存通道批量读取：返回本次取得的条数，消息按48字节记录写入shmBatchBuffer()
+    // 记录格式（小端）：[0]id u64 | [8]offset u64 | [16]ts u64 | [24]type u32 | [28]len u32 |
+    // [32]payloadEnd u64 | [40]payloadOffset u32 | [44]payloadLen u32（payloadLen为0表示没有负载）
+    readBatch(readerId, maxCount = 4096) {
+        if (!this.isLoaded) {
+            throw new Error(`Native module not loaded for platform ${this.platform}`);
+        }
+        return this.nativeModule.readBatch(readerId, maxCount);
+    }
+
+    // readBatch复用的缓冲区（固定不变，可长期持有其DataView/BigUint64Array）
+    shmBatchBuffer() {
+        if (!this.isLoaded) {
+            throw new Error(`Native module not loaded for platform ${this.platform}`);
+        }
+        return this.nativeModule.batchBuffer();
+    }
+
+    // 通道负载区（直接映射共享内存，零拷贝）；运行时不允许外部缓冲时返回null，此时用copyShmPayload
+    shmPayloadBuffer() {
+        if (!this.isLoaded) {
+            throw new Error(`Native module not loaded for platform ${this.platform}`);
+        }
+        return this.nativeModule.payloadBuffer();
+    }
+
+    // 按批量记录中的payloadOffset/payloadLen复制一份负载，返回Buffer
+    copyShmPayload(offset, length) {
+        if (!this.isLoaded) {
+            throw new Error(`Native module not loaded for platform ${this.platform}`);
+        }
+        return this.nativeModule.copyPayload(offset, length);
+    }
+
+    // 负载持有模式：开启后读到的负载一直有效，直到以记录中的payloadEnd调用releaseShmPayload
+    holdShmPayloads(readerId, hold = true) {
+        if (!this.isLoaded) {
+            throw new Error(`Native module not loaded for platform ${this.platform}`);
+        }
+        return this.nativeModule.holdPayloads(readerId, hold);
+    }
+
+    releaseShmPayload(readerId, payloadEnd) {
+        if (!this.isLoaded) {
+            throw new Error(`Native module not loaded for platform ${this.platform}`);
+        }
+        return this.nativeModule.releasePayload(readerId, payloadEnd);
+    }
+
+    // 打开通道；options为{populate, hugePages, lock, numaNode}，大通道预先缺页并锁定常驻，首条消息起延迟平稳
+    openShmChannel(name, options = {}) {
+        if (!this.isLoaded) {
+            throw new Error(`Native module not loaded for platform ${this.platform}`);
+        }
+        return this.nativeModule.openChannel(name, options);
+    }
+
+    // 通道统计：溢出策略、写入/丢弃/覆盖/溢出文件条数、最大落后量、阻塞等待、各读者的游标与落后量，
+    // 以及mapping（本进程映射上实际生效的映射选项）
+    shmChannelStats() {
+        if (!this.isLoaded) {
+            throw new Error(`Native module not loaded for platform ${this.platform}`);
+        }
+        return this.nativeModule.channelStats();
+    }
+
+    // 读者自上次查询以来是否因落后过多而跳过了消息（覆盖最旧策略），查询后清除
+    takeShmLagged(readerId) {
+        if (!this.isLoaded) {
+            throw new Error(`Native module not loaded for platform ${this.platform}`);
+        }
+        return this.nativeModule.takeLagged(readerId);
+    }
+
+    // 读取溢出文件（路径见shmChannelStats().spillPath）：返回{records, next}，下次从next继续
+    readShmSpill(path, offset = 0, maxCount = 1024) {
+        if (!this.isLoaded) {
+            throw new Error(`Native module not loaded for platform ${this.platform}`);
+        }
+        return this.nativeModule.readSpill(path, offset, maxCount);
+    }
+
+    // 读取通道日志历史（路径见shmChannelStats().journalPath）：返回{records, next, first}
+    // 晚到的读者先从日志读到next >= shmChannelStats().oldestSeq，再用seekShmRead(readerId, next)切换到实时环
+    // record.gap为true时负载没有写入日志（payload为null）；日志段切换失败期间的消息缺失，seq不连续
+    readShmJournal(path, fromSeq = 0, maxCount = 1024) {
+        if (!this.isLoaded) {
+            throw new Error(`Native module not loaded for platform ${this.platform}`);
+        }
+        return this.nativeModule.readJournal(path, fromSeq, maxCount);
+    }
+
+    seekShmRead(readerId, seq) {
+        if (!this.isLoaded) {
+            throw new Error(`Native module not loaded for platform ${this.platform}`);
+        }
+        return this.nativeModule.seekRead(readerId, seq);
+    }
+
+    // 共享内存RPC服务端：在本进程的原生线程中处理高频查询，其它加载了原生模块的进程用rpcConnect连接
+    rpcServe(name) {
+        if (!this.isLoaded) {
+            throw new Error(`Native module not loaded for platform ${this.platform}`);
+        }
+        return this.nativeModule.rpcServe(name);
+    }
+
+    rpcStop() {
+        if (!this.isLoaded) {
+            return false;
+        }
+        return this.nativeModule.rpcStop();
+    }
+
+    rpcConnect(name) {
+        if (!this.isLoaded) {
+            throw new Error(`Native module not loaded for platform ${this.platform}`);
+        }
+        const ok = this.nativeModule.rpcConnect(name);
+        this.rpcView = ok ? new DataView(this.nativeModule.rpcBuffer()) : null;
+        return ok;
+    }
+
+    // 同步调用：返回响应长度（响应在this.rpcView开头），失败返回负的状态码
+    // 状态码：1未知方法 2参数错误 3处理失败 4超时 5未连接或服务端已停止
+    // 同步阻塞调用线程直到响应或超时，主进程里请保持较小的timeoutMs，避免服务端卡住时冻结界面
+    rpcCall(method, request = undefined, timeoutMs = 50) {
+        if (!this.isLoaded) {
+            throw new Error(`Native module not loaded for platform ${this.platform}`);
+        }
+        return this.nativeModule.rpcCall(method, request, timeoutMs);
+    }
+
+    // 经RPC获取光标位置，失败返回null
+    rpcCursorPosition() {
+        if (this.rpcCall(2) < 8) return null;
+        return { x: this.rpcView.getInt32(0, true), y: this.rpcView.getInt32(4, true) };
+    }
+
+    // 经RPC做窗口命中测试（窗口快照最多复用200ms），未命中或失败返回null
+    rpcWindowAt(x, y) {
+        const request = new Int32Array([x, y]);
+        const len = this.rpcCall(3, request);
+        if (len < 28) return null;
+        const view = this.rpcView;
+        return {
+            handle: Number(view.getBigInt64(0, true)),
+            pid: view.getInt32(8, true),
+            x: view.getInt32(12, true),
+            y: view.getInt32(16, true),
+            width: view.getUint32(20, true),
+            height: view.getUint32(24, true),
+            title: new TextDecoder().decode(new Uint8Array(view.buffer, 28, len - 28))
+        };
+    }
+
+    // 映射命名共享内存段为ArrayBuffer（零拷贝，读写直接作用于共享内存，回收时自动解除映射）
+    // size省略时映射整个段；段不存在、size超过段大小或运行时不允许外部缓冲时返回null（后者改用readShmRegion）
+    mapShmRegion(name, size = 0) {
+        if (!this.isLoaded) {
+            throw new Error(`Native module not loaded for platform ${this.platform}`);
+        }
+        return this.nativeModule.mapRegion(name, size);
+    }
+
+    // 复制命名共享内存段中[offset, offset + length)的内容，返回Buffer，段不存在时返回null
+    readShmRegion(name, offset, length) {
+        if (!this.isLoaded) {
+            throw new Error(`Native module not loaded for platform ${this.platform}`);
+        }
+        return this.nativeModule.readRegion(name, offset, length);
+    }
+
     // 检查屏幕是否冻结
     isScreenFreezeed() {
         if (!this.isLoaded) {
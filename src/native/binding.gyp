@@ -5,6 +5,7 @@
       "sources": [
         "src/main.cc",
         "src/file-compare/file_compare.cpp",
+        "src/file-compare/compare_session.cpp",
         "src/screen-freeze/screen_freeze.cc",
       ],
       "include_dirs": [
@@ -30,6 +31,7 @@
             "-lgdi32.lib",
             "-ldwmapi.lib",
             "-lpsapi.lib",
+            "-ladvapi32.lib",
             "-lzlib.lib"
           ],
           "cflags!": [ "-fno-exceptions" ],
@@ -0,0 +1,651 @@
+#ifndef ARCHIVE_READER_H
+#define ARCHIVE_READER_H
+
+#include "utils.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+#include <ctime>
+
+// 压缩包格式
+enum class ArchiveFormat {
+    None = 0,
+    Gzip,    // 单个.gz文件
+    Tar,
+    TarGzip, // .tar.gz/.tgz
+    Zip
+};
+
+// 压缩包内的条目
+struct ArchiveEntry {
+    std::string path;  // 包内路径，分隔符'/'，不含开头的"./"与"/"
+    bool is_dir = false;
+    uint64_t size = 0;
+    int64_t mtime = 0; // 毫秒时间戳
+    bool crc_known = false; // zip中央目录自带CRC，分类时只需读取采样
+    uint32_t crc32 = 0;
+};
+
+// 包内路径写作"<压缩包>!/<包内路径>"，可直接作为compareFiles的参数
+constexpr char kArchiveMemberMark = '!';
+
+// 压缩包流式读取：不解压到磁盘，内存占用与包大小无关
+// tar/tar.gz顺序读取（gzip无法随机访问，一遍完成所有条目）；zip按中央目录列出，条目按本地头偏移随机读取
+class ArchiveReader {
+public:
+    // 条目内容读取器，返回0表示结束（只在visit回调内有效）
+    using ContentReader = std::function<size_t(char*, size_t)>;
+    // 返回false提前结束遍历
+    using Visitor = std::function<bool(const ArchiveEntry&, const ContentReader&)>;
+
+    // 按文件头魔数判断格式（目录或无法识别返回None）
+    static ArchiveFormat detect(const std::string& path) {
+        std::error_code ec;
+        if (!fs::is_regular_file(path, ec)) return ArchiveFormat::None;
+        std::ifstream file(path, std::ios::binary);
+        unsigned char head[4] = {};
+        if (!file.read(reinterpret_cast<char*>(head), sizeof(head))) return ArchiveFormat::None;
+        if (head[0] == 'P' && head[1] == 'K' && ((head[2] == 3 && head[3] == 4) || (head[2] == 5 && head[3] == 6))) {
+            return ArchiveFormat::Zip;
+        }
+        if (head[0] == 0x1F && head[1] == 0x8B) {
+            // 解压出第一个块判断是否为tar（损坏的流在读取时报错）
+            try {
+                GzipInput gz(path);
+                char block[512];
+                return gz.read_full(block, sizeof(block)) == sizeof(block) && tar_header_valid(block)
+                           ? ArchiveFormat::TarGzip : ArchiveFormat::Gzip;
+            } catch (const std::exception&) {
+                return ArchiveFormat::Gzip;
+            }
+        }
+        FileInput raw(path);
+        char block[512];
+        if (raw.read_full(block, sizeof(block)) == sizeof(block) && tar_header_valid(block)) return ArchiveFormat::Tar;
+        return ArchiveFormat::None;
+    }
+
+    // 拆分"<压缩包>!/<包内路径>"，前缀必须是可识别的压缩包
+    static bool split_member_path(const std::string& path, std::string& archive, std::string& member) {
+        for (size_t pos = path.find(kArchiveMemberMark); pos != std::string::npos;
+             pos = path.find(kArchiveMemberMark, pos + 1)) {
+            if (pos + 1 >= path.size() || (path[pos + 1] != '/' && path[pos + 1] != '\\')) continue;
+            std::string prefix = path.substr(0, pos);
+            if (detect(prefix) == ArchiveFormat::None) continue;
+            archive = prefix;
+            member = path.substr(pos + 2);
+            std::replace(member.begin(), member.end(), '\\', '/');
+            return true;
+        }
+        return false;
+    }
+
+    // 遍历全部条目
+    static bool for_each(const std::string& path, const Visitor& visit, std::string& error) {
+        try {
+            switch (detect(path)) {
+                case ArchiveFormat::Tar: {
+                    FileInput in(path);
+                    return read_tar(in, visit, error);
+                }
+                case ArchiveFormat::TarGzip: {
+                    GzipInput in(path);
+                    return read_tar(in, visit, error);
+                }
+                case ArchiveFormat::Gzip:
+                    return read_gzip(path, visit, error);
+                case ArchiveFormat::Zip:
+                    return read_zip(path, visit, nullptr, error);
+                default:
+                    error = "Unsupported archive: " + path;
+                    return false;
+            }
+        } catch (const std::exception& e) {
+            error = "Failed to read archive " + path + ": " + exception_to_string(e);
+            return false;
+        }
+    }
+
+    // 读取单个条目内容（超过max_size视为失败）
+    static bool read_member(const std::string& path, const std::string& member, std::string& out,
+                            uint64_t max_size, std::string& error) {
+        bool found = false;
+        out.clear();
+        bool ok = visit_member(path, member, [&](const ArchiveEntry&, const ContentReader& read) {
+            found = true;
+            size_t got = 0;
+            for (;;) {
+                if (out.size() - got < 64 * 1024) out.resize(std::max<size_t>(out.size() * 2, got + 64 * 1024));
+                size_t n = read(&out[got], out.size() - got);
+                if (n == 0) break;
+                got += n;
+                if (got > max_size) {
+                    error = "Archive member too large: " + member;
+                    break;
+                }
+            }
+            out.resize(got);
+        }, error);
+        if (ok && !found) error = "Archive member not found: " + member;
+        return ok && found && error.empty();
+    }
+
+    // 单遍分类单个条目（与classify_file结果一致）
+    static bool classify_member(const std::string& path, const std::string& member, FileClassification& out,
+                                std::string& error) {
+        bool found = false;
+        bool ok = visit_member(path, member, [&](const ArchiveEntry& entry, const ContentReader& read) {
+            found = true;
+            out = classify_entry(entry, read);
+        }, error);
+        if (ok && !found) error = "Archive member not found: " + member;
+        return ok && found;
+    }
+
+    // 条目分类（与classify_file结果一致）：CRC已知时只读取文本/编码判断所需的采样，否则流式读完全部内容
+    static FileClassification classify_entry(const ArchiveEntry& entry, const ContentReader& read) {
+        ContentClassifier classifier;
+        std::vector<char> buf(entry.crc_known ? ContentClassifier::kSampleSize : 256 * 1024);
+        uint64_t total = 0;
+        for (size_t n; (n = read(buf.data(), buf.size())) > 0;) {
+            classifier.update(buf.data(), n);
+            total += n;
+            if (entry.crc_known && total >= ContentClassifier::kSampleSize) break;
+        }
+        FileClassification cls = classifier.finish();
+        if (entry.crc_known) {
+            cls.size = entry.size;
+            cls.crc32 = entry.crc32;
+        }
+        return cls;
+    }
+
+private:
+    // 顺序输入流
+    class Input {
+    public:
+        virtual ~Input() = default;
+        virtual size_t read(char* buf, size_t len) = 0;
+
+        size_t read_full(char* buf, size_t len) {
+            size_t got = 0;
+            while (got < len) {
+                size_t n = read(buf + got, len - got);
+                if (n == 0) break;
+                got += n;
+            }
+            return got;
+        }
+
+        virtual bool skip(uint64_t len) {
+            char buf[64 * 1024];
+            while (len > 0) {
+                size_t n = read(buf, static_cast<size_t>(std::min<uint64_t>(len, sizeof(buf))));
+                if (n == 0) return false;
+                len -= n;
+            }
+            return true;
+        }
+    };
+
+    class FileInput : public Input {
+    public:
+        explicit FileInput(const std::string& path) : file(path, std::ios::binary) {
+            if (!file.is_open()) throw std::runtime_error("Failed to open file: " + path);
+        }
+        size_t read(char* buf, size_t len) override {
+            file.read(buf, static_cast<std::streamsize>(len));
+            return static_cast<size_t>(file.gcount());
+        }
+        bool skip(uint64_t len) override {
+            file.seekg(static_cast<std::streamoff>(len), std::ios::cur);
+            return static_cast<bool>(file);
+        }
+        std::ifstream& stream() { return file; }
+
+    private:
+        std::ifstream file;
+    };
+
+    // gzip流式解压（支持多成员拼接的.gz）
+    class GzipInput : public Input {
+    public:
+        explicit GzipInput(const std::string& path) : file(path) {
+            std::memset(&zs, 0, sizeof(zs));
+            if (inflateInit2(&zs, 15 + 32) != Z_OK) throw std::runtime_error("inflateInit failed");
+        }
+        ~GzipInput() override { inflateEnd(&zs); }
+
+        size_t read(char* buf, size_t len) override {
+            zs.next_out = reinterpret_cast<Bytef*>(buf);
+            zs.avail_out = static_cast<uInt>(std::min<size_t>(len, 1u << 30));
+            while (zs.avail_out > 0 && !finished) {
+                if (zs.avail_in == 0) {
+                    size_t n = file.read(in.data(), in.size());
+                    if (n == 0) throw std::runtime_error("Truncated gzip stream");
+                    zs.next_in = reinterpret_cast<Bytef*>(in.data());
+                    zs.avail_in = static_cast<uInt>(n);
+                }
+                int rc = inflate(&zs, Z_NO_FLUSH);
+                if (rc == Z_STREAM_END) {
+                    // 后面可能还有下一个gzip成员
+                    if (zs.avail_in == 0) {
+                        size_t n = file.read(in.data(), in.size());
+                        if (n == 0) {
+                            finished = true;
+                            break;
+                        }
+                        zs.next_in = reinterpret_cast<Bytef*>(in.data());
+                        zs.avail_in = static_cast<uInt>(n);
+                    }
+                    inflateReset(&zs);
+                } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+                    throw std::runtime_error("Corrupted gzip stream");
+                } else if (rc == Z_BUF_ERROR && zs.avail_in == 0) {
+                    continue;
+                }
+            }
+            return len - zs.avail_out;
+        }
+
+    private:
+        FileInput file;
+        z_stream zs;
+        std::vector<char> in = std::vector<char>(256 * 1024);
+        bool finished = false;
+    };
+
+    // 解析tar头中的数字字段：八进制文本，或首字节最高位为1的base-256（GNU大文件）
+    static uint64_t tar_number(const char* p, size_t len) {
+        const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+        if (len > 0 && (u[0] & 0x80)) {
+            uint64_t v = u[0] & 0x7F;
+            for (size_t i = 1; i < len; ++i) v = (v << 8) | u[i];
+            return v;
+        }
+        uint64_t v = 0;
+        size_t i = 0;
+        while (i < len && (p[i] == ' ' || p[i] == '\0')) ++i;
+        for (; i < len && p[i] >= '0' && p[i] <= '7'; ++i) v = (v << 3) | static_cast<uint64_t>(p[i] - '0');
+        return v;
+    }
+
+    // 校验和：头部字节之和（校验和字段按空格计）
+    static bool tar_header_valid(const char* block) {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < 512; ++i) {
+            sum += (i >= 148 && i < 156) ? ' ' : static_cast<unsigned char>(block[i]);
+        }
+        return sum != 8 * ' ' && sum == tar_number(block + 148, 8);
+    }
+
+    static std::string tar_string(const char* p, size_t len) {
+        return std::string(p, strnlen(p, len));
+    }
+
+    // 去掉开头的"./"与"/"以及末尾的"/"
+    static std::string clean_path(std::string path, bool& is_dir) {
+        while (path.rfind("./", 0) == 0) path.erase(0, 2);
+        while (!path.empty() && path[0] == '/') path.erase(0, 1);
+        if (!path.empty() && path.back() == '/') {
+            is_dir = true;
+            while (!path.empty() && path.back() == '/') path.pop_back();
+        }
+        return path;
+    }
+
+    // 读取文件大小的数据块并去掉末尾的NUL（GNU长文件名/pax扩展头）
+    static std::string read_blob(Input& in, uint64_t size) {
+        if (size > 16 * 1024 * 1024) throw std::runtime_error("Tar extended header too large");
+        std::string data(static_cast<size_t>(size), '\0');
+        if (in.read_full(&data[0], data.size()) != data.size()) throw std::runtime_error("Truncated tar");
+        in.skip((512 - size % 512) % 512);
+        return data;
+    }
+
+    static bool read_tar(Input& in, const Visitor& visit, std::string& error) {
+        char block[512];
+        std::string long_name;
+        std::string pax_path;
+        uint64_t pax_size = UINT64_MAX;
+        int zero_blocks = 0;
+        while (in.read_full(block, sizeof(block)) == sizeof(block)) {
+            if (std::all_of(block, block + 512, [](char c) { return c == '\0'; })) {
+                if (++zero_blocks == 2) break;
+                continue;
+            }
+            zero_blocks = 0;
+            if (!tar_header_valid(block)) {
+                error = "Corrupted tar header";
+                return false;
+            }
+            const char type = block[156];
+            uint64_t size = tar_number(block + 124, 12);
+            if (type == 'L') { // GNU长文件名
+                long_name = read_blob(in, size);
+                long_name.resize(strnlen(long_name.c_str(), long_name.size()));
+                continue;
+            }
+            if (type == 'x') { // pax扩展头："长度 键=值\n"
+                std::string data = read_blob(in, size);
+                for (size_t pos = 0; pos < data.size();) {
+                    size_t space = data.find(' ', pos);
+                    if (space == std::string::npos) break;
+                    size_t rec_len = static_cast<size_t>(std::strtoull(data.c_str() + pos, nullptr, 10));
+                    if (rec_len == 0 || pos + rec_len > data.size()) break;
+                    std::string record = data.substr(space + 1, pos + rec_len - space - 2);
+                    size_t eq = record.find('=');
+                    if (eq != std::string::npos) {
+                        std::string key = record.substr(0, eq);
+                        if (key == "path") pax_path = record.substr(eq + 1);
+                        else if (key == "size") pax_size = std::strtoull(record.c_str() + eq + 1, nullptr, 10);
+                    }
+                    pos += rec_len;
+                }
+                continue;
+            }
+            if (type == 'g' || type == 'K') { // 全局pax头、GNU长链接名：不影响条目
+                in.skip(size + (512 - size % 512) % 512);
+                continue;
+            }
+
+            std::string name;
+            if (!pax_path.empty()) {
+                name = pax_path;
+            } else if (!long_name.empty()) {
+                name = long_name;
+            } else {
+                name = tar_string(block, 100);
+                std::string prefix = tar_string(block + 345, 155);
+                if (std::memcmp(block + 257, "ustar", 5) == 0 && !prefix.empty()) name = prefix + "/" + name;
+            }
+            if (pax_size != UINT64_MAX) size = pax_size;
+            long_name.clear();
+            pax_path.clear();
+            pax_size = UINT64_MAX;
+
+            ArchiveEntry entry;
+            entry.is_dir = type == '5';
+            entry.path = clean_path(name, entry.is_dir);
+            entry.mtime = static_cast<int64_t>(tar_number(block + 136, 12)) * 1000;
+            const bool regular = type == '0' || type == '\0' || type == '7';
+            entry.size = regular ? size : 0;
+            // 符号链接、硬链接、设备文件等不作为文件内容参与对比
+            const uint64_t data_size = (type == '1' || type == '2' || entry.is_dir) ? 0 : size;
+
+            uint64_t remaining = entry.size;
+            bool truncated = false;
+            bool keep_going = true;
+            if (!entry.path.empty() && (regular || entry.is_dir)) {
+                ContentReader reader = [&](char* buf, size_t len) -> size_t {
+                    size_t want = static_cast<size_t>(std::min<uint64_t>(len, remaining));
+                    size_t n = in.read(buf, want);
+                    if (n == 0 && want > 0) truncated = true;
+                    remaining -= n;
+                    return n;
+                };
+                keep_going = visit(entry, reader);
+            }
+            uint64_t consumed = regular ? entry.size - remaining : 0;
+            uint64_t padded = data_size + (512 - data_size % 512) % 512;
+            if (truncated || !in.skip(padded - consumed)) {
+                error = "Truncated tar: " + entry.path;
+                return false;
+            }
+            if (!keep_going) return true;
+        }
+        return true;
+    }
+
+    // 单个.gz：条目名取文件名去掉扩展名，修改时间取gzip头
+    static bool read_gzip(const std::string& path, const Visitor& visit, std::string& error) {
+        ArchiveEntry entry;
+        fs::path p(path);
+        std::string ext = p.extension().string();
+        entry.path = (ext == ".gz" || ext == ".gzip" || ext == ".z") ? p.stem().string() : p.filename().string() + ".out";
+        {
+            std::ifstream file(path, std::ios::binary);
+            unsigned char head[8] = {};
+            file.read(reinterpret_cast<char*>(head), sizeof(head));
+            entry.mtime = static_cast<int64_t>(head[4] | (head[5] << 8) | (head[6] << 16) | (static_cast<uint32_t>(head[7]) << 24)) * 1000;
+        }
+        // 解压后大小取尾部ISIZE（与gzip -l相同，按2^32取模）；内容读取不受其限制
+        {
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            unsigned char trailer[4] = {};
+            if (file.tellg() >= 18) {
+                file.seekg(-4, std::ios::end);
+                file.read(reinterpret_cast<char*>(trailer), sizeof(trailer));
+            }
+            entry.size = le32(trailer);
+        }
+        (void)error;
+        GzipInput in(path);
+        ContentReader reader = [&](char* out, size_t len) { return in.read(out, len); };
+        visit(entry, reader);
+        return true;
+    }
+
+    static uint16_t le16(const unsigned char* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+    static uint32_t le32(const unsigned char* p) {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+    static uint64_t le64(const unsigned char* p) {
+        return static_cast<uint64_t>(le32(p)) | (static_cast<uint64_t>(le32(p + 4)) << 32);
+    }
+
+    // DOS日期时间（本地时间）转毫秒时间戳
+    static int64_t dos_time_ms(uint16_t date, uint16_t time) {
+        std::tm tm{};
+        tm.tm_year = ((date >> 9) & 0x7F) + 80;
+        tm.tm_mon = ((date >> 5) & 0x0F) - 1;
+        tm.tm_mday = date & 0x1F;
+        tm.tm_hour = (time >> 11) & 0x1F;
+        tm.tm_min = (time >> 5) & 0x3F;
+        tm.tm_sec = (time & 0x1F) * 2;
+        tm.tm_isdst = -1;
+        std::time_t t = std::mktime(&tm);
+        return t == static_cast<std::time_t>(-1) ? 0 : static_cast<int64_t>(t) * 1000;
+    }
+
+    // zip中央目录条目
+    struct ZipEntry {
+        ArchiveEntry entry;
+        uint16_t method = 0;
+        uint64_t compressed = 0;
+        uint64_t local_offset = 0;
+    };
+
+    // 读取中央目录（支持zip64）
+    static bool zip_directory(std::ifstream& file, std::vector<ZipEntry>& out, std::string& error) {
+        file.seekg(0, std::ios::end);
+        const uint64_t file_size = static_cast<uint64_t>(file.tellg());
+        // 目录结束记录在文件尾部，最多带64KB注释
+        const uint64_t tail = std::min<uint64_t>(file_size, 65536 + 22);
+        std::vector<unsigned char> buf(static_cast<size_t>(tail));
+        file.seekg(static_cast<std::streamoff>(file_size - tail));
+        file.read(reinterpret_cast<char*>(buf.data()), static_cast<std::streamsize>(tail));
+        size_t eocd = std::string::npos;
+        for (size_t i = tail >= 22 ? tail - 22 + 1 : 0; i-- > 0;) {
+            if (le32(&buf[i]) == 0x06054b50) {
+                eocd = i;
+                break;
+            }
+        }
+        if (eocd == std::string::npos) {
+            error = "Zip end of central directory not found";
+            return false;
+        }
+        uint64_t count = le16(&buf[eocd + 10]);
+        uint64_t dir_size = le32(&buf[eocd + 12]);
+        uint64_t dir_offset = le32(&buf[eocd + 16]);
+        // zip64：定位记录紧挨在结束记录之前
+        if (eocd >= 20 && le32(&buf[eocd - 20]) == 0x07064b50) {
+            uint64_t z64_offset = le64(&buf[eocd - 20 + 8]);
+            unsigned char z64[56];
+            file.seekg(static_cast<std::streamoff>(z64_offset));
+            if (file.read(reinterpret_cast<char*>(z64), sizeof(z64)) && le32(z64) == 0x06064b50) {
+                count = le64(z64 + 32);
+                dir_size = le64(z64 + 40);
+                dir_offset = le64(z64 + 48);
+            }
+        }
+        if (dir_offset + dir_size > file_size) {
+            error = "Corrupted zip central directory";
+            return false;
+        }
+
+        std::vector<unsigned char> dir(static_cast<size_t>(dir_size));
+        file.seekg(static_cast<std::streamoff>(dir_offset));
+        if (!file.read(reinterpret_cast<char*>(dir.data()), static_cast<std::streamsize>(dir_size))) {
+            error = "Failed to read zip central directory";
+            return false;
+        }
+        out.reserve(static_cast<size_t>(std::min<uint64_t>(count, dir_size / 46)));
+        for (size_t pos = 0; pos + 46 <= dir.size() && le32(&dir[pos]) == 0x02014b50;) {
+            const unsigned char* h = &dir[pos];
+            uint16_t name_len = le16(h + 28);
+            uint16_t extra_len = le16(h + 30);
+            uint16_t comment_len = le16(h + 32);
+            if (pos + 46 + name_len + extra_len + comment_len > dir.size()) break;
+            ZipEntry z;
+            z.method = le16(h + 10);
+            z.entry.crc32 = le32(h + 16);
+            z.entry.crc_known = true;
+            z.compressed = le32(h + 20);
+            z.entry.size = le32(h + 24);
+            z.local_offset = le32(h + 42);
+            z.entry.mtime = dos_time_ms(le16(h + 14), le16(h + 12));
+            std::string name(reinterpret_cast<const char*>(h + 46), name_len);
+            // zip64扩展字段：按顺序只包含值为0xFFFFFFFF的字段
+            // 子字段声明的长度不可信，越过扩展字段区的子字段及其后内容一律忽略
+            const unsigned char* extra_end = h + 46 + name_len + extra_len;
+            for (const unsigned char* e = h + 46 + name_len; extra_end - e >= 4;) {
+                uint16_t id = le16(e);
+                uint16_t len = le16(e + 2);
+                if (extra_end - (e + 4) < len) break;
+                if (id == 0x0001) {
+                    const unsigned char* v = e + 4;
+                    const unsigned char* end = v + len;
+                    if (le32(h + 24) == 0xFFFFFFFF && end - v >= 8) { z.entry.size = le64(v); v += 8; }
+                    if (le32(h + 20) == 0xFFFFFFFF && end - v >= 8) { z.compressed = le64(v); v += 8; }
+                    if (le32(h + 42) == 0xFFFFFFFF && end - v >= 8) { z.local_offset = le64(v); v += 8; }
+                }
+                e += 4 + len;
+            }
+            z.entry.path = clean_path(name, z.entry.is_dir);
+            if (z.entry.is_dir) z.entry.size = 0;
+            if (!z.entry.path.empty()) out.push_back(std::move(z));
+            pos += 46 + name_len + extra_len + comment_len;
+        }
+        return true;
+    }
+
+    // zip条目内容：stored直接读取，deflate按raw流解压；其他压缩方法读不出内容
+    class ZipMemberInput : public Input {
+    public:
+        ZipMemberInput(std::ifstream& file, const ZipEntry& z) : file(file), method(z.method), left_in(z.compressed) {
+            unsigned char local[30];
+            file.clear();
+            file.seekg(static_cast<std::streamoff>(z.local_offset));
+            if (!file.read(reinterpret_cast<char*>(local), sizeof(local)) || le32(local) != 0x04034b50) {
+                throw std::runtime_error("Corrupted zip local header: " + z.entry.path);
+            }
+            file.seekg(le16(local + 26) + le16(local + 28), std::ios::cur);
+            left_out = z.entry.size;
+            if (method == 8) {
+                std::memset(&zs, 0, sizeof(zs));
+                if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) throw std::runtime_error("inflateInit failed");
+                inflating = true;
+            }
+        }
+        ~ZipMemberInput() override {
+            if (inflating) inflateEnd(&zs);
+        }
+
+        size_t read(char* buf, size_t len) override {
+            len = static_cast<size_t>(std::min<uint64_t>(len, left_out));
+            if (len == 0) return 0;
+            size_t n = 0;
+            if (method == 0) {
+                file.read(buf, static_cast<std::streamsize>(len));
+                n = static_cast<size_t>(file.gcount());
+            } else if (method == 8) {
+                zs.next_out = reinterpret_cast<Bytef*>(buf);
+                zs.avail_out = static_cast<uInt>(std::min<size_t>(len, 1u << 30));
+                while (zs.avail_out > 0) {
+                    if (zs.avail_in == 0) {
+                        size_t want = static_cast<size_t>(std::min<uint64_t>(in.size(), left_in));
+                        if (want == 0) break;
+                        file.read(in.data(), static_cast<std::streamsize>(want));
+                        size_t got = static_cast<size_t>(file.gcount());
+                        if (got == 0) break;
+                        left_in -= got;
+                        zs.next_in = reinterpret_cast<Bytef*>(in.data());
+                        zs.avail_in = static_cast<uInt>(got);
+                    }
+                    int rc = inflate(&zs, Z_NO_FLUSH);
+                    if (rc == Z_STREAM_END) break;
+                    if (rc != Z_OK && rc != Z_BUF_ERROR) throw std::runtime_error("Corrupted zip deflate stream");
+                }
+                n = len - zs.avail_out;
+            }
+            left_out -= n;
+            return n;
+        }
+
+    private:
+        std::ifstream& file;
+        uint16_t method;
+        uint64_t left_in;
+        uint64_t left_out = 0;
+        z_stream zs;
+        bool inflating = false;
+        std::vector<char> in = std::vector<char>(64 * 1024);
+    };
+
+    // only非空时只访问该条目
+    static bool read_zip(const std::string& path, const Visitor& visit, const std::string* only, std::string& error) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            error = "Failed to open file: " + path;
+            return false;
+        }
+        std::vector<ZipEntry> entries;
+        if (!zip_directory(file, entries, error)) return false;
+        for (const ZipEntry& z : entries) {
+            if (only && z.entry.path != *only) continue;
+            bool keep_going;
+            if (z.entry.is_dir) {
+                keep_going = visit(z.entry, [](char*, size_t) -> size_t { return 0; });
+            } else {
+                ZipMemberInput in(file, z);
+                keep_going = visit(z.entry, [&](char* buf, size_t len) { return in.read(buf, len); });
+            }
+            if (!keep_going) break;
+        }
+        return true;
+    }
+
+    // 按包内路径访问单个条目：zip直接定位，tar/gz顺序查找
+    static bool visit_member(const std::string& path, const std::string& member,
+                             const std::function<void(const ArchiveEntry&, const ContentReader&)>& fn,
+                             std::string& error) {
+        Visitor visit = [&](const ArchiveEntry& entry, const ContentReader& read) {
+            if (entry.is_dir || entry.path != member) return true;
+            fn(entry, read);
+            return false;
+        };
+        try {
+            if (detect(path) == ArchiveFormat::Zip) return read_zip(path, visit, &member, error);
+        } catch (const std::exception& e) {
+            error = "Failed to read archive " + path + ": " + exception_to_string(e);
+            return false;
+        }
+        return for_each(path, visit, error);
+    }
+};
+
+#endif // ARCHIVE_READER_H
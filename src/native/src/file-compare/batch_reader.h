@@ -0,0 +1,407 @@
+#ifndef BATCH_READER_H
+#define BATCH_READER_H
+
+#include "utils.h"
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cerrno>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+// 批量读取的单个文件
+struct FileBlob {
+    fs::path path;
+    uint64_t size = 0;
+    std::string data;        // 文件内容（loaded为true时有效）
+    bool loaded = false;     // 超过max_size的文件只取大小，由调用方流式处理
+    int error = 0;           // errno，非0表示该文件失败
+};
+
+// 批量文件读取引擎
+// Linux下使用io_uring：一批文件的openat/statx、read、close各用一次提交完成，
+// 小文件读入预先注册的固定缓冲区（READ_FIXED），少量线程即可维持深队列；
+// io_uring不可用（旧内核、seccomp禁止、非Linux）时透明退化为open/fstat/pread
+class BatchFileReader {
+public:
+    explicit BatchFileReader(unsigned depth = 64) : depth(depth == 0 ? 1 : depth) {
+#ifdef __linux__
+        uring_ok = uring_setup();
+#endif
+    }
+
+    ~BatchFileReader() {
+#ifdef __linux__
+        uring_teardown();
+#endif
+    }
+
+    BatchFileReader(const BatchFileReader&) = delete;
+    BatchFileReader& operator=(const BatchFileReader&) = delete;
+
+    // 单批最多处理的文件数
+    unsigned batch_size() const { return depth; }
+
+    // 当前系统是否可用io_uring（进程内只探测一次）
+    static bool uring_supported() {
+#ifdef __linux__
+        static const bool supported = BatchFileReader(1).uring_enabled();
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    bool uring_enabled() const {
+#ifdef __linux__
+        return uring_ok;
+#else
+        return false;
+#endif
+    }
+
+    // 读取一批文件：不超过max_size的文件完整读入data，其余只填size
+    void read_batch(std::vector<FileBlob>& batch, uint64_t max_size) {
+        size_t begin = 0;
+        while (begin < batch.size()) {
+            size_t end = std::min<size_t>(batch.size(), begin + depth);
+#ifdef __linux__
+            if (uring_ok && uring_read(batch, begin, end, max_size)) {
+                begin = end;
+                continue;
+            }
+#endif
+            for (size_t i = begin; i < end; ++i) {
+                read_one(batch[i], max_size);
+            }
+            begin = end;
+        }
+    }
+
+    // 单文件读取（pread路径）
+    static void read_one(FileBlob& blob, uint64_t max_size) {
+        blob.loaded = false;
+        blob.error = 0;
+#ifdef _WIN32
+        std::error_code ec;
+        blob.size = fs::file_size(blob.path, ec);
+        if (ec) { blob.error = ec.value(); return; }
+        if (blob.size > max_size) return;
+        std::ifstream file(blob.path, std::ios::binary);
+        if (!file.is_open()) { blob.error = EACCES; return; }
+        blob.data.resize(static_cast<size_t>(blob.size));
+        file.read(&blob.data[0], static_cast<std::streamsize>(blob.size));
+        blob.data.resize(static_cast<size_t>(file.gcount()));
+        blob.loaded = true;
+#else
+        int fd = ::open(blob.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) { blob.error = errno; return; }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            blob.error = errno;
+            ::close(fd);
+            return;
+        }
+        blob.size = static_cast<uint64_t>(st.st_size);
+        if (blob.size <= max_size) {
+            blob.data.resize(static_cast<size_t>(blob.size));
+            blob.error = pread_full(fd, &blob.data[0], blob.data.size(), 0, blob.data);
+            blob.loaded = blob.error == 0;
+        }
+        ::close(fd);
+#endif
+    }
+
+private:
+#ifndef _WIN32
+    // 读满len字节（遇到EOF则截断data），返回errno
+    static int pread_full(int fd, char* buf, size_t len, size_t done, std::string& data) {
+        while (done < len) {
+            ssize_t n = ::pread(fd, buf + done, len - done, static_cast<off_t>(done));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return errno;
+            }
+            if (n == 0) break;
+            done += static_cast<size_t>(n);
+        }
+        data.resize(done);
+        return 0;
+    }
+#endif
+
+#ifdef __linux__
+    // 固定缓冲区：每个批次槽位一块
+    static constexpr size_t kFixedSlotSize = 64 * 1024;
+
+    enum Op : uint64_t { OP_OPEN = 0, OP_STATX = 1, OP_READ = 2, OP_CLOSE = 3 };
+
+    static uint64_t tag(size_t index, Op op) { return (static_cast<uint64_t>(index) << 2) | op; }
+
+    bool uring_setup() {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        // 每个文件在第一阶段占用两个SQE（openat + statx）
+        ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, depth * 2, &params));
+        if (ring_fd < 0) return false;
+
+        if (!probe_ops()) return fail_setup();
+
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+        }
+        sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        if (sq_ring == MAP_FAILED) { sq_ring = nullptr; return fail_setup(); }
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            cq_ring = sq_ring;
+        } else {
+            cq_ring = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+            if (cq_ring == MAP_FAILED) { cq_ring = nullptr; return fail_setup(); }
+        }
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) { sqes = nullptr; return fail_setup(); }
+
+        char* sq = static_cast<char*>(sq_ring);
+        char* cq = static_cast<char*>(cq_ring);
+        sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sq_entries = params.sq_entries;
+        cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // 注册固定缓冲区：depth个槽位连续分配，作为一个iovec注册
+        fixed_size = kFixedSlotSize * depth;
+        fixed_buf = mmap(nullptr, fixed_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (fixed_buf == MAP_FAILED) { fixed_buf = nullptr; return fail_setup(); }
+        iovec iov{fixed_buf, fixed_size};
+        fixed_registered = syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_BUFFERS, &iov, 1) == 0;
+        return true;
+    }
+
+    // 检查内核是否支持所需操作码（openat/statx/read/close需5.6+）
+    bool probe_ops() {
+        const size_t ops = IORING_OP_LAST;
+        std::vector<char> mem(sizeof(io_uring_probe) + ops * sizeof(io_uring_probe_op), 0);
+        auto* probe = reinterpret_cast<io_uring_probe*>(mem.data());
+        if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, ops) < 0) return false;
+        for (int op : {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_READ_FIXED, IORING_OP_CLOSE}) {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) return false;
+        }
+        return true;
+    }
+
+    bool fail_setup() {
+        uring_teardown();
+        return false;
+    }
+
+    void uring_teardown() {
+        if (fixed_buf) munmap(fixed_buf, fixed_size);
+        if (sqes) munmap(sqes, sqes_size);
+        if (cq_ring && cq_ring != sq_ring) munmap(cq_ring, cq_ring_size);
+        if (sq_ring) munmap(sq_ring, sq_ring_size);
+        if (ring_fd >= 0) ::close(ring_fd);
+        fixed_buf = nullptr;
+        sqes = nullptr;
+        cq_ring = sq_ring = nullptr;
+        ring_fd = -1;
+        uring_ok = false;
+    }
+
+    io_uring_sqe* next_sqe() {
+        unsigned head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+        if (sq_local_tail - head >= sq_entries) return nullptr;
+        unsigned idx = sq_local_tail & sq_mask;
+        io_uring_sqe* sqe = &sqes[idx];
+        memset(sqe, 0, sizeof(*sqe));
+        sq_array[idx] = idx;
+        ++sq_local_tail;
+        ++to_submit;
+        return sqe;
+    }
+
+    // 提交并等待wait_nr个完成事件，逐个回调处理
+    template<class F>
+    bool submit_and_reap(unsigned wait_nr, F&& on_cqe) {
+        __atomic_store_n(sq_tail, sq_local_tail, __ATOMIC_RELEASE);
+        unsigned reaped = 0;
+        while (reaped < wait_nr) {
+            unsigned submit = to_submit;
+            int ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, submit, wait_nr - reaped, IORING_ENTER_GETEVENTS, nullptr, 0));
+            if (ret < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            to_submit -= std::min<unsigned>(to_submit, static_cast<unsigned>(ret));
+            unsigned head = *cq_head;
+            unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+            while (head != tail) {
+                const io_uring_cqe& cqe = cqes[head & cq_mask];
+                on_cqe(cqe.user_data, cqe.res);
+                ++head;
+                ++reaped;
+            }
+            __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        }
+        return true;
+    }
+
+    // io_uring批量读取[begin, end)，环异常时返回false由调用方走pread
+    bool uring_read(std::vector<FileBlob>& batch, size_t begin, size_t end, uint64_t max_size) {
+        const size_t n = end - begin;
+        std::vector<int> fds(n, -1);
+        std::vector<struct statx> stx(n);
+        std::vector<std::string> paths(n);
+
+        // 阶段1：openat + statx
+        for (size_t i = 0; i < n; ++i) {
+            FileBlob& blob = batch[begin + i];
+            blob.loaded = false;
+            blob.error = 0;
+            paths[i] = blob.path.string();
+
+            io_uring_sqe* open_sqe = next_sqe();
+            open_sqe->opcode = IORING_OP_OPENAT;
+            open_sqe->fd = AT_FDCWD;
+            open_sqe->addr = reinterpret_cast<uint64_t>(paths[i].c_str());
+            open_sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            open_sqe->user_data = tag(i, OP_OPEN);
+
+            io_uring_sqe* statx_sqe = next_sqe();
+            statx_sqe->opcode = IORING_OP_STATX;
+            statx_sqe->fd = AT_FDCWD;
+            statx_sqe->addr = reinterpret_cast<uint64_t>(paths[i].c_str());
+            statx_sqe->len = STATX_SIZE;
+            statx_sqe->off = reinterpret_cast<uint64_t>(&stx[i]);
+            statx_sqe->user_data = tag(i, OP_STATX);
+        }
+        bool ok = submit_and_reap(static_cast<unsigned>(n * 2), [&](uint64_t user_data, int res) {
+            size_t i = static_cast<size_t>(user_data >> 2);
+            FileBlob& blob = batch[begin + i];
+            if (res < 0) {
+                if (!blob.error) blob.error = -res;
+            } else if ((user_data & 3) == OP_OPEN) {
+                fds[i] = res;
+            } else {
+                blob.size = stx[i].stx_size;
+            }
+        });
+        if (!ok) return close_and_fail(fds);
+
+        // 阶段2：读取小文件，不超过槽位大小的走固定缓冲区
+        unsigned reads = 0;
+        for (size_t i = 0; i < n; ++i) {
+            FileBlob& blob = batch[begin + i];
+            if (blob.error || fds[i] < 0 || blob.size > max_size) continue;
+            io_uring_sqe* sqe = next_sqe();
+            sqe->fd = fds[i];
+            sqe->off = 0;
+            sqe->user_data = tag(i, OP_READ);
+            if (fixed_registered && blob.size <= kFixedSlotSize) {
+                sqe->opcode = IORING_OP_READ_FIXED;
+                sqe->addr = reinterpret_cast<uint64_t>(static_cast<char*>(fixed_buf) + i * kFixedSlotSize);
+                sqe->len = static_cast<uint32_t>(blob.size);
+                sqe->buf_index = 0;
+            } else {
+                blob.data.resize(static_cast<size_t>(blob.size));
+                sqe->opcode = IORING_OP_READ;
+                sqe->addr = reinterpret_cast<uint64_t>(blob.data.data());
+                sqe->len = static_cast<uint32_t>(blob.size);
+            }
+            ++reads;
+        }
+        if (reads > 0) {
+            ok = submit_and_reap(reads, [&](uint64_t user_data, int res) {
+                size_t i = static_cast<size_t>(user_data >> 2);
+                FileBlob& blob = batch[begin + i];
+                if (res < 0) {
+                    blob.error = -res;
+                    return;
+                }
+                size_t got = static_cast<size_t>(res);
+                if (fixed_registered && blob.size <= kFixedSlotSize) {
+                    blob.data.assign(static_cast<char*>(fixed_buf) + i * kFixedSlotSize, got);
+                } else {
+                    blob.data.resize(std::max<size_t>(got, blob.data.size()));
+                }
+                // 短读（文件读取期间被修改等）用pread补齐
+                if (got < blob.size) {
+                    blob.data.resize(static_cast<size_t>(blob.size));
+                    blob.error = pread_full(fds[i], &blob.data[0], blob.data.size(), got, blob.data);
+                }
+                blob.loaded = blob.error == 0;
+            });
+            if (!ok) return close_and_fail(fds);
+        }
+
+        // 阶段3：批量关闭
+        unsigned closes = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (fds[i] < 0) continue;
+            io_uring_sqe* sqe = next_sqe();
+            sqe->opcode = IORING_OP_CLOSE;
+            sqe->fd = fds[i];
+            sqe->user_data = tag(i, OP_CLOSE);
+            fds[i] = -1;
+            ++closes;
+        }
+        if (closes > 0) {
+            submit_and_reap(closes, [](uint64_t, int) {});
+        }
+        return true;
+    }
+
+    // 环出错：关闭已打开的文件并永久退化到pread
+    bool close_and_fail(std::vector<int>& fds) {
+        for (int& fd : fds) {
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+        }
+        uring_teardown();
+        return false;
+    }
+
+    bool uring_ok = false;
+    int ring_fd = -1;
+    void* sq_ring = nullptr;
+    void* cq_ring = nullptr;
+    size_t sq_ring_size = 0;
+    size_t cq_ring_size = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqes_size = 0;
+    unsigned* sq_head = nullptr;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned sq_mask = 0;
+    unsigned sq_entries = 0;
+    unsigned sq_local_tail = 0;
+    unsigned to_submit = 0;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned cq_mask = 0;
+    io_uring_cqe* cqes = nullptr;
+    void* fixed_buf = nullptr;
+    size_t fixed_size = 0;
+    bool fixed_registered = false;
+#endif
+
+    unsigned depth;
+};
+
+#endif // BATCH_READER_H
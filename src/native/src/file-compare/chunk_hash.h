@@ -0,0 +1,181 @@
+#ifndef CHUNK_HASH_H
+#define CHUNK_HASH_H
+
+#include "utils.h"
+#include "thread_pool.h"
+#include <vector>
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <cerrno>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// 大文件分块哈希
+// 文件按固定大小切块，各块CRC32由线程池并行计算（每块独立pread），再用crc32_combine按顺序合成：
+// 合成结果与顺序计算的整文件CRC完全一致，可与小文件、快照中的CRC直接比较；
+// 各块CRC保留下来，二进制对比可直接定位不同区域而无需重新读取
+struct ChunkedHash {
+    static constexpr uint64_t kDefaultChunkSize = 8 * 1024 * 1024;
+
+    uint64_t size = 0;
+    uint64_t chunk_size = kDefaultChunkSize;
+    uint32_t crc32 = 0;
+    TextEncoding encoding = TextEncoding::Binary; // 按文件头样本判断
+    std::vector<uint32_t> chunks;
+
+    // 与classify_file一致的分类结果
+    FileClassification classification() const {
+        FileClassification cls;
+        cls.size = size;
+        cls.crc32 = crc32;
+        cls.encoding = encoding;
+        cls.is_text = encoding != TextEncoding::Binary;
+        return cls;
+    }
+
+    // 与另一份哈希（相同块大小）对比，返回内容不同的字节区间[begin, end)，相邻块合并
+    std::vector<std::pair<uint64_t, uint64_t>> diff_ranges(const ChunkedHash& other) const {
+        std::vector<std::pair<uint64_t, uint64_t>> ranges;
+        auto add = [&](uint64_t begin, uint64_t end) {
+            if (!ranges.empty() && ranges.back().second == begin) {
+                ranges.back().second = end;
+            } else {
+                ranges.emplace_back(begin, end);
+            }
+        };
+        const uint64_t common = std::min(size, other.size);
+        for (size_t i = 0; i < std::min(chunks.size(), other.chunks.size()); ++i) {
+            uint64_t begin = i * chunk_size;
+            uint64_t end = std::min(begin + chunk_size, common);
+            // 末块长度不同（文件大小不同）时CRC不可比，按不同处理
+            bool same_len = std::min(begin + chunk_size, size) == std::min(begin + chunk_size, other.size);
+            if (chunks[i] != other.chunks[i] || !same_len) add(begin, end);
+        }
+        if (size != other.size) add(common, std::max(size, other.size));
+        return ranges;
+    }
+};
+
+// 超过该大小的文件才分块并行计算，更小的文件顺序读取即可
+constexpr uint64_t kChunkedHashThreshold = 64 * 1024 * 1024;
+
+// 分块并行计算文件哈希（块0同时完成文本/编码判断），调用方等待期间协助执行
+// 块任务按priority排队：交互对比的块不排在已排队的扫描任务之后
+inline bool hash_file_chunked(const std::string& path, ThreadPool& pool, ChunkedHash& out,
+                              uint64_t chunk_size = ChunkedHash::kDefaultChunkSize,
+                              const CancelToken& token = CancelToken(),
+                              TaskPriority priority = TaskPriority::Background) {
+    std::error_code ec;
+    const uint64_t size = fs::file_size(path, ec);
+    if (ec) return false;
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+#endif
+
+    ChunkedHash hash;
+    hash.size = size;
+    hash.chunk_size = chunk_size;
+    hash.chunks.assign(static_cast<size_t>((size + chunk_size - 1) / chunk_size), 0);
+    std::vector<uint64_t> chunk_len(hash.chunks.size(), 0);
+    ContentClassifier head;
+    std::atomic<bool> failed{false};
+
+    {
+        TaskGroup group(pool, priority, token);
+        for (size_t i = 0; i < hash.chunks.size(); ++i) {
+            group.run([&, i]() {
+                const uint64_t begin = i * chunk_size;
+                const uint64_t end = std::min(begin + chunk_size, size);
+                std::vector<char> buf(256 * 1024);
+                uint32_t crc = 0;
+                uint64_t offset = begin;
+#ifdef _WIN32
+                std::ifstream file(path, std::ios::binary);
+                file.seekg(static_cast<std::streamoff>(begin));
+#endif
+                while (offset < end && !failed.load(std::memory_order_relaxed) && !token.cancelled()) {
+                    size_t want = static_cast<size_t>(std::min<uint64_t>(buf.size(), end - offset));
+#ifdef _WIN32
+                    file.read(buf.data(), static_cast<std::streamsize>(want));
+                    int64_t n = static_cast<int64_t>(file.gcount());
+#else
+                    int64_t n = ::pread(fd, buf.data(), want, static_cast<off_t>(offset));
+                    if (n < 0 && errno == EINTR) continue;
+#endif
+                    if (n <= 0) break; // 读取失败或文件被截断
+                    if (i == 0 && offset < ContentClassifier::kSampleSize) {
+                        head.update(buf.data(), std::min<size_t>(static_cast<size_t>(n), ContentClassifier::kSampleSize - offset));
+                    }
+                    crc = crc32_update(crc, buf.data(), static_cast<size_t>(n));
+                    offset += static_cast<uint64_t>(n);
+                }
+                if (offset != end) failed = true;
+                hash.chunks[i] = crc;
+                chunk_len[i] = offset - begin;
+            });
+        }
+        group.wait();
+    }
+#ifndef _WIN32
+    ::close(fd);
+#endif
+    if (failed || token.cancelled()) return false;
+
+    uint32_t crc = 0;
+    for (size_t i = 0; i < hash.chunks.size(); ++i) {
+        crc = static_cast<uint32_t>(::crc32_combine(crc, hash.chunks[i], static_cast<z_off_t>(chunk_len[i])));
+    }
+    hash.crc32 = crc;
+    hash.encoding = head.finish().encoding;
+    out = std::move(hash);
+    return true;
+}
+
+// 分块哈希缓存：按路径保存，大小或修改时间变化即失效；超出容量时淘汰最早加入的条目
+class ChunkHashCache {
+public:
+    explicit ChunkHashCache(size_t capacity = 4096) : capacity(capacity) {}
+
+    bool get(const std::string& path, uint64_t size, int64_t mtime, uint64_t chunk_size, ChunkedHash& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(path);
+        if (it == entries.end() || it->second.size != size || it->second.mtime != mtime ||
+            it->second.hash.chunk_size != chunk_size) {
+            return false;
+        }
+        out = it->second.hash;
+        return true;
+    }
+
+    void put(const std::string& path, int64_t mtime, const ChunkedHash& hash) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(path);
+        if (it == entries.end()) {
+            order.push_back(path);
+            while (order.size() > capacity) {
+                entries.erase(order.front());
+                order.pop_front();
+            }
+        }
+        entries[path] = Entry{hash.size, mtime, hash};
+    }
+
+private:
+    struct Entry {
+        uint64_t size;
+        int64_t mtime;
+        ChunkedHash hash;
+    };
+
+    size_t capacity;
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    std::deque<std::string> order;
+};
+
+#endif // CHUNK_HASH_H
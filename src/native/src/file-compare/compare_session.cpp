@@ -0,0 +1,375 @@
+#include "compare_session.h"
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+#include <cstring>
+
+namespace {
+
+#ifdef __linux__
+// 目录监听的事件：属性变化（touch）不影响内容，不监听
+constexpr uint32_t kWatchMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO |
+                                IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+#endif
+// 事件静默该时长后处理一批；持续有事件时最长延迟kMaxLatencyMs
+constexpr int kDebounceMs = 10;
+constexpr int kMaxLatencyMs = 100;
+
+} // namespace
+
+CompareSession::CompareSession(FileCompare& compare, const std::string& folder_a, const std::string& folder_b,
+                               bool ignore_hidden, const IgnoreOptions& ignore)
+    : compare(compare), ignore_hidden(ignore_hidden), ignore(ignore) {
+    const std::string folders[2] = {folder_a, folder_b};
+    for (int side = 0; side < 2; ++side) {
+        fs::path root = fs::path(normalize_path(folders[side])).lexically_normal();
+        if (!root.has_filename() && root.has_relative_path()) root = root.parent_path();
+        if (!fs::is_directory(root)) {
+            throw std::runtime_error("Invalid folder path: " + folders[side]);
+        }
+        roots[side] = root;
+    }
+}
+
+CompareSession::~CompareSession() {
+    stop();
+}
+
+SortedDiffStats CompareSession::start(const Sink& delta_sink) {
+#ifndef __linux__
+    (void)delta_sink;
+    throw std::runtime_error("Live folder compare is only supported on Linux (inotify)");
+#else
+    sink = delta_sink;
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inotify_fd < 0 || wake_fd < 0) {
+        throw std::runtime_error("Failed to initialize inotify: " + std::string(strerror(errno)));
+    }
+
+    // 根目录先建立监听；其余目录在初始对比分批输出时随即加入，缩短漏事件的窗口
+    add_watch(0, std::string());
+    add_watch(1, std::string());
+    SortedDiffStats stats = compare.compare_folders_sorted(roots[0].string(), roots[1].string(), ignore_hidden,
+                                                           [this](std::vector<SortedDiffEntry>& batch)
+    {
+        for (const SortedDiffEntry& e : batch) {
+            std::string rel = e.rel_path;
+            std::replace(rel.begin(), rel.end(), static_cast<char>(fs::path::preferred_separator), '/');
+            State& st = states[rel];
+            const bool has_a = e.status != EntryStatus::Added;
+            const bool has_b = e.status != EntryStatus::Deleted;
+            // 同大小文件对在对比时已计算CRC；读取失败时两侧CRC都为0且状态为Modified，不能沿用
+            const bool hashed = !e.is_dir && has_a && has_b && e.size_a == e.size_b &&
+                                !(e.status == EntryStatus::Modified && e.crc_a == e.crc_b);
+            if (has_a) st.a = Side{true, e.is_dir, hashed, e.size_a, e.mtime_a, e.crc_a};
+            if (has_b) st.b = Side{true, e.is_dir, hashed, e.size_b, e.mtime_b, e.crc_b};
+            st.status = st.a.exists && st.b.exists && st.a.is_dir != st.b.is_dir ? EntryStatus::Modified : e.status;
+            if (e.is_dir) {
+                if (has_a) add_watch(0, rel);
+                if (has_b) add_watch(1, rel);
+            }
+        }
+        CompareDelta delta;
+        delta.initial = true;
+        delta.changed.swap(batch);
+        sink(delta);
+    }, ignore);
+    if (!stats.error.empty()) {
+        throw std::runtime_error(stats.error);
+    }
+    worker = std::thread(&CompareSession::run, this);
+    return stats;
+#endif
+}
+
+void CompareSession::stop() {
+#ifdef __linux__
+    stopping = true;
+    if (worker.joinable()) {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wake_fd, &one, sizeof(one));
+        (void)ignored;
+        worker.join();
+    }
+    if (inotify_fd >= 0) ::close(inotify_fd);
+    if (wake_fd >= 0) ::close(wake_fd);
+    inotify_fd = -1;
+    wake_fd = -1;
+#endif
+}
+
+// 事件循环：收集被触及的路径，静默kDebounceMs（或累计kMaxLatencyMs）后统一处理并推送增量
+void CompareSession::run() {
+#ifdef __linux__
+    std::unordered_set<std::string> touched;
+    std::unordered_set<std::string> rescans;
+    bool overflow = false;
+    bool pending = false;
+    auto first_event = std::chrono::steady_clock::now();
+    alignas(struct inotify_event) char buf[64 * 1024];
+
+    while (!stopping) {
+        struct pollfd fds[2] = {{inotify_fd, POLLIN, 0}, {wake_fd, POLLIN, 0}};
+        int ready = ::poll(fds, 2, pending ? kDebounceMs : -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            for (;;) {
+                ssize_t n = ::read(inotify_fd, buf, sizeof(buf));
+                if (n <= 0) break;
+                for (char* p = buf; p < buf + n;) {
+                    const struct inotify_event* ev = reinterpret_cast<const struct inotify_event*>(p);
+                    p += sizeof(struct inotify_event) + ev->len;
+                    if (ev->mask & IN_Q_OVERFLOW) {
+                        overflow = true;
+                        continue;
+                    }
+                    auto it = watches.find(ev->wd);
+                    if (it == watches.end()) continue;
+                    const std::string rel_dir = it->second.second;
+                    if (ev->mask & IN_IGNORED) {
+                        watches.erase(it);
+                        watch_count = watches.size();
+                        continue;
+                    }
+                    if (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                        rescans.insert(rel_dir);
+                        continue;
+                    }
+                    if (ev->len == 0) continue;
+                    std::string rel = IgnoreMatcher::join(rel_dir, ev->name);
+                    if (ev->mask & IN_ISDIR) {
+                        rescans.insert(std::move(rel)); // 目录新建/删除/移动：按子树重扫
+                    } else {
+                        touched.insert(std::move(rel));
+                    }
+                }
+            }
+            if (!pending) first_event = std::chrono::steady_clock::now();
+            pending = true;
+            auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - first_event);
+            if (waited.count() < kMaxLatencyMs) continue;
+        }
+        if (!pending) continue;
+
+        CompareDelta delta;
+        try {
+            if (overflow) {
+                rescan(std::string(), delta); // 事件丢失，无法确定范围，整体重扫
+            } else {
+                // 外层目录的重扫已覆盖其子树
+                std::vector<std::string> dirs(rescans.begin(), rescans.end());
+                std::sort(dirs.begin(), dirs.end());
+                std::vector<std::string> roots_done;
+                for (const auto& dir : dirs) {
+                    if (!roots_done.empty() && within(dir, roots_done.back())) continue;
+                    rescan(dir, delta);
+                    roots_done.push_back(dir);
+                }
+                for (const auto& rel : touched) {
+                    bool covered = std::any_of(roots_done.begin(), roots_done.end(),
+                                               [&](const std::string& dir) { return within(rel, dir); });
+                    if (!covered) refresh(rel, delta);
+                }
+            }
+        } catch (...) {
+            // 单次处理失败不结束会话，后续事件会再次触及相关路径
+        }
+        touched.clear();
+        rescans.clear();
+        overflow = false;
+        pending = false;
+        if (delta.changed.empty() && delta.removed.empty()) continue;
+        std::sort(delta.changed.begin(), delta.changed.end(),
+                  [](const SortedDiffEntry& x, const SortedDiffEntry& y) { return x.rel_path < y.rel_path; });
+        std::sort(delta.removed.begin(), delta.removed.end());
+        sink(delta);
+    }
+#endif
+}
+
+fs::path CompareSession::side_path(int side, const std::string& rel) const {
+    return rel.empty() ? roots[side] : roots[side] / rel;
+}
+
+// rel是否为dir本身或其子路径（dir为空表示根目录）
+bool CompareSession::within(const std::string& rel, const std::string& dir) {
+    return dir.empty() || (rel.size() >= dir.size() && rel.compare(0, dir.size(), dir) == 0 &&
+                           (rel.size() == dir.size() || rel[dir.size()] == '/'));
+}
+
+// 对同一inode重复添加会返回已有的wd，借此在目录移动后更新其相对路径
+void CompareSession::add_watch(int side, const std::string& rel_dir) {
+#ifdef __linux__
+    int wd = inotify_add_watch(inotify_fd, side_path(side, rel_dir).c_str(), kWatchMask);
+    if (wd < 0) return; // 超出max_user_watches等，该目录只能依赖上级目录事件与重扫
+    watches[wd] = std::make_pair(side, rel_dir);
+    watch_count = watches.size();
+#else
+    (void)side;
+    (void)rel_dir;
+#endif
+}
+
+// 子树重扫：两侧从根有序遍历，只进入rel_dir的祖先与其子树（忽略规则与.gitignore层级保持一致）
+void CompareSession::rescan(const std::string& rel_dir, CompareDelta& delta) {
+    std::unordered_map<std::string, std::pair<Side, Side>> found;
+    for (int side = 0; side < 2; ++side) {
+        IgnoreMatcher matcher(ignore);
+        SortedDirWalker walker(roots[side], ignore_hidden, &matcher);
+        if (rel_dir.empty()) add_watch(side, std::string());
+        while (walker.next()) {
+            std::string rel = walker.rel_path('/');
+            if (!within(rel, rel_dir)) {
+                if (!(walker.is_dir() && within(rel_dir, rel))) walker.skip_children();
+                continue;
+            }
+            Side s{true, walker.is_dir(), false, walker.size(), walker.mtime(), 0};
+            (side == 0 ? found[rel].first : found[rel].second) = s;
+            if (walker.is_dir()) add_watch(side, rel);
+        }
+    }
+
+    // 子树中已不存在的目录：移除其监听（目录被移出对比范围时inode仍在，不会自动失效）
+#ifdef __linux__
+    for (auto it = watches.begin(); it != watches.end();) {
+        const auto& [side, rel] = it->second;
+        bool present = rel.empty() || (found.count(rel) && (side == 0 ? found[rel].first : found[rel].second).is_dir);
+        if (within(rel, rel_dir) && !present) {
+            inotify_rm_watch(inotify_fd, it->first);
+            it = watches.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    watch_count = watches.size();
+#endif
+
+    std::vector<std::string> gone;
+    for (const auto& [rel, state] : states) {
+        if (within(rel, rel_dir) && !found.count(rel)) gone.push_back(rel);
+    }
+    for (const auto& rel : gone) update(rel, Side(), Side(), delta);
+    for (auto& [rel, sides] : found) update(rel, sides.first, sides.second, delta);
+}
+
+// 单个路径（文件事件）重新分类；变为目录时按子树重扫
+void CompareSession::refresh(const std::string& rel, CompareDelta& delta) {
+    Side a;
+    Side b;
+    stat_side(0, rel, a);
+    stat_side(1, rel, b);
+    if (a.is_dir || b.is_dir) {
+        rescan(rel, delta);
+        return;
+    }
+    update(rel, a, b, delta);
+}
+
+bool CompareSession::stat_side(int side, const std::string& rel, Side& out) const {
+    out = Side();
+    fs::path path = side_path(side, rel);
+    std::error_code ec;
+    fs::file_status st = fs::symlink_status(path, ec);
+    if (ec || !fs::exists(st)) return false;
+    bool is_dir = fs::is_directory(st);
+    // 与遍历一致：不跟随目录符号链接，文件符号链接按目标类型判断
+    if (fs::is_symlink(st)) {
+        fs::file_status target = fs::status(path, ec);
+        if (ec || !fs::is_regular_file(target)) return false;
+    } else if (!is_dir && !fs::is_regular_file(st)) {
+        return false;
+    }
+    if (is_ignored(side, rel, is_dir)) return false;
+    if (!stat_entry(path, out.size, out.mtime)) return false;
+    out.exists = true;
+    out.is_dir = is_dir;
+    if (is_dir) out.size = 0;
+    return true;
+}
+
+// 逐级进入祖先目录（加载各级.gitignore）后判断，祖先被忽略时其子项同样忽略
+bool CompareSession::is_ignored(int side, const std::string& rel, bool is_dir) const {
+    if (ignore_hidden && is_hidden_file(side_path(side, rel))) return true;
+    IgnoreMatcher matcher(ignore);
+    if (matcher.inactive()) return false;
+    matcher.enter(roots[side], std::string());
+    for (size_t pos = rel.find('/'); pos != std::string::npos; pos = rel.find('/', pos + 1)) {
+        std::string dir = rel.substr(0, pos);
+        if (matcher.ignored(dir, true)) return true;
+        matcher.enter(side_path(side, dir), dir);
+    }
+    return matcher.ignored(rel, is_dir);
+}
+
+void CompareSession::hash_side(int side, const std::string& rel, Side& s) {
+    FileClassification cls;
+    if (!compare.classify_path(side_path(side, rel).string(), cls)) return;
+    s.crc = cls.crc32;
+    s.hashed = true;
+}
+
+// 按两侧新状态重新分类，与已有状态不同则加入增量
+void CompareSession::update(const std::string& rel, Side a, Side b, CompareDelta& delta) {
+    auto it = states.find(rel);
+    const bool existed = it != states.end();
+    if (!a.exists && !b.exists) {
+        if (existed) {
+            states.erase(it);
+            delta.removed.push_back(rel);
+        }
+        return;
+    }
+
+    // 大小与修改时间未变的一侧沿用已有CRC
+    auto reuse = [](Side& now, const Side& old) {
+        if (now.exists && old.exists && old.hashed && !now.is_dir && !old.is_dir &&
+            now.size == old.size && now.mtime == old.mtime) {
+            now.crc = old.crc;
+            now.hashed = true;
+        }
+    };
+    State old = existed ? it->second : State();
+    reuse(a, old.a);
+    reuse(b, old.b);
+
+    EntryStatus status;
+    if (a.exists && b.exists) {
+        if (a.is_dir != b.is_dir) {
+            status = EntryStatus::Modified;
+        } else if (a.is_dir) {
+            status = EntryStatus::Same;
+        } else if (a.size != b.size) {
+            status = EntryStatus::Modified; // 大小不同无需读取内容
+        } else {
+            if (!a.hashed) hash_side(0, rel, a);
+            if (!b.hashed) hash_side(1, rel, b);
+            status = a.hashed && b.hashed && a.crc == b.crc ? EntryStatus::Same : EntryStatus::Modified;
+        }
+    } else {
+        status = a.exists ? EntryStatus::Deleted : EntryStatus::Added;
+    }
+
+    auto same_side = [](const Side& x, const Side& y) {
+        return x.exists == y.exists && x.is_dir == y.is_dir && x.size == y.size && x.mtime == y.mtime &&
+               (!x.hashed || !y.hashed || x.crc == y.crc);
+    };
+    bool changed = !existed || old.status != status || !same_side(a, old.a) || !same_side(b, old.b);
+    states[rel] = State{a, b, status};
+    if (!changed) return;
+
+    const bool is_dir = b.exists ? b.is_dir : a.is_dir;
+    uint32_t depth = static_cast<uint32_t>(std::count(rel.begin(), rel.end(), '/') + 1);
+    delta.changed.push_back(SortedDiffEntry{rel, depth, is_dir, status,
+                                            a.exists ? a.size : 0, b.exists ? b.size : 0,
+                                            a.exists ? a.mtime : 0, b.exists ? b.mtime : 0,
+                                            a.hashed ? a.crc : 0, b.hashed ? b.crc : 0});
+}
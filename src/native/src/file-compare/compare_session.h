@@ -0,0 +1,80 @@
+#ifndef COMPARE_SESSION_H
+#define COMPARE_SESSION_H
+
+#include "file_compare.h"
+#include <thread>
+#include <unordered_set>
+
+// 实时对比增量：changed为状态变化（或新出现）的条目，removed为两侧都已不存在的路径
+struct CompareDelta {
+    std::vector<SortedDiffEntry> changed;
+    std::vector<std::string> removed;
+    bool initial = false; // 初始全量对比的分批结果
+};
+
+// 实时文件夹对比会话（Linux inotify）
+// 初始对比后结果常驻内存，两侧所有目录加入inotify监听；事件按路径去抖合并后
+// 只重新分类被触及的路径（大小与修改时间未变的一侧沿用已有CRC），变化以增量推送。
+// 新建/移入/删除的目录与监听失败的目录按子树重新扫描，事件队列溢出时整体重新扫描。
+// 路径一侧为文件一侧为目录时合并为一条Modified（is_dir取B侧）
+class CompareSession {
+public:
+    using Sink = std::function<void(CompareDelta&)>;
+
+    CompareSession(FileCompare& compare, const std::string& folder_a, const std::string& folder_b,
+                   bool ignore_hidden, const IgnoreOptions& ignore);
+    ~CompareSession();
+
+    // 执行初始对比（结果分批交给sink）并建立监听，随后在后台线程中推送增量
+    // 失败抛出异常；非Linux平台不支持
+    SortedDiffStats start(const Sink& sink);
+    void stop();
+
+    uint64_t watched_dirs() const { return watch_count; }
+
+    CompareSession(const CompareSession&) = delete;
+    CompareSession& operator=(const CompareSession&) = delete;
+
+private:
+    struct Side {
+        bool exists = false;
+        bool is_dir = false;
+        bool hashed = false; // crc对应当前的(size, mtime)
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        uint32_t crc = 0;
+    };
+    struct State {
+        Side a;
+        Side b;
+        EntryStatus status = EntryStatus::Same;
+    };
+
+    void run();
+    void add_watch(int side, const std::string& rel_dir);
+    void rescan(const std::string& rel_dir, CompareDelta& delta);
+    void refresh(const std::string& rel, CompareDelta& delta);
+    void update(const std::string& rel, Side a, Side b, CompareDelta& delta);
+    bool stat_side(int side, const std::string& rel, Side& out) const;
+    bool is_ignored(int side, const std::string& rel, bool is_dir) const;
+    void hash_side(int side, const std::string& rel, Side& side_state);
+    fs::path side_path(int side, const std::string& rel) const;
+    static bool within(const std::string& rel, const std::string& dir);
+
+    FileCompare& compare;
+    fs::path roots[2];
+    bool ignore_hidden;
+    IgnoreOptions ignore;
+    Sink sink;
+
+    std::unordered_map<std::string, State> states; // 键为相对路径（分隔符'/'）
+    std::unordered_map<int, std::pair<int, std::string>> watches; // wd -> (侧, 相对目录)
+    std::atomic<uint64_t> watch_count{0};
+
+    int inotify_fd = -1;
+    int wake_fd = -1;
+    std::thread worker;
+    std::atomic<bool> stopping{false};
+};
+
+#endif // COMPARE_SESSION_H
@@ -1,131 +1,1249 @@
 #include "file_compare.h"
 
-FileCompare::FileCompare() : pool(ThreadPool()) {}
+FileCompare::FileCompare() : pool(ThreadPool()), io_pool(kMaxIoReaders) {}
 
-// 多线程扫描文件夹（线程池+任务计数）
-std::unordered_map<std::string, FileInfo> FileCompare::scan_folder(const std::string& folder_path, bool ignore_hidden) {
-    std::unordered_map<std::string, FileInfo> file_map;
-    std::mutex map_mutex;
-    fs::path root_path(normalize_path(folder_path));
-    std::atomic<uint64_t> task_count = 0;
+// 取消所有进行中的扫描，之后发起的扫描使用新的取消源
+void FileCompare::cancel_scans() {
+    std::lock_guard<std::mutex> lock(cancel_mutex);
+    scan_cancel.cancel();
+    scan_cancel = CancelSource();
+}
+
+CancelToken FileCompare::scan_token() {
+    std::lock_guard<std::mutex> lock(cancel_mutex);
+    return scan_cancel.token();
+}
+
+// 规范化并校验文件夹路径
+fs::path FileCompare::normalize_root(const std::string& folder_path) {
+    fs::path root_path = fs::path(normalize_path(folder_path)).lexically_normal();
+    if (!root_path.has_filename() && root_path.has_relative_path()) {
+        root_path = root_path.parent_path(); // 去掉末尾分隔符，保证相对路径可按字面计算
+    }
 
     // 检查文件夹有效性
     if (!fs::exists(root_path) || !fs::is_directory(root_path)) {
         throw std::runtime_error("Invalid folder path: " + folder_path);
     }
+    return root_path;
+}
+
+// 单文件分类：大文件分块并行哈希（CRC与顺序计算一致），块哈希留在缓存中供二进制对比复用
+bool FileCompare::classify_path(const std::string& path, FileClassification& out, const CancelToken& token,
+                                TaskPriority priority) {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    if (!stat_entry(path, size, mtime) || size < kChunkedHashThreshold) {
+        return classify_file(path, out);
+    }
+    ChunkedHash hash;
+    if (!chunked_hash(path, ChunkedHash::kDefaultChunkSize, hash, token, priority)) return false;
+    out = hash.classification();
+    return true;
+}
+
+// 取缓存的块哈希（大小与修改时间未变），否则重新计算并写入缓存
+bool FileCompare::chunked_hash(const std::string& path, uint64_t chunk_size, ChunkedHash& out, const CancelToken& token,
+                               TaskPriority priority) {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    if (!stat_entry(path, size, mtime)) return false;
+    if (chunk_cache.get(path, size, mtime, chunk_size, out)) return true;
+    if (!hash_file_chunked(path, pool, out, chunk_size, token, priority)) return false;
+    chunk_cache.put(path, mtime, out);
+    return true;
+}
+
+namespace {
+
+// 不超过该大小的文件由I/O阶段整块读入，交给CPU阶段计算；更大的文件由读线程流式计算
+constexpr uint64_t kMaxBufferedFileSize = 1024 * 1024;
+// 压缩包内文本文件行级对比时读入内存的大小上限
+constexpr uint64_t kMaxArchiveTextSize = 256 * 1024 * 1024;
+// 遍历 -> I/O 阶段的路径队列深度
+constexpr size_t kReadQueueDepth = 1024;
+
+// 有序对比每批输出的条目数：批内需要哈希的文件对并行计算，批间保持路径顺序
+constexpr size_t kSortedBatchSize = 512;
+
+// 读线程为超过kMaxBufferedFileSize的大文件流式分类的结果
+struct HashedBlob {
+    FileBlob blob;
+    bool hashed = false;
+    FileClassification cls;
+};
 
-    // 递归遍历函数
-    std::function<void(const fs::path&)> traverse = [&](const fs::path& current_path) {
+} // namespace
+
+// 紧凑存储中的一行转为对外的FileInfo
+static FileInfo file_info_at(const ScanStore& store, size_t row) {
+    return FileInfo{
+        .full_path = store.full_path(row),
+        .rel_path = store.rel_path(row),
+        .size = store.file_size(row),
+        .crc32 = format_crc32(store.crc32(row)),
+        .is_text = store.is_text(row),
+        .encoding = encoding_name(store.encoding(row))
+    };
+}
+
+// 多线程扫描文件夹（结果为FileInfo映射，基于scan_folder_store）
+std::unordered_map<std::string, FileInfo> FileCompare::scan_folder(const std::string& folder_path, bool ignore_hidden,
+                                                                     const IgnoreOptions& ignore) {
+    ScanStore store = scan_folder_store(folder_path, ignore_hidden, ignore);
+    std::unordered_map<std::string, FileInfo> file_map;
+    file_map.reserve(store.size());
+    for (size_t row = 0; row < store.size(); ++row) {
+        FileInfo info = file_info_at(store, row);
+        std::string key = info.rel_path;
+        file_map.emplace(std::move(key), std::move(info));
+    }
+    return file_map;
+}
+
+// 多线程扫描文件夹：遍历 -> I/O阶段（按设备限制并发读） -> CPU阶段（哈希/文本判断）
+// 阶段之间使用有界队列，内存占用与队列深度成正比；结果写入紧凑存储
+ScanStore FileCompare::scan_folder_store(const std::string& folder_path, bool ignore_hidden, const IgnoreOptions& ignore) {
+    if (ArchiveReader::detect(normalize_path(folder_path)) != ArchiveFormat::None) {
+        return scan_archive_store(folder_path, ignore_hidden, ignore);
+    }
+    fs::path root_path = normalize_root(folder_path);
+    ScanStore store(root_path.string());
+    std::mutex store_mutex;
+
+    const CancelToken token = scan_token();
+    const size_t readers = std::max<size_t>(1, std::min(detect_io_concurrency(root_path), io_pool.size()));
+    BoundedQueue<fs::path> read_queue(kReadQueueDepth, &pool);
+    BoundedQueue<HashedBlob> hash_queue(pool.size() * 2);
+    // io_uring可用时单个读线程即可维持深队列，只保留少量读线程
+    const bool use_uring = BatchFileReader::uring_supported();
+    const unsigned batch_depth = use_uring ? static_cast<unsigned>(std::clamp<size_t>(readers * 8, 8, 64)) : 16;
+    const size_t reader_threads = use_uring ? std::min<size_t>(readers, 2) : readers;
+
+    // 任务组需在队列与store之后声明：异常退出时先等待在途任务结束
+    // 两组都不带取消令牌：每个入队的FileBlob都必须被取走，否则读线程可能阻塞在满队列上；
+    // 读任务在io_pool中排队时被取消也必须启动，由它清空路径队列（取消后只丢弃路径），否则遍历会等在满队列上
+    TaskGroup cpu_group(pool, TaskPriority::Background);
+    TaskGroup io_group(io_pool, TaskPriority::Background);
+
+    auto hash_one = [&]() {
+        HashedBlob item;
+        if (!hash_queue.try_pop(item) || token.cancelled()) return;
         try {
+            const FileBlob& blob = item.blob;
+            if (!item.hashed) {
+                item.cls = classify_buffer(blob.data.data(), blob.data.size());
+            }
+            // 遍历产生的路径都以root_path开头，按字面求相对路径即可，无需逐级stat
+            fs::path rel_path = blob.path.lexically_relative(root_path);
+
+            std::lock_guard<std::mutex> lock(store_mutex);
+            store.add(rel_path, item.cls);
+        } catch (...) {
+            // 单个文件处理失败，忽略
+        }
+    };
+
+    // I/O阶段：固定数量的读线程从路径队列成批取任务，批量打开/读取
+    for (size_t i = 0; i < reader_threads; ++i) {
+        io_group.run([&]() {
+            BatchFileReader reader(batch_depth);
+            std::vector<fs::path> paths;
+            std::vector<FileBlob> batch;
+            while (read_queue.pop_batch(paths, reader.batch_size())) {
+                if (token.cancelled()) {
+                    paths.clear();
+                    continue;
+                }
+                batch.resize(paths.size());
+                for (size_t k = 0; k < paths.size(); ++k) {
+                    batch[k] = FileBlob();
+                    batch[k].path = std::move(paths[k]);
+                }
+                paths.clear();
+                reader.read_batch(batch, kMaxBufferedFileSize);
+
+                for (FileBlob& blob : batch) {
+                    if (blob.error) continue; // 单个文件读取失败，忽略
+                    HashedBlob item;
+                    if (!blob.loaded) {
+                        // 大文件：单遍读取同时完成CRC与文本/编码判断，超大文件分块并行
+                        if (!classify_path(blob.path.string(), item.cls, token)) continue;
+                        item.hashed = true;
+                    }
+                    item.blob = std::move(blob);
+                    if (!hash_queue.push(std::move(item))) break;
+                    cpu_group.run(hash_one);
+                }
+            }
+        });
+    }
+
+    // 路径队列满时协助本扫描的CPU阶段，避免所有CPU线程都阻塞在遍历上时流水线停转
+    // 没有可协助的任务时休眠，由读线程取走路径或CPU阶段提交新任务唤醒
+    auto submit_path = [&](fs::path path) {
+        while (!token.cancelled() && !read_queue.try_push(path)) {
+            if (!cpu_group.try_run_one()) {
+                cpu_group.wait_for_work([&] { return read_queue.writable(); });
+            }
+        }
+    };
+
+    // 忽略规则在进入目录前判断，被忽略的子树不会被打开
+    IgnoreMatcher matcher(ignore);
+    const bool filtering = !matcher.inactive();
+
+    // 递归遍历函数（rel_dir为相对根目录的路径，分隔符'/'，仅在启用忽略规则时维护）
+    std::function<void(const fs::path&, const std::string&)> traverse = [&](const fs::path& current_path, const std::string& rel_dir) {
+        try {
+            if (filtering) matcher.enter(current_path, rel_dir);
             for (const auto& entry : fs::directory_iterator(current_path, fs::directory_options::skip_permission_denied)) {
-                if (entry.is_directory()) {
-                    traverse(entry.path()); // 递归子文件夹
-                } else if (entry.is_regular_file()) {
+                if (token.cancelled()) break;
+                bool is_dir = entry.is_directory();
+                if (!is_dir && !entry.is_regular_file()) continue;
+                std::string rel;
+                if (filtering) {
+                    rel = IgnoreMatcher::join(rel_dir, entry.path().filename().string());
+                    if (matcher.ignored(rel, is_dir)) continue;
+                }
+                if (is_dir) {
+                    // 不跟随目录符号链接，避免循环链接导致无限递归
+                    if (!entry.is_symlink()) traverse(entry.path(), rel); // 递归子文件夹
+                } else {
                     if (ignore_hidden && is_hidden_file(entry.path())) continue;
-                    
-                    task_count++;
-                    pool.enqueue([&, entry, root_path]() {
-                        try {
-                            std::string full_path = entry.path().string();
-                            std::string rel_path = get_relative_path(root_path.string(), full_path);
-                            uint64_t size = fs::file_size(entry.path());
-                            std::string crc = calculate_crc32(full_path);
-                            bool is_text = is_text_file(full_path);
-
-                            FileInfo info{
-                                .full_path = full_path,
-                                .rel_path = rel_path,
-                                .size = size,
-                                .crc32 = crc,
-                                .is_text = is_text
-                            };
-
-                            std::lock_guard<std::mutex> lock(map_mutex);
-                            file_map[rel_path] = info;
-                        } catch (...) {
-                            // 单个文件处理失败，忽略
-                        }
-                        task_count--;
-                    });
+                    submit_path(entry.path());
                 }
             }
+            if (filtering) matcher.leave();
         } catch (const std::exception& e) {
             throw std::runtime_error("Traverse error: " + exception_to_string(e));
         }
     };
 
-    // 执行遍历并等待所有任务完成
-    traverse(root_path);
-    while (task_count > 0) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // 执行遍历，关闭路径队列后依次等待I/O阶段与CPU阶段完成
+    try {
+        traverse(root_path, std::string());
+    } catch (...) {
+        read_queue.close();
+        io_group.wait_helping(cpu_group);
+        throw;
+    }
+    read_queue.close();
+    io_group.wait_helping(cpu_group);
+    cpu_group.wait();
+    if (token.cancelled()) {
+        throw std::runtime_error("Scan cancelled: " + folder_path);
     }
 
-    return file_map;
+    return store;
+}
+
+// 压缩包作为虚拟目录树扫描：单遍流式读取（tar.gz边解压边分类），不落临时文件，内存与包大小无关
+// 只应用全局忽略规则（包内的.gitignore不读取）；存储根为"<压缩包>!"，full_path即包内路径写法
+ScanStore FileCompare::scan_archive_store(const std::string& archive_path, bool ignore_hidden, const IgnoreOptions& ignore) {
+    const std::string archive = normalize_path(archive_path);
+    ScanStore store(archive + kArchiveMemberMark);
+    const CancelToken token = scan_token();
+    IgnoreOptions global = ignore;
+    global.use_gitignore = false;
+    IgnoreMatcher matcher(global);
+    const bool filtering = !matcher.inactive();
+
+    // 条目路径及其每级父目录都要判断（包内条目不保证先列出目录）
+    auto ignored = [&](const std::string& rel) {
+        for (size_t slash = rel.find('/'); slash != std::string::npos; slash = rel.find('/', slash + 1)) {
+            if (matcher.ignored(std::string_view(rel).substr(0, slash), true)) return true;
+        }
+        return matcher.ignored(rel, false);
+    };
+
+    std::string error;
+    bool ok = ArchiveReader::for_each(archive, [&](const ArchiveEntry& entry, const ArchiveReader::ContentReader& read) {
+        if (token.cancelled()) return false;
+        if (entry.is_dir) return true;
+        if (filtering && ignored(entry.path)) return true;
+        if (ignore_hidden) {
+            size_t slash = entry.path.rfind('/');
+            if (entry.path[slash == std::string::npos ? 0 : slash + 1] == '.') return true;
+        }
+        store.add(fs::path(entry.path), ArchiveReader::classify_entry(entry, read));
+        return true;
+    }, error);
+    if (token.cancelled()) {
+        throw std::runtime_error("Scan cancelled: " + archive_path);
+    }
+    if (!ok) throw std::runtime_error(error);
+    return store;
 }
 
 // 文件夹对比（并行扫描+哈希快速对比）
-FolderDiffResult FileCompare::compare_folders(const std::string& folder_a, const std::string& folder_b, bool ignore_hidden) {
+FolderDiffResult FileCompare::compare_folders(const std::string& folder_a, const std::string& folder_b, bool ignore_hidden,
+                                              const IgnoreOptions& ignore, bool detect_renames) {
     FolderDiffResult result;
     try {
-        // 并行扫描两个文件夹
-        auto future_a = std::async(std::launch::async, &FileCompare::scan_folder, this, folder_a, ignore_hidden);
-        auto future_b = std::async(std::launch::async, &FileCompare::scan_folder, this, folder_b, ignore_hidden);
-        
-        auto map_a = future_a.get();
-        auto map_b = future_b.get();
+        // 任一侧为快照：另一侧生成快照（快照与其是同一文件夹时作为基线沿用CRC）后按Merkle树对比
+        bool snap_a = FolderSnapshot::is_snapshot_file(folder_a);
+        bool snap_b = FolderSnapshot::is_snapshot_file(folder_b);
+        if (snap_a || snap_b) {
+            std::string error;
+            FolderSnapshot loaded_a;
+            FolderSnapshot loaded_b;
+            if (snap_a && !FolderSnapshot::load(folder_a, loaded_a, error)) throw std::runtime_error(error);
+            if (snap_b && !FolderSnapshot::load(folder_b, loaded_b, error)) throw std::runtime_error(error);
+            if (!snap_a) loaded_a = build_snapshot(folder_a, ignore_hidden, ignore, &loaded_b);
+            if (!snap_b) loaded_b = build_snapshot(folder_b, ignore_hidden, ignore, &loaded_a);
+            return compare_snapshots(loaded_a, loaded_b);
+        }
+
+        // 并行扫描两个文件夹：B交给线程池，A在当前线程扫描，随后协助等待B
+        ScanStore store_a;
+        ScanStore store_b;
+        TaskGroup group(pool, TaskPriority::Background);
+        group.run([&]() { store_b = scan_folder_store(folder_b, ignore_hidden, ignore); });
+        store_a = scan_folder_store(folder_a, ignore_hidden, ignore);
+        group.wait();
 
         // 总文件数（去重）
-        result.total_files = map_a.size() + map_b.size();
+        result.total_files = store_a.size() + store_b.size();
 
-        // 遍历A的文件，对比B
-        for (const auto& [rel_path, info_a] : map_a) {
-            auto it_b = map_b.find(rel_path);
-            if (it_b == map_b.end()) {
-                result.diffs.deleted.push_back(info_a); // A有B无
+        // A的路径节点一次性映射到B，逐行按节点查找，无需构造路径字符串
+        std::vector<uint32_t> a_to_b = store_b.map_nodes_from(store_a);
+        std::vector<bool> matched_b(store_b.size(), false);
+        std::vector<uint32_t> deleted_rows;
+        std::vector<uint32_t> added_rows;
+        for (size_t row_a = 0; row_a < store_a.size(); ++row_a) {
+            uint32_t node_b = a_to_b[store_a.node(row_a)];
+            uint32_t row_b = node_b == PathArena::kNone ? ScanStore::kNoRow : store_b.row_of_node(node_b);
+            if (row_b == ScanStore::kNoRow) {
+                deleted_rows.push_back(static_cast<uint32_t>(row_a)); // A有B无
+                continue;
+            }
+            matched_b[row_b] = true;
+            if (store_a.crc32(row_a) != store_b.crc32(row_b) || store_a.file_size(row_a) != store_b.file_size(row_b)) {
+                result.diffs.modified.push_back(file_info_at(store_a, row_a)); // 内容不同
             } else {
-                if (info_a.crc32 != it_b->second.crc32) {
-                    result.diffs.modified.push_back(info_a); // 内容不同
+                result.diffs.same.push_back(file_info_at(store_a, row_a)); // 完全相同
+                result.same_count++;
+                result.total_files--; // 去重
+            }
+        }
+
+        // 未匹配的B文件：新增
+        for (size_t row_b = 0; row_b < store_b.size(); ++row_b) {
+            if (!matched_b[row_b]) {
+                added_rows.push_back(static_cast<uint32_t>(row_b));
+            }
+        }
+
+        // 删除与新增配对为重命名/移动，配上的行从两个列表中移除
+        if (detect_renames && !deleted_rows.empty() && !added_rows.empty()) {
+            this->detect_renames(store_a, store_b, deleted_rows, added_rows, result);
+        }
+        for (uint32_t row_a : deleted_rows) result.diffs.deleted.push_back(file_info_at(store_a, row_a));
+        for (uint32_t row_b : added_rows) result.diffs.added.push_back(file_info_at(store_b, row_b));
+
+    } catch (const std::exception& e) {
+        result.error = exception_to_string(e);
+    }
+    return result;
+}
+
+namespace {
+
+// 参与相似度计算的文本文件大小上限
+constexpr uint64_t kMaxSimilarityFileSize = 1024 * 1024;
+// 相似度低于该值不视为重命名（与git默认的50%一致）
+constexpr double kMinRenameSimilarity = 0.5;
+// 每个文件名参与相似度比较的候选数上限，保证总体线性
+constexpr size_t kMaxSimilarityCandidates = 4;
+
+// 文本行哈希（排序后），用于相似度计算
+std::vector<uint64_t> sorted_line_hashes(const std::string& path) {
+    std::vector<uint64_t> hashes;
+    for (const auto& line : read_text_file_lines(path)) hashes.push_back(fnv1a_hash(line));
+    std::sort(hashes.begin(), hashes.end());
+    return hashes;
+}
+
+// 行多重集的Dice系数：2*|A∩B| / (|A|+|B|)
+double line_similarity(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b) {
+    if (a.empty() && b.empty()) return 1.0;
+    size_t common = 0;
+    for (size_t i = 0, j = 0; i < a.size() && j < b.size();) {
+        if (a[i] < b[j]) {
+            ++i;
+        } else if (b[j] < a[i]) {
+            ++j;
+        } else {
+            ++common;
+            ++i;
+            ++j;
+        }
+    }
+    return 2.0 * static_cast<double>(common) / static_cast<double>(a.size() + b.size());
+}
+
+// 存储根为"<压缩包>!"的扫描结果
+bool is_archive_store(const ScanStore& store) {
+    const std::string& root = store.root_path();
+    return !root.empty() && root.back() == kArchiveMemberMark &&
+           ArchiveReader::detect(root.substr(0, root.size() - 1)) != ArchiveFormat::None;
+}
+
+std::string parent_of(const std::string& rel_path) {
+    return fs::path(rel_path).parent_path().string();
+}
+
+} // namespace
+
+// 重命名/移动检测（删除集与新增集的后处理）
+// 1. 按(大小, CRC32)哈希连接：每个新增文件在桶中取一个删除文件，同名优先
+// 2. 剩余文本文件按文件名连接，候选有限，行哈希相似度并行计算后贪心配对
+// 3. 目录级：配对文件的父目录对逐级向上投票（名字相同才继续向上），
+//    票数达到A侧目录子树文件数一半的目录对报告为目录重命名，被父目录重命名覆盖的子目录不再重复报告
+void FileCompare::detect_renames(const ScanStore& store_a, const ScanStore& store_b,
+                                 std::vector<uint32_t>& deleted_rows, std::vector<uint32_t>& added_rows,
+                                 FolderDiffResult& result) {
+    const PathArena& paths_a = store_a.paths();
+    const PathArena& paths_b = store_b.paths();
+    std::vector<bool> used_a(store_a.size(), false);
+    std::vector<bool> used_b(store_b.size(), false);
+    std::vector<std::pair<uint32_t, uint32_t>> pairs; // (row_a, row_b)
+
+    auto add_pair = [&](uint32_t row_a, uint32_t row_b, double similarity) {
+        used_a[row_a] = true;
+        used_b[row_b] = true;
+        pairs.emplace_back(row_a, row_b);
+        RenamedFile renamed{file_info_at(store_a, row_a), file_info_at(store_b, row_b), false, similarity};
+        renamed.moved = parent_of(renamed.from.rel_path) != parent_of(renamed.to.rel_path);
+        result.diffs.renamed.push_back(std::move(renamed));
+    };
+
+    // 1. 精确内容匹配
+    auto key_of = [](uint64_t size, uint32_t crc) { return (size << 32) ^ (size >> 32) ^ crc; };
+    std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+    buckets.reserve(deleted_rows.size());
+    // 空文件内容无区分度，不参与配对
+    for (uint32_t row_a : deleted_rows) {
+        if (store_a.file_size(row_a) == 0) continue;
+        buckets[key_of(store_a.file_size(row_a), store_a.crc32(row_a))].push_back(row_a);
+    }
+    for (uint32_t row_b : added_rows) {
+        if (store_b.file_size(row_b) == 0) continue;
+        auto it = buckets.find(key_of(store_b.file_size(row_b), store_b.crc32(row_b)));
+        if (it == buckets.end()) continue;
+        std::vector<uint32_t>& bucket = it->second;
+        std::string_view name_b = paths_b.name(store_b.node(row_b));
+        size_t pick = bucket.size();
+        size_t scanned = 0;
+        for (size_t i = bucket.size(); i-- > 0 && scanned < kMaxSimilarityCandidates; ++scanned) {
+            uint32_t row_a = bucket[i];
+            if (store_a.file_size(row_a) != store_b.file_size(row_b) || store_a.crc32(row_a) != store_b.crc32(row_b)) continue;
+            if (pick == bucket.size()) pick = i;
+            if (paths_a.name(store_a.node(row_a)) == name_b) {
+                pick = i;
+                break;
+            }
+        }
+        if (pick == bucket.size()) continue;
+        uint32_t row_a = bucket[pick];
+        bucket[pick] = bucket.back();
+        bucket.pop_back();
+        add_pair(row_a, row_b, 1.0);
+    }
+
+    // 2. 同名文本文件的近似匹配
+    // 压缩包内的文件无法廉价地随机读取（tar.gz需从头解压），只做精确匹配
+    const bool fuzzy = !is_archive_store(store_a) && !is_archive_store(store_b);
+    std::unordered_map<std::string_view, std::vector<uint32_t>> by_name;
+    if (fuzzy) {
+        for (uint32_t row_a : deleted_rows) {
+            if (used_a[row_a] || !store_a.is_text(row_a) || store_a.file_size(row_a) > kMaxSimilarityFileSize) continue;
+            std::vector<uint32_t>& candidates = by_name[paths_a.name(store_a.node(row_a))];
+            if (candidates.size() < kMaxSimilarityCandidates) candidates.push_back(row_a);
+        }
+    }
+    struct Candidate {
+        uint32_t row_a;
+        uint32_t row_b;
+        double similarity;
+    };
+    std::vector<Candidate> candidates;
+    for (uint32_t row_b : added_rows) {
+        if (used_b[row_b] || !store_b.is_text(row_b) || store_b.file_size(row_b) > kMaxSimilarityFileSize) continue;
+        auto it = by_name.find(paths_b.name(store_b.node(row_b)));
+        if (it == by_name.end()) continue;
+        for (uint32_t row_a : it->second) {
+            // 大小相差一倍以上不可能达到相似度阈值
+            uint64_t sa = store_a.file_size(row_a);
+            uint64_t sb = store_b.file_size(row_b);
+            if (std::max(sa, sb) > 2 * std::min(sa, sb) + 64) continue;
+            candidates.push_back(Candidate{row_a, row_b, 0.0});
+        }
+    }
+    if (!candidates.empty()) {
+        // 每个候选文件只读取一次；扫描后被删除或不可读的文件相似度记为0，不影响整个对比
+        struct LineHashes {
+            std::vector<uint64_t> hashes;
+            bool ok = false;
+        };
+        std::unordered_map<uint32_t, LineHashes> lines_a;
+        std::unordered_map<uint32_t, LineHashes> lines_b;
+        for (const Candidate& c : candidates) {
+            lines_a[c.row_a];
+            lines_b[c.row_b];
+        }
+        TaskGroup group(pool, TaskPriority::Background);
+        auto load_all = [&](const ScanStore& store, std::unordered_map<uint32_t, LineHashes>& lines) {
+            for (auto& entry : lines) {
+                const uint32_t row = entry.first;
+                LineHashes* out = &entry.second;
+                group.run([&store, row, out]() {
+                    try {
+                        out->hashes = sorted_line_hashes(store.full_path(row));
+                        out->ok = true;
+                    } catch (...) {
+                        // 读取失败，相似度按0处理
+                    }
+                });
+            }
+        };
+        load_all(store_a, lines_a);
+        load_all(store_b, lines_b);
+        group.wait();
+        for (Candidate& c : candidates) {
+            const LineHashes& a = lines_a[c.row_a];
+            const LineHashes& b = lines_b[c.row_b];
+            c.similarity = a.ok && b.ok ? line_similarity(a.hashes, b.hashes) : 0.0;
+        }
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const Candidate& x, const Candidate& y) { return x.similarity > y.similarity; });
+        for (const Candidate& c : candidates) {
+            if (c.similarity < kMinRenameSimilarity) break;
+            if (used_a[c.row_a] || used_b[c.row_b]) continue;
+            add_pair(c.row_a, c.row_b, c.similarity);
+        }
+    }
+
+    // 从删除/新增列表中移除已配对的行
+    deleted_rows.erase(std::remove_if(deleted_rows.begin(), deleted_rows.end(), [&](uint32_t r) { return used_a[r]; }),
+                       deleted_rows.end());
+    added_rows.erase(std::remove_if(added_rows.begin(), added_rows.end(), [&](uint32_t r) { return used_b[r]; }),
+                     added_rows.end());
+
+    // 3. 目录级重命名
+    if (pairs.empty()) return;
+    std::vector<uint32_t> subtree_files(paths_a.node_count(), 0);
+    for (size_t row = 0; row < store_a.size(); ++row) {
+        for (uint32_t n = paths_a.parent(store_a.node(row)); n != PathArena::kNone; n = paths_a.parent(n)) {
+            subtree_files[n]++;
+        }
+    }
+    auto dir_key = [](uint32_t da, uint32_t db) { return (static_cast<uint64_t>(da) << 32) | db; };
+    std::unordered_map<uint64_t, uint32_t> votes;
+    for (const auto& [row_a, row_b] : pairs) {
+        uint32_t da = paths_a.parent(store_a.node(row_a));
+        uint32_t db = paths_b.parent(store_b.node(row_b));
+        while (da != PathArena::kRoot && db != PathArena::kRoot) {
+            votes[dir_key(da, db)]++;
+            if (paths_a.name(da) != paths_b.name(db)) break;
+            da = paths_a.parent(da);
+            db = paths_b.parent(db);
+        }
+    }
+    auto is_dir_rename = [&](uint32_t da, uint32_t db) {
+        auto it = votes.find(dir_key(da, db));
+        return it != votes.end() && it->second * 2 >= subtree_files[da] && paths_a.path(da) != paths_b.path(db);
+    };
+    std::vector<std::pair<uint32_t, uint32_t>> dirs;
+    for (const auto& [key, count] : votes) {
+        uint32_t da = static_cast<uint32_t>(key >> 32);
+        uint32_t db = static_cast<uint32_t>(key & 0xFFFFFFFFu);
+        if (count < 2 || !is_dir_rename(da, db)) continue;
+        // 父目录已整体重命名且名字未变的子目录不重复报告
+        uint32_t pa = paths_a.parent(da);
+        uint32_t pb = paths_b.parent(db);
+        if (paths_a.name(da) == paths_b.name(db) && pa != PathArena::kRoot && pb != PathArena::kRoot && is_dir_rename(pa, pb)) {
+            continue;
+        }
+        dirs.emplace_back(da, db);
+    }
+    for (const auto& [da, db] : dirs) {
+        result.diffs.renamed_dirs.push_back(RenamedDir{paths_a.path(da), paths_b.path(db), votes[dir_key(da, db)]});
+    }
+    std::sort(result.diffs.renamed_dirs.begin(), result.diffs.renamed_dirs.end(),
+              [](const RenamedDir& x, const RenamedDir& y) { return x.from < y.from; });
+}
+
+// 生成快照：有序遍历得到先序节点，需要读取内容的文件在线程池中分块计算
+// 基线与遍历顺序一致，每层目录维护一个兄弟游标即可线性匹配同路径节点
+FolderSnapshot FileCompare::build_snapshot(const std::string& folder_path, bool ignore_hidden,
+                                           const IgnoreOptions& ignore, const FolderSnapshot* baseline) {
+    fs::path root_path = normalize_root(folder_path);
+    const CancelToken token = scan_token();
+    FolderSnapshot snap(root_path.string());
+    snap.add(FolderSnapshot::kNone, std::string_view(), true, 0, 0);
+
+    IgnoreMatcher matcher(ignore);
+    SortedDirWalker walker(root_path, ignore_hidden, &matcher);
+
+    std::vector<uint32_t> ancestors{0};            // ancestors[d]为最近一个深度d的节点
+    std::vector<uint32_t> base_dir{0};             // 与ancestors对应的基线目录节点
+    std::vector<uint32_t> base_cursor{1};          // 基线目录中下一个待匹配的子节点
+    // 基线必须是同一个文件夹的快照：另一棵树中大小与修改时间相同的文件（cp -p、rsync -t、解压）内容未必相同
+    std::error_code ec;
+    if (!baseline || baseline->size() == 0 || !fs::equivalent(baseline->root_path(), root_path, ec)) {
+        base_dir[0] = FolderSnapshot::kNone;
+    }
+
+    std::vector<std::pair<uint32_t, fs::path>> to_hash;
+    while (walker.next()) {
+        if (token.cancelled()) {
+            throw std::runtime_error("Scan cancelled: " + folder_path);
+        }
+        size_t depth = walker.depth();
+        ancestors.resize(depth);
+        base_dir.resize(depth);
+        base_cursor.resize(depth);
+        std::string_view name = walker.components().back();
+        uint32_t index = snap.add(ancestors.back(), name, walker.is_dir(), walker.size(), walker.mtime());
+        ancestors.push_back(index);
+
+        // 在基线同一目录的子节点中按名字前进查找
+        uint32_t match = FolderSnapshot::kNone;
+        uint32_t parent_base = base_dir.back();
+        if (parent_base != FolderSnapshot::kNone) {
+            uint32_t end = baseline->node(parent_base).end;
+            uint32_t& cursor = base_cursor.back();
+            while (cursor < end && baseline->name(cursor) < name) cursor = baseline->node(cursor).end;
+            if (cursor < end && baseline->name(cursor) == name && baseline->is_dir(cursor) == walker.is_dir()) {
+                match = cursor;
+                cursor = baseline->node(cursor).end;
+            }
+        }
+        base_dir.push_back(walker.is_dir() ? match : FolderSnapshot::kNone);
+        base_cursor.push_back(match == FolderSnapshot::kNone ? 0 : match + 1);
+
+        if (walker.is_dir()) continue;
+        if (match != FolderSnapshot::kNone && baseline->node(match).size == walker.size() &&
+            baseline->node(match).mtime == walker.mtime()) {
+            snap.set_content(index, baseline->node(match).crc32, static_cast<TextEncoding>(baseline->node(match).encoding));
+        } else {
+            to_hash.emplace_back(index, walker.path());
+        }
+    }
+
+    // 变化或新增的文件：单遍分类得到CRC与编码
+    constexpr size_t kChunk = 64;
+    std::mutex snap_mutex;
+    TaskGroup group(pool, TaskPriority::Background, token);
+    for (size_t begin = 0; begin < to_hash.size(); begin += kChunk) {
+        group.run([&, begin]() {
+            size_t end = std::min(begin + kChunk, to_hash.size());
+            for (size_t i = begin; i < end; ++i) {
+                FileClassification cls;
+                if (!classify_path(to_hash[i].second.string(), cls, token)) continue;
+                std::lock_guard<std::mutex> lock(snap_mutex);
+                snap.set_content(to_hash[i].first, cls.crc32, cls.encoding);
+            }
+        });
+    }
+    group.wait();
+    if (token.cancelled()) {
+        throw std::runtime_error("Scan cancelled: " + folder_path);
+    }
+
+    snap.finish();
+    return snap;
+}
+
+namespace {
+
+FileInfo file_info_at(const FolderSnapshot& snap, uint32_t i) {
+    const FolderSnapshot::Record& r = snap.node(i);
+    return FileInfo{
+        .full_path = snap.full_path(i),
+        .rel_path = snap.rel_path(i),
+        .size = r.size,
+        .crc32 = format_crc32(r.crc32),
+        .is_text = static_cast<TextEncoding>(r.encoding) != TextEncoding::Binary,
+        .encoding = encoding_name(static_cast<TextEncoding>(r.encoding))
+    };
+}
+
+// 把一侧独有的子树中的文件全部加入列表
+void collect_files(const FolderSnapshot& snap, uint32_t i, std::vector<FileInfo>& out) {
+    for (uint32_t n = i; n < snap.node(i).end; ++n) {
+        if (!snap.is_dir(n)) out.push_back(file_info_at(snap, n));
+    }
+}
+
+} // namespace
+
+// 快照对比：两棵树的子项都按名字排序，逐目录归并；哈希相同的子树只累加文件数
+FolderDiffResult FileCompare::compare_snapshots(const FolderSnapshot& snap_a, const FolderSnapshot& snap_b) {
+    FolderDiffResult result;
+    if (snap_a.size() == 0 || snap_b.size() == 0) {
+        result.error = "Empty snapshot";
+        return result;
+    }
+    result.total_files = snap_a.file_count() + snap_b.file_count();
+
+    std::function<void(uint32_t, uint32_t)> compare_dir = [&](uint32_t dir_a, uint32_t dir_b) {
+        uint32_t ia = dir_a + 1;
+        uint32_t ib = dir_b + 1;
+        const uint32_t end_a = snap_a.node(dir_a).end;
+        const uint32_t end_b = snap_b.node(dir_b).end;
+        while (ia < end_a || ib < end_b) {
+            int order = ia >= end_a ? 1 : ib >= end_b ? -1 : snap_a.name(ia).compare(snap_b.name(ib));
+            if (order < 0) {
+                collect_files(snap_a, ia, result.diffs.deleted); // A有B无
+                ia = snap_a.node(ia).end;
+                continue;
+            }
+            if (order > 0) {
+                collect_files(snap_b, ib, result.diffs.added); // B有A无
+                ib = snap_b.node(ib).end;
+                continue;
+            }
+            const FolderSnapshot::Record& ra = snap_a.node(ia);
+            const FolderSnapshot::Record& rb = snap_b.node(ib);
+            if (ra.is_dir != rb.is_dir) {
+                collect_files(snap_a, ia, result.diffs.deleted);
+                collect_files(snap_b, ib, result.diffs.added);
+            } else if (ra.is_dir) {
+                if (ra.hash == rb.hash) {
+                    // 相同子树：不再访问其中任何节点
+                    result.same_count += ra.files;
+                    result.total_files -= ra.files;
+                    result.skipped_subtrees++;
                 } else {
-                    result.diffs.same.push_back(info_a); // 完全相同
-                    result.total_files--; // 去重
+                    compare_dir(ia, ib);
                 }
-                map_b.erase(it_b); // 标记已处理
+            } else if (ra.size != rb.size || ra.crc32 != rb.crc32) {
+                result.diffs.modified.push_back(file_info_at(snap_a, ia)); // 内容不同
+            } else {
+                result.diffs.same.push_back(file_info_at(snap_a, ia));
+                result.same_count++;
+                result.total_files--; // 去重
             }
+            ia = ra.end;
+            ib = rb.end;
         }
+    };
+
+    if (snap_a.node(0).hash == snap_b.node(0).hash) {
+        result.same_count = snap_a.file_count();
+        result.total_files = snap_a.file_count();
+        result.skipped_subtrees = 1;
+    } else {
+        compare_dir(0, 0);
+    }
+    return result;
+}
+
+// 有序文件夹对比：两侧SortedDirWalker按相同顺序输出，归并连接（merge-join）逐条分类
+// 只在一侧存在的目录继续向下遍历，其子项逐条输出为新增/删除；
+// 路径相同但一侧为文件一侧为目录时，按删除+新增两条输出（文件在前）
+SortedDiffStats FileCompare::compare_folders_sorted(const std::string& folder_a, const std::string& folder_b, bool ignore_hidden,
+                                                    const std::function<void(std::vector<SortedDiffEntry>&)>& sink,
+                                                    const IgnoreOptions& ignore) {
+    SortedDiffStats stats;
+    try {
+        fs::path root_a = normalize_root(folder_a);
+        fs::path root_b = normalize_root(folder_b);
+        const CancelToken token = scan_token();
+
+        // 两侧各自维护.gitignore层级
+        IgnoreMatcher matcher_a(ignore);
+        IgnoreMatcher matcher_b(ignore);
+        SortedDirWalker walker_a(root_a, ignore_hidden, &matcher_a);
+        SortedDirWalker walker_b(root_b, ignore_hidden, &matcher_b);
+
+        std::vector<SortedDiffEntry> batch;
+        std::vector<std::pair<fs::path, fs::path>> pair_paths; // 与batch等长，需要哈希的文件对
+        batch.reserve(kSortedBatchSize);
+        pair_paths.reserve(kSortedBatchSize);
+
+        auto count = [&](EntryStatus status) {
+            switch (status) {
+                case EntryStatus::Same: stats.same++; break;
+                case EntryStatus::Modified: stats.modified++; break;
+                case EntryStatus::Added: stats.added++; break;
+                case EntryStatus::Deleted: stats.deleted++; break;
+            }
+        };
+
+        // 批内文件对并行分类，完成后按原顺序交给sink
+        auto flush = [&]() {
+            TaskGroup group(pool, TaskPriority::Background, token);
+            for (size_t i = 0; i < batch.size(); ++i) {
+                if (pair_paths[i].first.empty()) continue;
+                group.run([&, i]() {
+                    SortedDiffEntry& entry = batch[i];
+                    FileClassification cls_a;
+                    FileClassification cls_b;
+                    bool ok = classify_path(pair_paths[i].first.string(), cls_a, token) &&
+                              classify_path(pair_paths[i].second.string(), cls_b, token);
+                    entry.crc_a = ok ? cls_a.crc32 : 0;
+                    entry.crc_b = ok ? cls_b.crc32 : 0;
+                    // 读取失败无法确认内容一致，按修改处理
+                    entry.status = ok && cls_a.size == cls_b.size && cls_a.crc32 == cls_b.crc32
+                                       ? EntryStatus::Same : EntryStatus::Modified;
+                });
+            }
+            group.wait();
+            if (token.cancelled()) {
+                throw std::runtime_error("Scan cancelled: " + folder_a);
+            }
+            for (const SortedDiffEntry& entry : batch) count(entry.status);
+            sink(batch);
+            batch.clear();
+            pair_paths.clear();
+        };
 
-        // 剩余B的文件：新增
-        for (const auto& [rel_path, info_b] : map_b) {
-            result.diffs.added.push_back(info_b);
+        // side_a/side_b为空表示该侧不存在；hash为true时批内读取内容比较
+        auto emit = [&](EntryStatus status, const SortedDirWalker* side_a, const SortedDirWalker* side_b, bool hash = false) {
+            const SortedDirWalker& w = side_a ? *side_a : *side_b;
+            batch.push_back(SortedDiffEntry{w.rel_path(), static_cast<uint32_t>(w.depth()), w.is_dir(), status,
+                                            side_a ? side_a->size() : 0, side_b ? side_b->size() : 0,
+                                            side_a ? side_a->mtime() : 0, side_b ? side_b->mtime() : 0, 0, 0});
+            if (hash) {
+                pair_paths.emplace_back(side_a->path(), side_b->path());
+            } else {
+                pair_paths.emplace_back();
+            }
+            if (batch.size() >= kSortedBatchSize) flush();
+        };
+
+        bool has_a = walker_a.next();
+        bool has_b = walker_b.next();
+        while (has_a || has_b) {
+            if (token.cancelled()) {
+                throw std::runtime_error("Scan cancelled: " + folder_a);
+            }
+            int order = !has_a ? 1 : !has_b ? -1 : SortedDirWalker::compare(walker_a.components(), walker_b.components());
+            if (order < 0) {
+                emit(EntryStatus::Deleted, &walker_a, nullptr); // A有B无
+                has_a = walker_a.next();
+            } else if (order > 0) {
+                emit(EntryStatus::Added, nullptr, &walker_b); // B有A无
+                has_b = walker_b.next();
+            } else if (walker_a.is_dir() != walker_b.is_dir()) {
+                // 文件一侧先输出，目录紧接其子项之前
+                if (walker_a.is_dir()) {
+                    emit(EntryStatus::Added, nullptr, &walker_b);
+                    emit(EntryStatus::Deleted, &walker_a, nullptr);
+                } else {
+                    emit(EntryStatus::Deleted, &walker_a, nullptr);
+                    emit(EntryStatus::Added, nullptr, &walker_b);
+                }
+                has_a = walker_a.next();
+                has_b = walker_b.next();
+            } else {
+                if (walker_a.is_dir()) {
+                    emit(EntryStatus::Same, &walker_a, &walker_b);
+                } else if (walker_a.size() != walker_b.size()) {
+                    // 大小不同无需读取内容
+                    emit(EntryStatus::Modified, &walker_a, &walker_b);
+                } else {
+                    emit(EntryStatus::Same, &walker_a, &walker_b, true);
+                }
+                has_a = walker_a.next();
+                has_b = walker_b.next();
+            }
         }
+        if (!batch.empty()) flush();
 
+    } catch (const std::exception& e) {
+        stats.error = exception_to_string(e);
+    }
+    return stats;
+}
+
+// 两侧对齐的目录差异树：在有序归并结果上按深度还原父子关系，再自底向上聚合目录状态
+DirDiffTree FileCompare::diff_tree(const std::string& folder_a, const std::string& folder_b, bool ignore_hidden,
+                                   const IgnoreOptions& ignore) {
+    DirDiffTree tree;
+    tree.root_a = folder_a;
+    tree.root_b = folder_b;
+    tree.nodes.push_back(DirDiffTree::Node{DirDiffTree::kNoParent, 0, std::string(), true, true, true,
+                                           DiffStatus::Identical, 0, 0, 0, 0});
+
+    uint64_t root_size = 0;
+    stat_entry(fs::path(normalize_path(folder_a)), root_size, tree.nodes[0].mtime_a);
+    stat_entry(fs::path(normalize_path(folder_b)), root_size, tree.nodes[0].mtime_b);
+
+    std::vector<uint32_t> ancestors{0}; // ancestors[d]为最近一个深度d的节点
+    SortedDiffStats stats = compare_folders_sorted(folder_a, folder_b, ignore_hidden, [&](std::vector<SortedDiffEntry>& batch) {
+        for (SortedDiffEntry& e : batch) {
+            uint32_t index = static_cast<uint32_t>(tree.nodes.size());
+            ancestors.resize(e.depth);
+            DirDiffTree::Node node;
+            node.parent = ancestors.back();
+            node.level = e.depth;
+            node.name = fs::path(e.rel_path).filename().string();
+            node.is_folder = e.is_dir;
+            node.has_left = e.status != EntryStatus::Added;
+            node.has_right = e.status != EntryStatus::Deleted;
+            switch (e.status) {
+                case EntryStatus::Same: node.status = DiffStatus::Identical; break;
+                case EntryStatus::Modified: node.status = DiffStatus::Different; break;
+                case EntryStatus::Added: node.status = DiffStatus::RightOnly; break;
+                case EntryStatus::Deleted: node.status = DiffStatus::LeftOnly; break;
+            }
+            node.size_a = e.size_a;
+            node.size_b = e.size_b;
+            node.mtime_a = e.mtime_a;
+            node.mtime_b = e.mtime_b;
+            tree.nodes.push_back(std::move(node));
+            ancestors.push_back(index);
+        }
+    }, ignore);
+    if (!stats.error.empty()) {
+        tree.nodes.clear();
+        tree.error = stats.error;
+        return tree;
+    }
+    tree.identical = stats.same;
+    tree.different = stats.modified;
+    tree.left_only = stats.deleted;
+    tree.right_only = stats.added;
+
+    // 父节点下标小于子节点，逆序一遍即可把差异向上传播到两侧都存在的目录
+    for (size_t i = tree.nodes.size(); i-- > 1;) {
+        DirDiffTree::Node& parent = tree.nodes[tree.nodes[i].parent];
+        if (tree.nodes[i].status != DiffStatus::Identical && parent.status == DiffStatus::Identical) {
+            parent.status = DiffStatus::Different;
+        }
+    }
+    return tree;
+}
+
+namespace {
+
+// 首尾部分哈希的块大小；不超过两块的文件在该阶段整块读入，直接得到强哈希
+constexpr uint64_t kPartialBlock = 4096;
+
+// 查重候选文件
+struct DupFile {
+    uint32_t node;          // PathArena中的路径节点
+    uint64_t size;
+    uint64_t key = 0;       // 首尾块哈希（小文件为摘要前8字节）
+    bool complete = false;  // digest已覆盖全文
+    bool failed = false;    // 读取失败或读取期间大小变化
+    std::array<uint8_t, 32> digest{};
+};
+
+// 读取首尾各一块；小文件整块读入并直接计算SHA-256
+bool hash_partial(const std::string& path, DupFile& f, uint64_t& bytes_read) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    char buf[2 * kPartialBlock];
+    if (f.size <= sizeof(buf)) {
+        if (!file.read(buf, static_cast<std::streamsize>(f.size)) || file.peek() != std::char_traits<char>::eof()) {
+            return false;
+        }
+        bytes_read += f.size;
+        Sha256 sha;
+        sha.update(buf, f.size);
+        sha.finish(f.digest.data());
+        std::memcpy(&f.key, f.digest.data(), sizeof(f.key));
+        f.complete = true;
+        return true;
+    }
+    if (!file.read(buf, kPartialBlock)) return false;
+    file.seekg(static_cast<std::streamoff>(f.size - kPartialBlock));
+    if (!file.read(buf + kPartialBlock, kPartialBlock)) return false;
+    bytes_read += 2 * kPartialBlock;
+    f.key = (static_cast<uint64_t>(crc32_update(0, buf, kPartialBlock)) << 32) |
+            crc32_update(0, buf + kPartialBlock, kPartialBlock);
+    return true;
+}
+
+// 全文SHA-256；读到的长度与遍历时不一致视为失败
+bool hash_full(const std::string& path, DupFile& f, uint64_t& bytes_read, const CancelToken& token) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    Sha256 sha;
+    std::vector<char> buf(256 * 1024);
+    uint64_t total = 0;
+    while (file.read(buf.data(), static_cast<std::streamsize>(buf.size())) || file.gcount() > 0) {
+        if (token.cancelled()) return false;
+        sha.update(buf.data(), static_cast<size_t>(file.gcount()));
+        total += static_cast<uint64_t>(file.gcount());
+    }
+    bytes_read += total;
+    if (file.bad() || total != f.size) return false;
+    sha.finish(f.digest.data());
+    f.complete = true;
+    return true;
+}
+
+} // namespace
+
+// 查找重复文件：
+// 1. 只遍历元数据，按大小分组，大小唯一的文件不读取任何内容
+// 2. 同大小的文件读取首尾各4KB，按(大小, 首尾哈希)再分组
+// 3. 仍有同伴的文件计算全文SHA-256；组内最后一个文件完成时立即确认并输出该组
+// 读取在I/O线程池上进行，并发数按设备决定；按大小降序处理，可回收空间大的组先输出
+DuplicateStats FileCompare::find_duplicates(const std::vector<std::string>& roots, const DuplicateOptions& options,
+                                            const std::function<void(DuplicateGroup&)>& sink) {
+    DuplicateStats stats;
+    try {
+        const CancelToken token = scan_token();
+        auto check_cancel = [&]() {
+            if (token.cancelled()) throw std::runtime_error("Scan cancelled");
+        };
+
+        // 规范化根目录，去掉重复及被其他根包含的根，避免同一文件被计为自身的副本
+        std::vector<fs::path> root_paths;
+        for (const auto& root : roots) root_paths.push_back(normalize_root(root));
+        std::sort(root_paths.begin(), root_paths.end());
+        std::vector<fs::path> unique_roots;
+        for (const auto& root : root_paths) {
+            bool nested = std::any_of(unique_roots.begin(), unique_roots.end(), [&](const fs::path& kept) {
+                auto mismatch = std::mismatch(kept.begin(), kept.end(), root.begin(), root.end());
+                return mismatch.first == kept.end();
+            });
+            if (!nested) unique_roots.push_back(root);
+        }
+
+        // 阶段1：有序遍历只取元数据，路径分量驻留到PathArena（根目录整体作为一个分量）
+        PathArena arena;
+        std::vector<DupFile> files;
+        for (const auto& root : unique_roots) {
+            IgnoreMatcher matcher(options.ignore);
+            SortedDirWalker walker(root, options.ignore_hidden, &matcher);
+            std::vector<uint32_t> ancestors{arena.intern(PathArena::kRoot, root.string())};
+            while (walker.next()) {
+                check_cancel();
+                ancestors.resize(walker.depth());
+                uint32_t node = arena.intern(ancestors.back(), walker.components().back());
+                ancestors.push_back(node);
+                if (walker.is_dir() || walker.is_symlink()) continue;
+                stats.files++;
+                if (walker.size() < std::max<uint64_t>(options.min_size, 1)) continue;
+                DupFile f;
+                f.node = node;
+                f.size = walker.size();
+                files.push_back(f);
+            }
+        }
+
+        // 按大小降序，同大小的相邻；丢弃大小唯一的文件
+        auto by_size = [](const DupFile& a, const DupFile& b) { return a.size > b.size; };
+        std::stable_sort(files.begin(), files.end(), by_size);
+        size_t kept = 0;
+        for (size_t i = 0; i < files.size();) {
+            size_t j = i + 1;
+            while (j < files.size() && files[j].size == files[i].size) ++j;
+            if (j - i >= 2) {
+                for (size_t k = i; k < j; ++k) files[kept++] = files[k];
+            }
+            i = j;
+        }
+        files.resize(kept);
+        stats.size_candidates = files.size();
+
+        const size_t readers = std::max<size_t>(1, std::min(detect_io_concurrency(unique_roots.front()), io_pool.size()));
+        std::atomic<uint64_t> bytes_read{0};
+        // 固定数量的读任务按下标顺序取文件，顺序即大小降序
+        auto read_all = [&](const std::vector<uint32_t>& order, const std::function<void(DupFile&, uint64_t&)>& read) {
+            std::atomic<size_t> next{0};
+            TaskGroup group(io_pool, TaskPriority::Background, token);
+            for (size_t r = 0; r < std::min(readers, order.size()); ++r) {
+                group.run([&]() {
+                    uint64_t local_read = 0;
+                    for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < order.size() && !token.cancelled();) {
+                        read(files[order[i]], local_read);
+                    }
+                    bytes_read.fetch_add(local_read, std::memory_order_relaxed);
+                });
+            }
+            group.wait();
+            check_cancel();
+        };
+
+        // 阶段2：首尾块哈希
+        std::vector<uint32_t> order(files.size());
+        for (size_t i = 0; i < files.size(); ++i) order[i] = static_cast<uint32_t>(i);
+        read_all(order, [&](DupFile& f, uint64_t& local_read) {
+            f.failed = !hash_partial(arena.path(f.node), f, local_read);
+        });
+
+        // 按(大小, 首尾哈希)分组，只保留仍有同伴的文件
+        files.erase(std::remove_if(files.begin(), files.end(), [](const DupFile& f) { return f.failed; }), files.end());
+        std::stable_sort(files.begin(), files.end(), [](const DupFile& a, const DupFile& b) {
+            return a.size != b.size ? a.size > b.size : a.key < b.key;
+        });
+        struct Group {
+            size_t begin;
+            size_t end;
+        };
+        std::vector<Group> groups;
+        for (size_t i = 0; i < files.size();) {
+            size_t j = i + 1;
+            while (j < files.size() && files[j].size == files[i].size && files[j].key == files[i].key) ++j;
+            if (j - i >= 2) groups.push_back(Group{i, j});
+            i = j;
+        }
+
+        // 组内按摘要细分后输出（sink串行调用）
+        std::mutex emit_mutex;
+        auto confirm = [&](const Group& g) {
+            std::vector<const DupFile*> members;
+            for (size_t k = g.begin; k < g.end; ++k) {
+                if (!files[k].failed && files[k].complete) members.push_back(&files[k]);
+            }
+            std::sort(members.begin(), members.end(),
+                      [](const DupFile* a, const DupFile* b) { return a->digest < b->digest; });
+            for (size_t i = 0; i < members.size();) {
+                size_t j = i + 1;
+                while (j < members.size() && members[j]->digest == members[i]->digest) ++j;
+                if (j - i >= 2) {
+                    DuplicateGroup dup;
+                    dup.size = members[i]->size;
+                    dup.hash = Sha256::hex(members[i]->digest.data());
+                    for (size_t k = i; k < j; ++k) dup.paths.push_back(arena.path(members[k]->node));
+                    std::sort(dup.paths.begin(), dup.paths.end());
+                    std::lock_guard<std::mutex> lock(emit_mutex);
+                    stats.groups++;
+                    stats.duplicate_files += j - i - 1;
+                    stats.wasted_bytes += dup.size * (j - i - 1);
+                    sink(dup);
+                }
+                i = j;
+            }
+        };
+
+        // 阶段3：小文件组在阶段2已得到摘要，直接确认；其余文件计算全文哈希
+        std::vector<uint32_t> group_of(files.size(), UINT32_MAX);
+        std::unique_ptr<std::atomic<size_t>[]> remaining(new std::atomic<size_t>[groups.size()]);
+        order.clear();
+        for (size_t g = 0; g < groups.size(); ++g) {
+            size_t pending = 0;
+            for (size_t k = groups[g].begin; k < groups[g].end; ++k) {
+                stats.partial_candidates++;
+                if (files[k].complete) continue;
+                group_of[k] = static_cast<uint32_t>(g);
+                order.push_back(static_cast<uint32_t>(k));
+                pending++;
+            }
+            remaining[g].store(pending, std::memory_order_relaxed);
+            if (pending == 0) confirm(groups[g]);
+        }
+        read_all(order, [&](DupFile& f, uint64_t& local_read) {
+            f.failed = !hash_full(arena.path(f.node), f, local_read, token);
+            uint32_t g = group_of[&f - files.data()];
+            if (remaining[g].fetch_sub(1, std::memory_order_acq_rel) == 1 && !token.cancelled()) {
+                confirm(groups[g]);
+            }
+        });
+        stats.bytes_read = bytes_read.load();
+    } catch (const std::exception& e) {
+        stats.error = exception_to_string(e);
+    }
+    return stats;
+}
+
+// 二进制区域对比：块哈希不同的区间即为差异区域（块大小相同，逐块比较）
+BinaryRegionDiff FileCompare::diff_regions(const std::string& file_a, const std::string& file_b, uint64_t chunk_size) {
+    BinaryRegionDiff result;
+    result.chunk_size = chunk_size = std::max<uint64_t>(chunk_size, 4096);
+    try {
+        ChunkedHash hash_a;
+        ChunkedHash hash_b;
+        bool ok_a = false;
+        TaskGroup group(pool, TaskPriority::Interactive);
+        group.run([&]() { ok_a = chunked_hash(file_a, chunk_size, hash_a, CancelToken(), TaskPriority::Interactive); });
+        bool ok_b = chunked_hash(file_b, chunk_size, hash_b, CancelToken(), TaskPriority::Interactive);
+        group.wait();
+        if (!ok_a || !ok_b) {
+            result.error = "Failed to read file: " + (ok_a ? file_b : file_a);
+            return result;
+        }
+        result.size_a = hash_a.size;
+        result.size_b = hash_b.size;
+        result.crc_a = hash_a.crc32;
+        result.crc_b = hash_b.crc32;
+        result.ranges = hash_a.diff_ranges(hash_b);
     } catch (const std::exception& e) {
         result.error = exception_to_string(e);
     }
     return result;
 }
 
+// 读取压缩包内的文本文件（按行拆分，与read_text_file_lines一致）
+static std::vector<std::string> read_member_lines(const std::string& archive, const std::string& member) {
+    std::string content;
+    std::string error;
+    if (!ArchiveReader::read_member(archive, member, content, kMaxArchiveTextSize, error)) {
+        throw std::runtime_error(error);
+    }
+    std::vector<std::string> lines;
+    for (size_t pos = 0; pos < content.size();) {
+        size_t end = content.find('\n', pos);
+        if (end == std::string::npos) end = content.size();
+        lines.emplace_back(content, pos, end - pos);
+        pos = end + 1;
+    }
+    return lines;
+}
+
 // 单文件对比（Myers算法+文本/二进制区分）
 FileDiffResult FileCompare::compare_files(const std::string& file_a, const std::string& file_b) {
     FileDiffResult result;
     try {
-        // 基础校验
-        if (!fs::exists(file_a) || !fs::is_regular_file(file_a)) {
+        // 基础校验（压缩包内路径在读取时校验）
+        std::string archive_a, member_a, archive_b, member_b;
+        const bool in_archive_a = ArchiveReader::split_member_path(file_a, archive_a, member_a);
+        const bool in_archive_b = ArchiveReader::split_member_path(file_b, archive_b, member_b);
+        if (!in_archive_a && (!fs::exists(file_a) || !fs::is_regular_file(file_a))) {
             result.error = "File A not exists: " + file_a;
             return result;
         }
-        if (!fs::exists(file_b) || !fs::is_regular_file(file_b)) {
+        if (!in_archive_b && (!fs::exists(file_b) || !fs::is_regular_file(file_b))) {
             result.error = "File B not exists: " + file_b;
             return result;
         }
 
         // 基础信息
         result.rel_path = fs::path(file_a).filename().string();
-        result.is_text = is_text_file(file_a) && is_text_file(file_b);
+
+        // UI发起的单文件对比走交互优先级，越过已排队的后台扫描任务
+        TaskGroup group(pool, TaskPriority::Interactive);
+
+        // 两侧并行单遍分类：大小、CRC32、文本判断与编码一次读取完成
+        FileClassification cls_a;
+        FileClassification cls_b;
+        bool ok_a = false;
+        std::string error_a, error_b;
+        group.run([&]() {
+            ok_a = in_archive_a ? ArchiveReader::classify_member(archive_a, member_a, cls_a, error_a)
+                                : classify_path(file_a, cls_a, CancelToken(), TaskPriority::Interactive);
+        });
+        bool ok_b = in_archive_b ? ArchiveReader::classify_member(archive_b, member_b, cls_b, error_b)
+                                 : classify_path(file_b, cls_b, CancelToken(), TaskPriority::Interactive);
+        group.wait();
+        if (!error_a.empty() || !error_b.empty()) {
+            result.error = error_a.empty() ? error_b : error_a;
+            return result;
+        }
+        if (!ok_a || !ok_b) {
+            result.error = "Failed to read file: " + (ok_a ? file_b : file_a);
+            return result;
+        }
+        result.is_text = cls_a.is_text && cls_b.is_text;
+        result.encoding_a = encoding_name(cls_a.encoding);
+        result.encoding_b = encoding_name(cls_b.encoding);
 
         if (result.is_text) {
-            // 文本文件：Myers算法行级对比
-            auto lines_a = read_text_file_lines(file_a);
-            auto lines_b = read_text_file_lines(file_b);
+            // 文本文件：Myers算法行级对比（两侧并行读取）
+            std::vector<std::string> lines_a;
+            group.run([&]() { lines_a = in_archive_a ? read_member_lines(archive_a, member_a) : read_text_file_lines(file_a); });
+            auto lines_b = in_archive_b ? read_member_lines(archive_b, member_b) : read_text_file_lines(file_b);
+            group.wait();
             auto diffs = myers_diff(lines_a, lines_b);
             
             // 转换为结果格式
@@ -133,11 +1251,8 @@ FileDiffResult FileCompare::compare_files(const std::string& file_a, const std::
                 result.diffs.emplace_back(diff.type, diff.content);
             }
         } else {
-            // 二进制文件：CRC32对比
-            std::string crc_a = calculate_crc32(file_a);
-            std::string crc_b = calculate_crc32(file_b);
-            
-            if (crc_a == crc_b) {
+            // 二进制文件：直接比较分类时得到的大小与CRC32
+            if (cls_a.size == cls_b.size && cls_a.crc32 == cls_b.crc32) {
                 result.diffs.emplace_back(SAME, "Binary file is identical");
             } else {
                 result.diffs.emplace_back(DELETE, "Binary file A: " + fs::path(file_a).filename().string());
@@ -3,12 +3,21 @@
 
 #include "utils.h"
 #include "thread_pool.h"
+#include "batch_reader.h"
+#include "scan_store.h"
+#include "ignore_filter.h"
+#include "sorted_walker.h"
+#include "snapshot.h"
+#include "sha256.h"
+#include "chunk_hash.h"
+#include "archive_reader.h"
 #include "myers_diff.h"
 #include <unordered_map>
 #include <atomic>
 #include <mutex>
 #include <future>
 #include <chrono>
+#include <array>
 
 // 文件信息结构体
 struct FileInfo {
@@ -17,16 +26,34 @@ struct FileInfo {
     uint64_t size;
     std::string crc32;
     bool is_text;
+    std::string encoding; // 文本编码（ascii/utf-8/utf-16le/gbk等，二进制为binary）
 };
 
 // 单文件差异结果
 struct FileDiffResult {
     std::string rel_path;
     bool is_text;
+    std::string encoding_a;
+    std::string encoding_b;
     std::string error;
     std::vector<std::pair<DiffType, std::string>> diffs;
 };
 
+// 重命名/移动的文件对
+struct RenamedFile {
+    FileInfo from;     // A侧路径
+    FileInfo to;       // B侧路径
+    bool moved;        // 所在目录不同为移动，否则为重命名
+    double similarity; // 内容相似度，完全相同为1
+};
+
+// 目录级重命名：A侧目录的大部分文件整体出现在B侧另一目录下
+struct RenamedDir {
+    std::string from;
+    std::string to;
+    uint64_t files;    // 随目录一起移动的文件数
+};
+
 // 文件夹差异结果
 struct FolderDiffResult {
     struct DiffFiles {
@@ -34,8 +61,116 @@ struct FolderDiffResult {
         std::vector<FileInfo> deleted;  // A有B无
         std::vector<FileInfo> modified; // 路径相同内容不同
         std::vector<FileInfo> same;     // 完全相同
+        std::vector<RenamedFile> renamed; // 由删除+新增配对得到的重命名/移动
+        std::vector<RenamedDir> renamed_dirs;
     } diffs;
     uint64_t total_files = 0;
+    uint64_t same_count = 0;       // 相同文件数（快照对比时包含被整体跳过的相同子树）
+    uint64_t skipped_subtrees = 0; // 快照对比中按目录哈希整体跳过的子树数
+    std::string error;
+};
+
+// 有序对比条目状态
+enum class EntryStatus : uint8_t {
+    Same = 0,     // 两侧相同（目录表示两侧都存在）
+    Modified = 1, // 路径相同内容不同
+    Added = 2,    // B有A无
+    Deleted = 3   // A有B无
+};
+
+// 有序对比输出条目（按路径先序排列，目录在其子项之前）
+struct SortedDiffEntry {
+    std::string rel_path;
+    uint32_t depth;
+    bool is_dir;
+    EntryStatus status;
+    uint64_t size_a;
+    uint64_t size_b;
+    int64_t mtime_a; // 毫秒时间戳，该侧不存在为0
+    int64_t mtime_b;
+    uint32_t crc_a;
+    uint32_t crc_b;
+};
+
+// 有序对比统计
+struct SortedDiffStats {
+    uint64_t added = 0;
+    uint64_t deleted = 0;
+    uint64_t modified = 0;
+    uint64_t same = 0;
+    std::string error;
+};
+
+// 目录差异状态（与DirDiff.js的DiffStatus一致）
+enum class DiffStatus : uint8_t {
+    Identical = 0,
+    LeftOnly = 1,
+    RightOnly = 2,
+    Different = 3
+};
+
+// 两侧对齐的目录差异树，按先序扁平存储，节点0为根，父节点下标总小于子节点
+// 一侧不存在的节点在该侧显示为空节点（EMPTY_NODE），目录状态已按子项聚合
+struct DirDiffTree {
+    static constexpr uint32_t kNoParent = UINT32_MAX;
+    struct Node {
+        uint32_t parent;
+        uint32_t level;
+        std::string name;
+        bool is_folder;
+        bool has_left;
+        bool has_right;
+        DiffStatus status;
+        uint64_t size_a;
+        uint64_t size_b;
+        int64_t mtime_a;
+        int64_t mtime_b;
+    };
+    std::string root_a;
+    std::string root_b;
+    std::vector<Node> nodes;
+    // 按条目统计（目录两侧都存在计为相同，不含根）
+    uint64_t identical = 0;
+    uint64_t different = 0;
+    uint64_t left_only = 0;
+    uint64_t right_only = 0;
+    std::string error;
+};
+
+// 二进制区域对比结果：按块哈希定位的不同字节区间
+struct BinaryRegionDiff {
+    uint64_t size_a = 0;
+    uint64_t size_b = 0;
+    uint64_t chunk_size = 0;
+    uint32_t crc_a = 0;
+    uint32_t crc_b = 0;
+    std::vector<std::pair<uint64_t, uint64_t>> ranges; // [begin, end)
+    std::string error;
+};
+
+// 重复文件组：内容完全相同（SHA-256一致）的一组文件
+struct DuplicateGroup {
+    uint64_t size;
+    std::string hash;               // SHA-256十六进制
+    std::vector<std::string> paths; // 按路径排序
+};
+
+// 重复文件查找选项
+struct DuplicateOptions {
+    bool ignore_hidden = false;
+    uint64_t min_size = 1; // 小于该大小的文件不参与（默认排除空文件）
+    IgnoreOptions ignore;
+};
+
+// 重复文件查找统计：各阶段剩余的候选数反映实际读取量
+struct DuplicateStats {
+    uint64_t files = 0;              // 遍历到的文件数
+    uint64_t size_candidates = 0;    // 存在同大小文件的候选数
+    uint64_t partial_candidates = 0; // 首尾块哈希后仍需读取全文的候选数
+    uint64_t groups = 0;
+    uint64_t duplicate_files = 0;    // 各组中除保留一份外的文件数
+    uint64_t wasted_bytes = 0;       // 删除重复副本可回收的字节数
+    uint64_t bytes_read = 0;
     std::string error;
 };
 
@@ -44,17 +179,78 @@ class FileCompare {
 public:
     FileCompare();
     
-    // 多线程扫描文件夹
-    std::unordered_map<std::string, FileInfo> scan_folder(const std::string& folder_path, bool ignore_hidden);
+    // 多线程扫描文件夹（ignore为gitignore语法的忽略规则，被忽略的目录遍历时直接剪枝）
+    std::unordered_map<std::string, FileInfo> scan_folder(const std::string& folder_path, bool ignore_hidden,
+                                                          const IgnoreOptions& ignore = IgnoreOptions());
+
+    // 多线程扫描文件夹，结果写入紧凑存储（路径驻留+按列存储，适合百万级文件）
+    // folder_path为压缩包（tar/tar.gz/zip/gz）时按虚拟目录树流式读取，full_path形如"<压缩包>!/<包内路径>"
+    ScanStore scan_folder_store(const std::string& folder_path, bool ignore_hidden,
+                                const IgnoreOptions& ignore = IgnoreOptions());
     
     // 文件夹对比（对标BeyondCompare）
-    FolderDiffResult compare_folders(const std::string& folder_a, const std::string& folder_b, bool ignore_hidden);
+    // detect_renames为true时对删除/新增做重命名与移动检测
+    // 任一侧为快照文件时走快照对比：另一侧按快照增量生成（大小与修改时间未变的文件不再读取），
+    // 两侧哈希相同的目录整体跳过，此时same只列出被实际比较的文件
+    FolderDiffResult compare_folders(const std::string& folder_a, const std::string& folder_b, bool ignore_hidden,
+                                     const IgnoreOptions& ignore = IgnoreOptions(), bool detect_renames = true);
     
-    // 单文件对比（Myers算法）
+    // 有序文件夹对比：两侧逐目录排序遍历并归并，条目按路径顺序分批交给sink
+    // 工作内存与目录深度成正比，不需要先扫描出完整列表
+    SortedDiffStats compare_folders_sorted(const std::string& folder_a, const std::string& folder_b, bool ignore_hidden,
+                                           const std::function<void(std::vector<SortedDiffEntry>&)>& sink,
+                                           const IgnoreOptions& ignore = IgnoreOptions());
+
+    // 生成文件夹快照；baseline是同一文件夹（按文件系统身份判断）的快照时，大小与修改时间未变的文件直接沿用其CRC，不再读取
+    FolderSnapshot build_snapshot(const std::string& folder_path, bool ignore_hidden,
+                                  const IgnoreOptions& ignore = IgnoreOptions(),
+                                  const FolderSnapshot* baseline = nullptr);
+
+    // 快照对比：沿两棵Merkle树同步下降，哈希相同的子树不再访问
+    FolderDiffResult compare_snapshots(const FolderSnapshot& snap_a, const FolderSnapshot& snap_b);
+
+    // 两侧对齐的目录差异树（供文件夹对比界面直接渲染）
+    DirDiffTree diff_tree(const std::string& folder_a, const std::string& folder_b, bool ignore_hidden,
+                          const IgnoreOptions& ignore = IgnoreOptions());
+
+    // 查找重复文件：按大小 -> 首尾4KB块哈希 -> 全文SHA-256逐级筛选，只读取仍有同伴的文件
+    // 每组确认后立即交给sink（在线程池线程中串行调用），大文件组优先
+    DuplicateStats find_duplicates(const std::vector<std::string>& roots, const DuplicateOptions& options,
+                                   const std::function<void(DuplicateGroup&)>& sink);
+
+    // 单文件对比（Myers算法），任一侧可为压缩包内路径"<压缩包>!/<包内路径>"
     FileDiffResult compare_files(const std::string& file_a, const std::string& file_b);
 
+    // 二进制区域对比：两文件按块哈希，只返回内容不同的区间；扫描时已计算过的大文件直接复用块哈希
+    BinaryRegionDiff diff_regions(const std::string& file_a, const std::string& file_b,
+                                  uint64_t chunk_size = ChunkedHash::kDefaultChunkSize);
+
+    // 单文件分类：超过kChunkedHashThreshold的文件分块并行哈希并缓存块哈希，其余顺序读取
+    // priority为分块任务的优先级：UI单文件对比传Interactive，扫描传Background
+    bool classify_path(const std::string& path, FileClassification& out, const CancelToken& token = CancelToken(),
+                       TaskPriority priority = TaskPriority::Background);
+
+    // 取消进行中的扫描/文件夹对比（协作式，已排队的哈希任务直接跳过）
+    void cancel_scans();
+
 private:
-    ThreadPool pool; // 全局线程池
+    CancelToken scan_token();
+    void detect_renames(const ScanStore& store_a, const ScanStore& store_b,
+                        std::vector<uint32_t>& deleted_rows, std::vector<uint32_t>& added_rows,
+                        FolderDiffResult& result);
+    static fs::path normalize_root(const std::string& folder_path);
+    ScanStore scan_archive_store(const std::string& archive_path, bool ignore_hidden, const IgnoreOptions& ignore);
+    bool chunked_hash(const std::string& path, uint64_t chunk_size, ChunkedHash& out, const CancelToken& token,
+                      TaskPriority priority);
+
+    // I/O线程上限：单次扫描实际使用的读线程数由detect_io_concurrency按设备决定
+    static constexpr size_t kMaxIoReaders = 16;
+
+    ThreadPool pool;    // CPU线程池：哈希、文本判断、差异计算
+    ThreadPool io_pool; // I/O线程池：文件读取
+    std::mutex cancel_mutex;
+    CancelSource scan_cancel;
+    ChunkHashCache chunk_cache; // 大文件块哈希，供后续二进制对比复用
 };
 
 #endif // FILE_COMPARE_H
\ No newline at end of file
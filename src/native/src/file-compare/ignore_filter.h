@@ -0,0 +1,228 @@
+#ifndef IGNORE_FILTER_H
+#define IGNORE_FILTER_H
+
+#include "utils.h"
+#include <vector>
+#include <string>
+#include <string_view>
+
+// 忽略选项（gitignore语法）
+struct IgnoreOptions {
+    std::vector<std::string> patterns; // 全局模式，相对对比根目录，优先级低于.gitignore
+    bool use_gitignore = false;        // 读取各级目录下的.gitignore
+};
+
+// glob匹配（路径模式）：*与?不跨越'/'，整段的**匹配零或多级目录，支持[a-z]/[!x]与反斜杠转义
+inline bool glob_match(const char* p, const char* pe, const char* t, const char* te, const char* pstart) {
+    while (p < pe) {
+        switch (*p) {
+            case '?':
+                if (t == te || *t == '/') return false;
+                ++p;
+                ++t;
+                break;
+            case '*': {
+                const char* q = p;
+                while (q < pe && *q == '*') ++q;
+                bool globstar = q - p >= 2 && (p == pstart || p[-1] == '/') && (q == pe || *q == '/');
+                if (globstar) {
+                    if (q == pe) return true; // 结尾的/**匹配其下全部内容
+                    // "**/"匹配零或多级目录
+                    const char* rest = q + 1;
+                    for (const char* s = t;;) {
+                        if (glob_match(rest, pe, s, te, pstart)) return true;
+                        s = std::find(s, te, '/');
+                        if (s == te) return false;
+                        ++s;
+                    }
+                }
+                if (q == pe) return std::find(t, te, '/') == te;
+                for (const char* s = t;; ++s) {
+                    if (glob_match(q, pe, s, te, pstart)) return true;
+                    if (s == te || *s == '/') return false;
+                }
+            }
+            case '[': {
+                if (t == te || *t == '/') return false;
+                const char* q = p + 1;
+                bool negate = q < pe && (*q == '!' || *q == '^');
+                if (negate) ++q;
+                bool matched = false;
+                bool first = true;
+                const uint8_t ch = static_cast<uint8_t>(*t);
+                while (q < pe && (first || *q != ']')) {
+                    first = false;
+                    if (*q == '\\' && q + 1 < pe) ++q;
+                    uint8_t lo = static_cast<uint8_t>(*q);
+                    uint8_t hi = lo;
+                    if (q + 2 < pe && q[1] == '-' && q[2] != ']') {
+                        q += 2;
+                        if (*q == '\\' && q + 1 < pe) ++q;
+                        hi = static_cast<uint8_t>(*q);
+                    }
+                    if (ch >= lo && ch <= hi) matched = true;
+                    ++q;
+                }
+                if (q >= pe) {
+                    // 未闭合的[按字面匹配
+                    if (*t != '[') return false;
+                    ++p;
+                    ++t;
+                    break;
+                }
+                if (matched == negate) return false;
+                p = q + 1;
+                ++t;
+                break;
+            }
+            case '\\':
+                if (p + 1 < pe) ++p;
+                [[fallthrough]];
+            default:
+                if (t == te || *t != *p) return false;
+                ++p;
+                ++t;
+                break;
+        }
+    }
+    return t == te;
+}
+
+// 单条已编译的忽略规则
+struct IgnoreRule {
+    enum class Kind : uint8_t {
+        Literal, // 无通配符，直接比较
+        Suffix,  // "*.ext"形式，比较后缀
+        Glob     // 通用glob
+    };
+
+    std::string pattern; // 已去掉'!'、首尾'/'与行尾空白
+    Kind kind = Kind::Glob;
+    bool negate = false;   // "!"开头：重新包含
+    bool dir_only = false; // "/"结尾：只匹配目录
+    bool basename = false; // 不含'/'：匹配任意层级的名字
+    size_t base_len = 0;   // 所在.gitignore目录（相对根）的长度，全局规则为0
+
+    // 解析一行gitignore，空行/注释返回false
+    static bool parse(std::string_view line, size_t base_len, IgnoreRule& out) {
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) line.remove_suffix(1);
+        // 行尾空白除非被反斜杠转义，否则忽略
+        while (!line.empty() && line.back() == ' ' && !(line.size() >= 2 && line[line.size() - 2] == '\\')) {
+            line.remove_suffix(1);
+        }
+        if (line.empty() || line[0] == '#') return false;
+
+        IgnoreRule rule;
+        rule.base_len = base_len;
+        if (line[0] == '!') {
+            rule.negate = true;
+            line.remove_prefix(1);
+        } else if (line.size() >= 2 && line[0] == '\\' && (line[1] == '!' || line[1] == '#')) {
+            line.remove_prefix(1);
+        }
+        if (!line.empty() && line.back() == '/') {
+            rule.dir_only = true;
+            line.remove_suffix(1);
+        }
+        if (line.empty()) return false;
+
+        rule.basename = line.find('/') == std::string_view::npos;
+        if (!rule.basename && line[0] == '/') line.remove_prefix(1);
+        rule.pattern.assign(line);
+
+        bool has_meta = rule.pattern.find_first_of("*?[\\") != std::string::npos;
+        if (!has_meta) {
+            rule.kind = Kind::Literal;
+        } else if (rule.basename && rule.pattern.size() > 1 && rule.pattern[0] == '*' &&
+                   rule.pattern.find_first_of("*?[\\", 1) == std::string::npos) {
+            rule.kind = Kind::Suffix;
+            rule.pattern.erase(0, 1);
+        } else {
+            rule.kind = Kind::Glob;
+        }
+        out = std::move(rule);
+        return true;
+    }
+
+    // rel为相对规则所在目录的路径，name为最后一个分量
+    bool matches(std::string_view rel, std::string_view name, bool is_dir) const {
+        if (dir_only && !is_dir) return false;
+        std::string_view subject = basename ? name : rel;
+        switch (kind) {
+            case Kind::Literal:
+                return subject == pattern;
+            case Kind::Suffix:
+                return subject.size() >= pattern.size() &&
+                       subject.compare(subject.size() - pattern.size(), pattern.size(), pattern) == 0;
+            case Kind::Glob:
+            default: {
+                const char* p = pattern.data();
+                return glob_match(p, p + pattern.size(), subject.data(), subject.data() + subject.size(), p);
+            }
+        }
+    }
+};
+
+// 遍历期忽略判断：规则按目录层级入栈，深层与靠后的规则优先
+// 每个路径分量在打开/读取前单独判断，被忽略的目录整棵子树不产生任何I/O
+// 非线程安全，供单线程深度优先遍历使用（enter/leave成对调用）
+class IgnoreMatcher {
+public:
+    // 遍历方负责对根目录调用enter(root, "")
+    explicit IgnoreMatcher(const IgnoreOptions& options) : use_gitignore(options.use_gitignore) {
+        for (const auto& line : options.patterns) {
+            IgnoreRule rule;
+            if (IgnoreRule::parse(line, 0, rule)) rules.push_back(std::move(rule));
+        }
+    }
+
+    // 没有任何规则且不读.gitignore时可跳过判断
+    bool inactive() const { return rules.empty() && !use_gitignore; }
+
+    // 进入目录：加载该目录的.gitignore（rel_dir为相对根目录的路径，分隔符'/'）
+    void enter(const fs::path& dir, std::string_view rel_dir) {
+        levels.push_back(rules.size());
+        if (!use_gitignore) return;
+        std::ifstream file(dir / ".gitignore", std::ios::binary);
+        if (!file.is_open()) return;
+        std::string line;
+        while (std::getline(file, line)) {
+            IgnoreRule rule;
+            if (IgnoreRule::parse(line, rel_dir.size(), rule)) rules.push_back(std::move(rule));
+        }
+    }
+
+    void leave() {
+        rules.resize(levels.back());
+        levels.pop_back();
+    }
+
+    // rel_path为相对根目录的路径（分隔符'/'）
+    bool ignored(std::string_view rel_path, bool is_dir) const {
+        size_t slash = rel_path.rfind('/');
+        std::string_view name = slash == std::string_view::npos ? rel_path : rel_path.substr(slash + 1);
+        for (size_t i = rules.size(); i-- > 0;) {
+            const IgnoreRule& rule = rules[i];
+            std::string_view rel = rule.base_len == 0 ? rel_path : rel_path.substr(rule.base_len + 1);
+            if (rule.matches(rel, name, is_dir)) return !rule.negate;
+        }
+        return false;
+    }
+
+    // 拼接相对路径
+    static std::string join(std::string_view rel_dir, std::string_view name) {
+        std::string out;
+        out.reserve(rel_dir.size() + name.size() + 1);
+        out.append(rel_dir);
+        if (!out.empty()) out.push_back('/');
+        out.append(name);
+        return out;
+    }
+
+private:
+    bool use_gitignore;
+    std::vector<IgnoreRule> rules;
+    std::vector<size_t> levels; // 每层目录规则在rules中的起始位置
+};
+
+#endif // IGNORE_FILTER_H
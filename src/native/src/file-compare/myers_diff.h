@@ -44,11 +44,12 @@ inline std::vector<DiffResult> myers_diff(const std::vector<std::string>& a, con
 
     const int max_d = n + m;
     std::vector<int> v(2 * max_d + 1, 0);
-    std::vector<std::vector<std::pair<int, int>>> trace;
+    // 每轮开始前保存v[-d..d]，回溯时按轮次取用（总量O(D^2)）
+    std::vector<std::vector<int>> trace;
 
     // Myers算法主循环
     for (int d = 0; d <= max_d; ++d) {
-        trace.emplace_back();
+        trace.emplace_back(v.begin() + (max_d - d), v.begin() + (max_d + d + 1));
         for (int k = -d; k <= d; k += 2) {
             int x = (k == -d || (k != d && v[k - 1 + max_d] < v[k + 1 + max_d])) 
                     ? v[k + 1 + max_d] : v[k - 1 + max_d] + 1;
@@ -66,7 +67,6 @@ inline std::vector<DiffResult> myers_diff(const std::vector<std::string>& a, con
             }
 
             v[k + max_d] = x;
-            trace.back().emplace_back(x, y);
 
             // 找到完整路径
             if (x >= n && y >= m) goto reconstruct_path;
@@ -77,27 +77,30 @@ reconstruct_path:
     // 路径重构（从后往前）
     std::vector<DiffResult> result;
     int x = n, y = m;
-    for (int d = trace.size() - 1; d >= 0; --d) {
-        auto& step = trace[d];
+    for (int d = static_cast<int>(trace.size()) - 1; d > 0; --d) {
+        const auto& step = trace[d]; // 第d-1轮结束时的v，下标偏移d
         int k = x - y;
-        int prev_k = (k == -d || (k != d && v[k - 1 + max_d] < v[k + 1 + max_d])) ? k + 1 : k - 1;
-        
-        int prev_x = (prev_k == k + 1) ? v[prev_k + max_d] : v[prev_k + max_d] + 1;
+        int prev_k = (k == -d || (k != d && step[k - 1 + d] < step[k + 1 + d])) ? k + 1 : k - 1;
+        int prev_x = step[prev_k + d];
         int prev_y = prev_x - prev_k;
+        // 编辑一步后的位置，之后到(x, y)为连续相同行
+        int mid_x = (prev_k == k + 1) ? prev_x : prev_x + 1;
 
-        // 输出差异
-        while (x > prev_x && y > prev_y) {
+        while (x > mid_x) {
             x--; y--;
             result.push_back({SAME, a[x]});
         }
-        while (x > prev_x) {
-            x--;
-            result.push_back({DELETE, a[x]});
-        }
-        while (y > prev_y) {
-            y--;
-            result.push_back({ADD, b[y]});
+        if (prev_k == k + 1) {
+            result.push_back({ADD, b[prev_y]});
+        } else {
+            result.push_back({DELETE, a[prev_x]});
         }
+        x = prev_x;
+        y = prev_y;
+    }
+    while (x > 0 && y > 0) {
+        x--; y--;
+        result.push_back({SAME, a[x]});
     }
 
     // 反转结果恢复顺序
@@ -0,0 +1,212 @@
+#ifndef SCAN_STORE_H
+#define SCAN_STORE_H
+
+#include "utils.h"
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+// 路径分量驻留池
+// 每个路径分量只存一次：节点记录父节点下标与名字在字符池中的位置，
+// (父节点, 名字)到节点的映射用开放寻址表；父节点下标总是小于子节点
+class PathArena {
+public:
+    static constexpr uint32_t kRoot = 0;
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    PathArena() {
+        nodes.push_back(Node{kNone, 0, 0});
+        slots.assign(1024, 0);
+    }
+
+    // 驻留一个分量，已存在则返回原节点
+    uint32_t intern(uint32_t parent, std::string_view name) {
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash(parent, name) & mask;; i = (i + 1) & mask) {
+            uint32_t slot = slots[i];
+            if (slot == 0) {
+                uint32_t id = static_cast<uint32_t>(nodes.size());
+                nodes.push_back(Node{parent, static_cast<uint32_t>(names.size()), static_cast<uint32_t>(name.size())});
+                names.insert(names.end(), name.begin(), name.end());
+                slots[i] = id + 1;
+                // 负载因子超过1/2时扩容
+                if (nodes.size() * 2 > slots.size()) rehash(slots.size() * 2);
+                return id;
+            }
+            if (matches(slot - 1, parent, name)) return slot - 1;
+        }
+    }
+
+    uint32_t find(uint32_t parent, std::string_view name) const {
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash(parent, name) & mask;; i = (i + 1) & mask) {
+            uint32_t slot = slots[i];
+            if (slot == 0) return kNone;
+            if (matches(slot - 1, parent, name)) return slot - 1;
+        }
+    }
+
+    // 按分量驻留整条相对路径
+    uint32_t intern_path(const fs::path& rel_path) {
+        uint32_t node = kRoot;
+        for (const auto& part : rel_path) {
+            std::string s = part.string();
+            if (s.empty() || s == ".") continue;
+            node = intern(node, s);
+        }
+        return node;
+    }
+
+    uint32_t find_path(const fs::path& rel_path) const {
+        uint32_t node = kRoot;
+        for (const auto& part : rel_path) {
+            std::string s = part.string();
+            if (s.empty() || s == ".") continue;
+            node = find(node, s);
+            if (node == kNone) return kNone;
+        }
+        return node;
+    }
+
+    uint32_t parent(uint32_t node) const { return nodes[node].parent; }
+
+    std::string_view name(uint32_t node) const {
+        const Node& n = nodes[node];
+        return std::string_view(names.data() + n.name_offset, n.name_len);
+    }
+
+    // 还原相对路径（使用平台分隔符）
+    std::string path(uint32_t node) const {
+        std::vector<uint32_t> chain;
+        for (uint32_t n = node; n != kRoot && n != kNone; n = nodes[n].parent) {
+            chain.push_back(n);
+        }
+        std::string out;
+        for (size_t i = chain.size(); i-- > 0;) {
+            if (!out.empty()) out.push_back(static_cast<char>(fs::path::preferred_separator));
+            out.append(name(chain[i]));
+        }
+        return out;
+    }
+
+    size_t node_count() const { return nodes.size(); }
+
+    size_t memory_bytes() const {
+        return nodes.capacity() * sizeof(Node) + names.capacity() + slots.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    struct Node {
+        uint32_t parent;
+        uint32_t name_offset;
+        uint32_t name_len;
+    };
+
+    static uint64_t hash(uint32_t parent, std::string_view name) {
+        uint64_t h = 14695981039346656037ULL ^ (static_cast<uint64_t>(parent) * 0x9E3779B97F4A7C15ULL);
+        for (char c : name) {
+            h ^= static_cast<uint8_t>(c);
+            h *= 1099511628211ULL;
+        }
+        return h ^ (h >> 29);
+    }
+
+    bool matches(uint32_t node, uint32_t parent, std::string_view name) const {
+        return nodes[node].parent == parent && this->name(node) == name;
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<uint32_t> next(capacity, 0);
+        size_t mask = capacity - 1;
+        for (uint32_t id = 1; id < nodes.size(); ++id) {
+            size_t i = hash(nodes[id].parent, name(id)) & mask;
+            while (next[i] != 0) i = (i + 1) & mask;
+            next[i] = id + 1;
+        }
+        slots.swap(next);
+    }
+
+    std::vector<Node> nodes;
+    std::vector<char> names;
+    std::vector<uint32_t> slots; // 节点下标+1，0为空槽
+};
+
+// 紧凑扫描结果：路径驻留在PathArena，其余字段按列存储（struct-of-arrays）
+// 节点到行号用与节点数等长的数组直接索引
+class ScanStore {
+public:
+    static constexpr uint32_t kNoRow = UINT32_MAX;
+
+    explicit ScanStore(std::string root = std::string()) : root(std::move(root)) {}
+
+    // 添加文件（路径相同则覆盖），返回行号
+    uint32_t add(const fs::path& rel_path, const FileClassification& cls) {
+        uint32_t node = arena.intern_path(rel_path);
+        if (node >= node_rows.size()) node_rows.resize(arena.node_count(), kNoRow);
+        uint32_t row = node_rows[node];
+        if (row == kNoRow) {
+            row = static_cast<uint32_t>(nodes.size());
+            node_rows[node] = row;
+            nodes.push_back(node);
+            sizes.push_back(cls.size);
+            crcs.push_back(cls.crc32);
+            encodings.push_back(static_cast<uint8_t>(cls.encoding));
+        } else {
+            sizes[row] = cls.size;
+            crcs[row] = cls.crc32;
+            encodings[row] = static_cast<uint8_t>(cls.encoding);
+        }
+        return row;
+    }
+
+    uint32_t find(const fs::path& rel_path) const { return row_of_node(arena.find_path(rel_path)); }
+
+    uint32_t row_of_node(uint32_t node) const {
+        return node < node_rows.size() ? node_rows[node] : kNoRow;
+    }
+
+    // 把other的每个路径节点映射到本存储的节点（不存在为kNone）
+    // 依赖父节点下标小于子节点，单遍即可完成
+    std::vector<uint32_t> map_nodes_from(const ScanStore& other) const {
+        const PathArena& from = other.arena;
+        std::vector<uint32_t> mapped(from.node_count(), PathArena::kNone);
+        mapped[PathArena::kRoot] = PathArena::kRoot;
+        for (uint32_t n = 1; n < from.node_count(); ++n) {
+            uint32_t parent = mapped[from.parent(n)];
+            mapped[n] = parent == PathArena::kNone ? PathArena::kNone : arena.find(parent, from.name(n));
+        }
+        return mapped;
+    }
+
+    size_t size() const { return nodes.size(); }
+    uint32_t node(size_t row) const { return nodes[row]; }
+    uint64_t file_size(size_t row) const { return sizes[row]; }
+    uint32_t crc32(size_t row) const { return crcs[row]; }
+    TextEncoding encoding(size_t row) const { return static_cast<TextEncoding>(encodings[row]); }
+    bool is_text(size_t row) const { return encoding(row) != TextEncoding::Binary; }
+
+    std::string rel_path(size_t row) const { return arena.path(nodes[row]); }
+    std::string full_path(size_t row) const { return (fs::path(root) / rel_path(row)).string(); }
+    const std::string& root_path() const { return root; }
+    const PathArena& paths() const { return arena; }
+
+    size_t memory_bytes() const {
+        return arena.memory_bytes() + node_rows.capacity() * sizeof(uint32_t) +
+               nodes.capacity() * sizeof(uint32_t) + sizes.capacity() * sizeof(uint64_t) +
+               crcs.capacity() * sizeof(uint32_t) + encodings.capacity();
+    }
+
+private:
+    std::string root;
+    PathArena arena;
+    std::vector<uint32_t> node_rows; // 节点 -> 行号
+
+    // 按行的列数据
+    std::vector<uint32_t> nodes;
+    std::vector<uint64_t> sizes;
+    std::vector<uint32_t> crcs;
+    std::vector<uint8_t> encodings;
+};
+
+#endif // SCAN_STORE_H
@@ -0,0 +1,218 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "utils.h"
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+// 文件夹快照：按先序存储的Merkle树
+// 文件哈希由(大小, CRC32)得到，目录哈希按排序后的子项(名字, 哈希)依次混合，
+// 两个快照中哈希相同的目录即可整体视为相同，无需再访问其子树
+//
+// 二进制格式（主机字节序，头部带字节序标记）：
+//   Header | 根路径字节 | Record[node_count] | 名字池
+class FolderSnapshot {
+public:
+    static constexpr uint32_t kNone = UINT32_MAX;
+    static constexpr char kMagic[8] = {'D', 'T', 'S', 'N', 'A', 'P', '0', '1'};
+    static constexpr uint32_t kVersion = 1;
+
+    // 单个节点（同时也是文件中的记录格式）
+    struct Record {
+        uint32_t parent;    // 父节点下标，根为kNone
+        uint32_t end;       // 子树结束位置（先序中最后一个后代之后），文件为自身+1
+        uint32_t name_off;
+        uint32_t name_len;
+        uint32_t files;     // 子树中的文件数，文件为1
+        uint32_t crc32;
+        uint64_t size;
+        int64_t mtime;      // 毫秒时间戳
+        uint64_t hash;      // Merkle哈希
+        uint8_t is_dir;
+        uint8_t encoding;   // TextEncoding
+        uint8_t reserved[6];
+    };
+    static_assert(sizeof(Record) == 56, "snapshot record layout");
+
+    explicit FolderSnapshot(std::string root = std::string()) : root(std::move(root)) {}
+
+    // 构建：按先序追加节点（父节点必须已存在），全部追加后调用finish
+    uint32_t add(uint32_t parent, std::string_view name, bool is_dir, uint64_t size, int64_t mtime) {
+        Record r{};
+        r.parent = parent;
+        r.end = 0;
+        r.name_off = static_cast<uint32_t>(names.size());
+        r.name_len = static_cast<uint32_t>(name.size());
+        r.is_dir = is_dir ? 1 : 0;
+        r.size = is_dir ? 0 : size;
+        r.mtime = mtime;
+        names.insert(names.end(), name.begin(), name.end());
+        records.push_back(r);
+        return static_cast<uint32_t>(records.size() - 1);
+    }
+
+    void set_content(uint32_t index, uint32_t crc, TextEncoding encoding) {
+        records[index].crc32 = crc;
+        records[index].encoding = static_cast<uint8_t>(encoding);
+    }
+
+    // 计算子树范围、文件数与哈希：子节点下标总大于父节点，逆序一遍即可
+    void finish() {
+        for (size_t i = 0; i < records.size(); ++i) {
+            records[i].end = static_cast<uint32_t>(i + 1);
+            records[i].files = records[i].is_dir ? 0 : 1;
+        }
+        for (size_t i = records.size(); i-- > 1;) {
+            Record& parent = records[records[i].parent];
+            parent.end = std::max(parent.end, records[i].end);
+            parent.files += records[i].files;
+        }
+        for (size_t i = records.size(); i-- > 0;) {
+            Record& r = records[i];
+            if (!r.is_dir) {
+                r.hash = mix64(r.size * 0x9E3779B97F4A7C15ULL ^ r.crc32);
+                continue;
+            }
+            uint64_t h = 0xcbf29ce484222325ULL;
+            for (uint32_t c = static_cast<uint32_t>(i) + 1; c < r.end; c = records[c].end) {
+                h = mix64(h ^ fnv1a(name(c)));
+                h = mix64(h ^ records[c].hash ^ records[c].is_dir);
+            }
+            r.hash = h;
+        }
+    }
+
+    size_t size() const { return records.size(); }
+    const Record& node(uint32_t i) const { return records[i]; }
+    bool is_dir(uint32_t i) const { return records[i].is_dir != 0; }
+    std::string_view name(uint32_t i) const {
+        return std::string_view(names.data() + records[i].name_off, records[i].name_len);
+    }
+    const std::string& root_path() const { return root; }
+    uint32_t file_count() const { return records.empty() ? 0 : records[0].files; }
+
+    std::string rel_path(uint32_t i) const {
+        std::vector<uint32_t> chain;
+        for (uint32_t n = i; n != 0 && n != kNone; n = records[n].parent) chain.push_back(n);
+        std::string out;
+        for (size_t k = chain.size(); k-- > 0;) {
+            if (!out.empty()) out.push_back(static_cast<char>(fs::path::preferred_separator));
+            out.append(name(chain[k]));
+        }
+        return out;
+    }
+
+    std::string full_path(uint32_t i) const { return (fs::path(root) / rel_path(i)).string(); }
+
+    size_t memory_bytes() const { return records.capacity() * sizeof(Record) + names.capacity(); }
+
+    bool save(const std::string& path, std::string& error) const {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            error = "Failed to open snapshot for writing: " + path;
+            return false;
+        }
+        Header h{};
+        std::memcpy(h.magic, kMagic, sizeof(kMagic));
+        h.byte_order = kByteOrderMark;
+        h.version = kVersion;
+        h.node_count = records.size();
+        h.names_bytes = names.size();
+        h.root_len = root.size();
+        file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        file.write(root.data(), static_cast<std::streamsize>(root.size()));
+        file.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(Record)));
+        file.write(names.data(), static_cast<std::streamsize>(names.size()));
+        if (!file) {
+            error = "Failed to write snapshot: " + path;
+            return false;
+        }
+        return true;
+    }
+
+    static bool load(const std::string& path, FolderSnapshot& out, std::string& error) {
+        std::ifstream file(path, std::ios::binary);
+        Header h{};
+        if (!file.is_open() || !file.read(reinterpret_cast<char*>(&h), sizeof(h)) ||
+            std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) {
+            error = "Invalid snapshot file: " + path;
+            return false;
+        }
+        if (h.byte_order != kByteOrderMark || h.version != kVersion) {
+            error = "Unsupported snapshot version or byte order: " + path;
+            return false;
+        }
+        FolderSnapshot snap;
+        snap.root.resize(h.root_len);
+        snap.records.resize(h.node_count);
+        snap.names.resize(h.names_bytes);
+        file.read(snap.root.data(), static_cast<std::streamsize>(h.root_len));
+        file.read(reinterpret_cast<char*>(snap.records.data()), static_cast<std::streamsize>(h.node_count * sizeof(Record)));
+        file.read(snap.names.data(), static_cast<std::streamsize>(h.names_bytes));
+        if (!file || !snap.valid()) {
+            error = "Corrupted snapshot file: " + path;
+            return false;
+        }
+        out = std::move(snap);
+        return true;
+    }
+
+    // 是否为快照文件（按文件头判断）
+    static bool is_snapshot_file(const std::string& path) {
+        std::error_code ec;
+        if (!fs::is_regular_file(path, ec)) return false;
+        std::ifstream file(path, std::ios::binary);
+        char magic[sizeof(kMagic)] = {};
+        return file.read(magic, sizeof(magic)) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+    }
+
+private:
+    static constexpr uint32_t kByteOrderMark = 0x01020304;
+
+    struct Header {
+        char magic[8];
+        uint32_t byte_order;
+        uint32_t version;
+        uint64_t node_count;
+        uint64_t names_bytes;
+        uint64_t root_len;
+    };
+
+    static uint64_t mix64(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    static uint64_t fnv1a(std::string_view s) {
+        uint64_t h = 14695981039346656037ULL;
+        for (char c : s) {
+            h ^= static_cast<uint8_t>(c);
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+    // 加载后校验下标范围，避免损坏的文件导致越界
+    bool valid() const {
+        if (records.empty() || records[0].parent != kNone || !records[0].is_dir) return false;
+        for (size_t i = 0; i < records.size(); ++i) {
+            const Record& r = records[i];
+            if (r.end <= i || r.end > records.size()) return false;
+            if (i > 0 && (r.parent >= i || !records[r.parent].is_dir || r.end > records[r.parent].end)) return false;
+            if (static_cast<uint64_t>(r.name_off) + r.name_len > names.size()) return false;
+        }
+        return true;
+    }
+
+    std::string root;
+    std::vector<Record> records;
+    std::vector<char> names;
+};
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,132 @@
+#ifndef SORTED_WALKER_H
+#define SORTED_WALKER_H
+
+#include "utils.h"
+#include "ignore_filter.h"
+#include <vector>
+#include <string>
+
+// 有序目录遍历器
+// 每个目录读出后按名字排序，先序深度优先输出，整体顺序为逐分量字典序；
+// 只保存从根到当前节点路径上各层目录的列表，工作内存为O(深度 x 目录宽度)
+class SortedDirWalker {
+public:
+    // matcher可为空；非空时被忽略的条目不输出，被忽略的目录不会被打开
+    SortedDirWalker(const fs::path& root, bool ignore_hidden, IgnoreMatcher* matcher = nullptr)
+        : root(root), ignore_hidden(ignore_hidden), matcher(matcher && !matcher->inactive() ? matcher : nullptr) {
+        push_dir(root, std::string());
+    }
+
+    // 前进到下一个条目（上一个条目是目录时先进入该目录），遍历结束返回false
+    bool next() {
+        if (descend_pending) {
+            descend_pending = false;
+            push_dir(current, rel_path('/'));
+        }
+        while (!stack.empty()) {
+            Frame& top = stack.back();
+            if (top.next < top.entries.size()) {
+                Entry& e = top.entries[top.next++];
+                comps.resize(stack.size());
+                comps.back() = e.name;
+                current = top.dir / e.name;
+                current_is_dir = e.is_dir;
+                current_size = e.size;
+                current_mtime = e.mtime;
+                current_is_link = e.is_link;
+                descend_pending = e.is_dir;
+                return true;
+            }
+            stack.pop_back();
+            if (matcher) matcher->leave();
+        }
+        return false;
+    }
+
+    // 不进入当前目录（调用next前有效）
+    void skip_children() { descend_pending = false; }
+
+    const std::vector<std::string>& components() const { return comps; }
+    const fs::path& path() const { return current; }
+    bool is_dir() const { return current_is_dir; }
+    uint64_t size() const { return current_size; }
+    int64_t mtime() const { return current_mtime; }
+    bool is_symlink() const { return current_is_link; } // 指向文件的符号链接（size为链接本身）
+    size_t depth() const { return comps.size(); }
+
+    std::string rel_path(char separator = static_cast<char>(fs::path::preferred_separator)) const {
+        std::string out;
+        for (const auto& c : comps) {
+            if (!out.empty()) out.push_back(separator);
+            out += c;
+        }
+        return out;
+    }
+
+    // 逐分量比较两个条目的位置（前缀在前），与遍历输出顺序一致
+    static int compare(const std::vector<std::string>& a, const std::vector<std::string>& b) {
+        size_t n = std::min(a.size(), b.size());
+        for (size_t i = 0; i < n; ++i) {
+            int c = a[i].compare(b[i]);
+            if (c != 0) return c < 0 ? -1 : 1;
+        }
+        if (a.size() == b.size()) return 0;
+        return a.size() < b.size() ? -1 : 1;
+    }
+
+private:
+    struct Entry {
+        std::string name;
+        bool is_dir;
+        uint64_t size;
+        int64_t mtime; // 毫秒时间戳
+        bool is_link;
+    };
+
+    struct Frame {
+        fs::path dir;
+        std::vector<Entry> entries;
+        size_t next = 0;
+    };
+
+    void push_dir(const fs::path& dir, const std::string& rel_dir) {
+        Frame frame;
+        frame.dir = dir;
+        if (matcher) matcher->enter(dir, rel_dir);
+        std::error_code ec;
+        for (fs::directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec), end; !ec && it != end; it.increment(ec)) {
+            const fs::directory_entry& entry = *it;
+            if (ignore_hidden && is_hidden_file(entry.path())) continue;
+            std::error_code type_ec;
+            // 不跟随目录符号链接，避免循环链接导致无限递归
+            bool is_dir = entry.is_directory(type_ec) && !entry.is_symlink(type_ec);
+            bool is_file = !is_dir && entry.is_regular_file(type_ec);
+            bool is_link = is_file && entry.is_symlink(type_ec);
+            if (!is_dir && !is_file) continue;
+            std::string name = entry.path().filename().string();
+            // 先判断忽略规则再stat，被忽略的条目不产生额外I/O
+            if (matcher && matcher->ignored(IgnoreMatcher::join(rel_dir, name), is_dir)) continue;
+            uint64_t size = 0;
+            int64_t mtime = 0;
+            stat_entry(entry.path(), size, mtime);
+            frame.entries.push_back(Entry{std::move(name), is_dir, is_file ? size : 0, mtime, is_link});
+        }
+        std::sort(frame.entries.begin(), frame.entries.end(),
+                  [](const Entry& a, const Entry& b) { return a.name < b.name; });
+        stack.push_back(std::move(frame));
+    }
+
+    fs::path root;
+    bool ignore_hidden;
+    IgnoreMatcher* matcher;
+    std::vector<Frame> stack;
+    std::vector<std::string> comps;
+    fs::path current;
+    bool current_is_dir = false;
+    uint64_t current_size = 0;
+    int64_t current_mtime = 0;
+    bool current_is_link = false;
+    bool descend_pending = false;
+};
+
+#endif // SORTED_WALKER_H
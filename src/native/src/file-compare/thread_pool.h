@@ -2,55 +2,199 @@
 #define THREAD_POOL_H
 
 #include <vector>
-#include <queue>
+#include <deque>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
-#include <functional>
 #include <atomic>
+#include <memory>
+#include <new>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
 #include <stdexcept>
+#include <exception>
+#include <chrono>
+#include <algorithm>
 
+// 任务优先级：交互任务（UI单文件对比）总是先于已排队的后台任务（文件夹扫描）执行
+enum class TaskPriority {
+    Interactive = 0,
+    Background = 1
+};
+
+// 小缓冲任务对象：可调用对象不超过kInlineSize时就地存储，入队无需堆分配
+class Task {
+public:
+    static constexpr size_t kInlineSize = 96;
+
+    Task() noexcept = default;
+
+    template<class F, class Fn = std::decay_t<F>,
+             class = std::enable_if_t<!std::is_same<Fn, Task>::value>>
+    Task(F&& f) {
+        if constexpr (fits_inline<Fn>()) {
+            ::new (static_cast<void*>(storage)) Fn(std::forward<F>(f));
+            ops = &inline_ops<Fn>;
+        } else {
+            // 超大捕获退化为堆存储
+            ::new (static_cast<void*>(storage)) Fn*(new Fn(std::forward<F>(f)));
+            ops = &heap_ops<Fn>;
+        }
+    }
+
+    Task(Task&& other) noexcept {
+        if (other.ops) {
+            other.ops->move(storage, other.storage);
+            ops = other.ops;
+            other.ops = nullptr;
+        }
+    }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            if (other.ops) {
+                other.ops->move(storage, other.storage);
+                ops = other.ops;
+                other.ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    ~Task() { reset(); }
+
+    void operator()() { ops->invoke(storage); }
+    explicit operator bool() const noexcept { return ops != nullptr; }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+private:
+    struct Ops {
+        void (*invoke)(void*);
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void*) noexcept;
+    };
+
+    template<class Fn>
+    static constexpr bool fits_inline() {
+        return sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible<Fn>::value;
+    }
+
+    template<class Fn>
+    static constexpr Ops inline_ops = {
+        [](void* p) { (*static_cast<Fn*>(p))(); },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* p) noexcept { static_cast<Fn*>(p)->~Fn(); }
+    };
+
+    template<class Fn>
+    static constexpr Ops heap_ops = {
+        [](void* p) { (**static_cast<Fn**>(p))(); },
+        [](void* dst, void* src) noexcept { ::new (dst) Fn*(*static_cast<Fn**>(src)); },
+        [](void* p) noexcept { delete *static_cast<Fn**>(p); }
+    };
+
+    void reset() noexcept {
+        if (ops) {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage[kInlineSize];
+    const Ops* ops = nullptr;
+};
+
+// 协作式取消：CancelSource发出取消，任务通过CancelToken轮询
+// 默认构造的CancelToken永不取消
+class CancelToken {
+public:
+    CancelToken() = default;
+    bool cancelled() const {
+        return flag && flag->load(std::memory_order_acquire);
+    }
+
+private:
+    friend class CancelSource;
+    explicit CancelToken(std::shared_ptr<std::atomic<bool>> f) : flag(std::move(f)) {}
+    std::shared_ptr<std::atomic<bool>> flag;
+};
+
+class CancelSource {
+public:
+    CancelSource() : flag(std::make_shared<std::atomic<bool>>(false)) {}
+    void cancel() { flag->store(true, std::memory_order_release); }
+    bool cancelled() const { return flag->load(std::memory_order_acquire); }
+    CancelToken token() const { return CancelToken(flag); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> flag;
+};
+
+// 工作窃取线程池
+// 每个工作线程有自己的双端队列（本线程LIFO取，其他线程FIFO窃取），
+// 外部线程提交的任务进入全局注入队列；两个优先级通道分别排队，
+// 取任务时先在所有队列中找交互任务，再找后台任务
 class ThreadPool {
 public:
     explicit ThreadPool(size_t threads = std::thread::hardware_concurrency()) : stop(false) {
         if (threads == 0) threads = 1;
         for (size_t i = 0; i < threads; ++i) {
-            workers.emplace_back([this] {
-                for (;;) {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(this->queue_mutex);
-                        this->condition.wait(lock, [this] {
-                            return this->stop || !this->tasks.empty();
-                        });
-                        if (this->stop && this->tasks.empty()) return;
-                        task = std::move(this->tasks.front());
-                        this->tasks.pop();
-                    }
-                    task();
-                }
-            });
+            locals.emplace_back(std::make_unique<WorkQueue>());
+        }
+        for (size_t i = 0; i < threads; ++i) {
+            workers.emplace_back([this, i] { worker_loop(i); });
         }
     }
 
-    // 提交任务
+    // 提交任务：工作线程提交到自己的队列，外部线程提交到注入队列
     template<class F>
-    void enqueue(F&& f) {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            if (stop) throw std::runtime_error("enqueue on stopped ThreadPool");
-            tasks.emplace(std::forward<F>(f));
+    void enqueue(F&& f, TaskPriority priority = TaskPriority::Background) {
+        if (stop) throw std::runtime_error("enqueue on stopped ThreadPool");
+        const int lane = static_cast<int>(priority);
+        Task task(std::forward<F>(f));
+        WorkerSlot& slot = current_slot();
+        push_counted(slot.pool == this ? *locals[slot.index] : injector, lane, task);
+        if (idle.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            wake.notify_one();
         }
-        condition.notify_one();
+        notify_helpers();
     }
 
+    // 阻塞到ready()成立，每次有任务入队或notify_helpers()时重新检查（供TaskGroup协助等待）
+    // ready依赖的状态改变后需调用notify_helpers()，否则等待者只会被新入队的任务唤醒
+    template<class Pred>
+    void wait_for_work(Pred ready) {
+        std::unique_lock<std::mutex> lock(help_mutex);
+        helpers.fetch_add(1, std::memory_order_seq_cst);
+        help_wake.wait(lock, ready);
+        helpers.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    // 唤醒wait_for_work中的等待者（没有等待者时只有一次原子读）；调用方不能持有ready会用到的锁
+    void notify_helpers() {
+        if (helpers.load(std::memory_order_seq_cst) == 0) return;
+        std::lock_guard<std::mutex> lock(help_mutex);
+        help_wake.notify_all();
+    }
+
+    size_t size() const { return workers.size(); }
+
     // 析构：等待所有任务完成
     ~ThreadPool() {
         {
-            std::unique_lock<std::mutex> lock(queue_mutex);
+            std::lock_guard<std::mutex> lock(sleep_mutex);
             stop = true;
         }
-        condition.notify_all();
+        wake.notify_all();
         for (std::thread& worker : workers) {
             worker.join();
         }
@@ -61,11 +205,349 @@ public:
     ThreadPool& operator=(const ThreadPool&) = delete;
 
 private:
+    static constexpr int kLanes = 2;
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> lanes[kLanes];
+    };
+
+    struct WorkerSlot {
+        ThreadPool* pool = nullptr;
+        size_t index = 0;
+    };
+
+    static WorkerSlot& current_slot() {
+        static thread_local WorkerSlot slot;
+        return slot;
+    }
+
+    bool has_queued() const {
+        return queued[0].load(std::memory_order_seq_cst) > 0 ||
+               queued[1].load(std::memory_order_seq_cst) > 0;
+    }
+
+    // 计数先于任务可见：queued不小于实际可取的任务数，取到任务后的递减不会下溢
+    void push_counted(WorkQueue& q, int lane, Task& task) {
+        std::lock_guard<std::mutex> lock(q.mutex);
+        queued[lane].fetch_add(1, std::memory_order_seq_cst);
+        try {
+            q.lanes[lane].push_back(std::move(task));
+        } catch (...) {
+            queued[lane].fetch_sub(1, std::memory_order_seq_cst);
+            throw;
+        }
+    }
+
+    bool take_back(WorkQueue& q, int lane, Task& out) {
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.lanes[lane].empty()) return false;
+        out = std::move(q.lanes[lane].back());
+        q.lanes[lane].pop_back();
+        return true;
+    }
+
+    bool take_front(WorkQueue& q, int lane, Task& out) {
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.lanes[lane].empty()) return false;
+        out = std::move(q.lanes[lane].front());
+        q.lanes[lane].pop_front();
+        return true;
+    }
+
+    // 按优先级取任务：本地队列 -> 注入队列 -> 从其他工作线程窃取
+    bool pop_task(Task& out) {
+        WorkerSlot& slot = current_slot();
+        const bool is_worker = slot.pool == this;
+        const size_t n = locals.size();
+        for (int lane = 0; lane < kLanes; ++lane) {
+            if (queued[lane].load(std::memory_order_acquire) == 0) continue;
+            bool found = (is_worker && take_back(*locals[slot.index], lane, out)) ||
+                         take_front(injector, lane, out);
+            for (size_t k = 1; !found && k <= n; ++k) {
+                size_t victim = ((is_worker ? slot.index : 0) + k) % n;
+                found = take_front(*locals[victim], lane, out);
+            }
+            if (found) {
+                queued[lane].fetch_sub(1, std::memory_order_acq_rel);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void worker_loop(size_t index) {
+        current_slot() = WorkerSlot{this, index};
+        for (;;) {
+            Task task;
+            if (pop_task(task)) {
+                task();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            idle.fetch_add(1, std::memory_order_seq_cst);
+            wake.wait(lock, [this] { return stop || has_queued(); });
+            idle.fetch_sub(1, std::memory_order_seq_cst);
+            if (stop && !has_queued()) return;
+        }
+    }
+
     std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
-    std::mutex queue_mutex;
-    std::condition_variable condition;
+    std::vector<std::unique_ptr<WorkQueue>> locals;
+    WorkQueue injector;
+    std::atomic<size_t> queued[kLanes] = {};
+    std::atomic<size_t> idle{0};
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::atomic<size_t> helpers{0};
+    std::mutex help_mutex;
+    std::condition_variable help_wake;
     std::atomic<bool> stop;
 };
 
-#endif // THREAD_POOL_H
\ No newline at end of file
+// 任务组：一批任务的完成闩锁
+// 任务先进入组内队列，线程池中只排队一个取组内任务的跳板；跳板与等待者谁先到谁执行
+// wait()时调用线程只协助执行本组排队的任务，组内队列空后再阻塞到最后一个任务完成：
+// 等待者不会执行其他组的任务（交互等待者不会被后台任务拖住，嵌套等待也不会卷入无关的长任务），
+// 本组任务总能由等待者自己执行，多个等待者占满线程池时也不会饿死
+// 组内任务共享优先级与取消令牌，已取消的任务出队后直接跳过
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool, TaskPriority priority = TaskPriority::Background,
+                       CancelToken token = CancelToken())
+        : pool(pool), priority(priority), token(std::move(token)), pending(0),
+          tasks(std::make_shared<LocalQueue>()) {}
+
+    // 提交属于本组的任务
+    template<class F>
+    void run(F&& f) {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        try {
+            tasks->push(Task([this, task = std::forward<F>(f)]() mutable {
+                try {
+                    if (!token.cancelled()) task();
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error) error = std::current_exception();
+                }
+                finish_one();
+            }));
+        } catch (...) {
+            finish_one();
+            throw;
+        }
+        // 跳板持有组内队列的共享引用：任务已被等待者取走、组已析构时跳板什么也不做
+        // 跳板入队失败时任务仍留在组内队列，由wait()或析构执行
+        pool.enqueue([queue = tasks]() { queue->run_one(); }, priority);
+    }
+
+    // 在调用线程上执行一个本组排队的任务，组内队列为空返回false
+    bool try_run_one() { return tasks->run_one(); }
+
+    // 协助等待：阻塞到ready()成立或本组出现排队任务（随后应调用try_run_one）
+    // ready依赖的状态改变后需调用线程池的notify_helpers()
+    template<class Pred>
+    void wait_for_work(Pred ready) {
+        pool.wait_for_work([&] { return ready() || !tasks->empty(); });
+    }
+
+    // 任务内可轮询此标志提前退出
+    bool cancelled() const { return token.cancelled(); }
+
+    // 等待本组所有任务完成（等待期间协助执行本组任务），任务抛出的首个异常在此重新抛出
+    void wait() {
+        while (pending.load(std::memory_order_acquire) > 0) {
+            if (!try_run_one()) break;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pending.load(std::memory_order_acquire) == 0; });
+        rethrow_error();
+    }
+
+    // 等待本组完成，期间协助执行另一个任务组（只执行该组的任务）
+    // 用于组内是长时间运行的阶段任务（如I/O读线程），而下游阶段是helper组的流水线
+    // 两边都没有进展时休眠，由helper组提交新任务或本组最后一个任务完成唤醒
+    void wait_helping(TaskGroup& helper) {
+        helping.store(&helper.pool, std::memory_order_seq_cst);
+        while (pending.load(std::memory_order_seq_cst) > 0) {
+            if (helper.try_run_one()) continue;
+            helper.wait_for_work([this] { return pending.load(std::memory_order_seq_cst) == 0; });
+        }
+        helping.store(nullptr, std::memory_order_seq_cst);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pending.load(std::memory_order_acquire) == 0; });
+        rethrow_error();
+    }
+
+    // 析构：保证不会留下引用本对象的任务（尚未开始的本组任务在此执行）
+    ~TaskGroup() {
+        while (try_run_one()) {}
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pending.load(std::memory_order_acquire) == 0; });
+    }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+private:
+    // 组内任务队列，由本组与池中的跳板共享
+    struct LocalQueue {
+        std::mutex mutex;
+        std::deque<Task> items;
+
+        bool empty() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return items.empty();
+        }
+
+        void push(Task task) {
+            std::lock_guard<std::mutex> lock(mutex);
+            items.push_back(std::move(task));
+        }
+
+        bool run_one() {
+            Task task;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (items.empty()) return false;
+                task = std::move(items.front());
+                items.pop_front();
+            }
+            task();
+            return true;
+        }
+    };
+
+    // 调用方需持有mutex
+    void rethrow_error() {
+        if (error) {
+            std::exception_ptr e = error;
+            error = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+    // 计数在锁内递减，保证等待者返回（并析构本对象）前通知已完成
+    void finish_one() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending.fetch_sub(1, std::memory_order_seq_cst) == 1) {
+            done.notify_all();
+            if (ThreadPool* helper = helping.load(std::memory_order_seq_cst)) helper->notify_helpers();
+        }
+    }
+
+    ThreadPool& pool;
+    TaskPriority priority;
+    CancelToken token;
+    std::atomic<size_t> pending;
+    std::atomic<ThreadPool*> helping{nullptr}; // wait_helping期间协助的任务组所在线程池
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+    std::shared_ptr<LocalQueue> tasks;
+};
+
+// 有界阻塞队列：流水线阶段之间的背压，生产者在队列满时阻塞
+// close()后push失败，pop取完剩余元素后返回false
+// space_waiters非空时，出现空位会唤醒在该线程池上wait_for_work的生产者（协助执行任务而不是阻塞在push上）
+template<class T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity, ThreadPool* space_waiters = nullptr)
+        : capacity(capacity == 0 ? 1 : capacity), space_waiters(space_waiters) {}
+
+    bool push(T value) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this] { return closed || items.size() < capacity; });
+        if (closed) return false;
+        items.push_back(std::move(value));
+        not_empty.notify_one();
+        return true;
+    }
+
+    // 非阻塞入队：仅在成功时移走value
+    bool try_push(T& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed || items.size() >= capacity) return false;
+        items.push_back(std::move(value));
+        not_empty.notify_one();
+        return true;
+    }
+
+    // 是否可以入队（有空位或已关闭），供wait_for_work的条件使用
+    bool writable() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return closed || items.size() < capacity;
+    }
+
+    bool pop(T& out) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_empty.wait(lock, [this] { return closed || !items.empty(); });
+            if (items.empty()) return false;
+            out = std::move(items.front());
+            items.pop_front();
+            not_full.notify_one();
+        }
+        space_freed();
+        return true;
+    }
+
+    // 阻塞直到至少有一个元素，然后最多取出max_count个追加到out
+    bool pop_batch(std::vector<T>& out, size_t max_count) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_empty.wait(lock, [this] { return closed || !items.empty(); });
+            if (items.empty()) return false;
+            size_t n = std::min(max_count, items.size());
+            for (size_t i = 0; i < n; ++i) {
+                out.push_back(std::move(items.front()));
+                items.pop_front();
+            }
+            not_full.notify_all();
+        }
+        space_freed();
+        return true;
+    }
+
+    bool try_pop(T& out) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (items.empty()) return false;
+            out = std::move(items.front());
+            items.pop_front();
+            not_full.notify_one();
+        }
+        space_freed();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+            not_full.notify_all();
+            not_empty.notify_all();
+        }
+        space_freed();
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+private:
+    // 在队列锁外通知：等待者的条件（writable）会获取队列锁
+    void space_freed() {
+        if (space_waiters) space_waiters->notify_helpers();
+    }
+
+    const size_t capacity;
+    ThreadPool* const space_waiters;
+    std::deque<T> items;
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+};
+
+#endif // THREAD_POOL_H
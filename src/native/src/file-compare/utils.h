@@ -6,6 +6,7 @@
 #include <stdexcept>
 #include <filesystem>
 #include <cstdint>
+#include <cstring>
 #include <sstream>
 #include <algorithm>
 #include <fstream>      // 关键：添加ifstream所需头文件
@@ -13,10 +14,17 @@
 #include <cctype>       // isprint/isspace所需
 #include <mutex>        // 通用mutex头文件
 #include <thread>       // 线程相关
+#include <chrono>
+#include <zlib.h>       // crc32（插件已链接zlib）
 #ifdef _WIN32
 #include <windows.h>    // Windows隐藏文件判断
 #else
 #include <unistd.h>     // Linux/Mac基础头文件
+#include <sys/stat.h>
+#endif
+#ifdef __linux__
+#include <sys/statfs.h>
+#include <sys/sysmacros.h> // major/minor
 #endif
 
 // 命名空间别名
@@ -57,6 +65,29 @@ inline bool is_hidden_file(const fs::path& path) {
 #endif
 }
 
+// 单次stat取大小与修改时间（毫秒时间戳），不跟随符号链接
+inline bool stat_entry(const fs::path& path, uint64_t& size, int64_t& mtime_ms) {
+#ifdef _WIN32
+    std::error_code ec;
+    auto t = fs::last_write_time(path, ec);
+    if (ec) return false;
+    size = fs::is_regular_file(path, ec) ? fs::file_size(path, ec) : 0;
+    // MSVC的file_time_type以1601-01-01为纪元，单位100ns
+    mtime_ms = std::chrono::duration_cast<std::chrono::milliseconds>(t.time_since_epoch()).count() - 11644473600000LL;
+    return true;
+#else
+    struct stat st;
+    if (::lstat(path.c_str(), &st) != 0) return false;
+    size = S_ISREG(st.st_mode) ? static_cast<uint64_t>(st.st_size) : 0;
+#ifdef __APPLE__
+    mtime_ms = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000 + st.st_mtimespec.tv_nsec / 1000000;
+#else
+    mtime_ms = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000;
+#endif
+    return true;
+#endif
+}
+
 // 读取文本文件（按行拆分）
 inline std::vector<std::string> read_text_file_lines(const std::string& file_path) {
     std::vector<std::string> lines;
@@ -71,53 +102,238 @@ inline std::vector<std::string> read_text_file_lines(const std::string& file_pat
     return lines;
 }
 
-// 计算文件CRC32（简化版，实际可替换为zlib）
+// CRC32增量计算（zlib实现，按块调用）
+inline uint32_t crc32_update(uint32_t crc, const char* data, size_t len) {
+    while (len > 0) {
+        uInt chunk = static_cast<uInt>(std::min<size_t>(len, 1u << 30));
+        crc = static_cast<uint32_t>(::crc32(crc, reinterpret_cast<const Bytef*>(data), chunk));
+        data += chunk;
+        len -= chunk;
+    }
+    return crc;
+}
+
+// CRC32格式化为8位十六进制
+inline std::string format_crc32(uint32_t crc) {
+    char crc_str[9];
+    snprintf(crc_str, sizeof(crc_str), "%08X", crc);
+    return std::string(crc_str);
+}
+
+// 计算文件CRC32（流式读取）
 inline std::string calculate_crc32(const std::string& file_path) {
     std::ifstream file(file_path, std::ios::binary);
     if (!file.is_open()) {
         return "00000000";
     }
-    uint32_t crc = 0xFFFFFFFF;
-    char buf[4096];
-    size_t count = file.gcount();
-    while (file.read(buf, sizeof(buf))) {
-        for (size_t i = 0; i < count; ++i) {
-            crc = (crc >> 8) ^ ((uint32_t)static_cast<uint8_t>(buf[i]) << 24);
-            for (int j = 0; j < 8; ++j) {
-                crc = (crc << 1) ^ ((crc & 0x80000000) ? 0x04C11DB7 : 0);
-            }
+    uint32_t crc = 0;
+    char buf[64 * 1024];
+    while (file.read(buf, sizeof(buf)) || file.gcount() > 0) {
+        crc = crc32_update(crc, buf, static_cast<size_t>(file.gcount()));
+    }
+    return format_crc32(crc);
+}
+
+// 文本编码
+enum class TextEncoding {
+    Binary = 0,
+    Ascii,
+    Utf8,
+    Utf8Bom,
+    Utf16LE,
+    Utf16BE,
+    Gbk
+};
+
+inline const char* encoding_name(TextEncoding enc) {
+    switch (enc) {
+        case TextEncoding::Ascii:   return "ascii";
+        case TextEncoding::Utf8:    return "utf-8";
+        case TextEncoding::Utf8Bom: return "utf-8-bom";
+        case TextEncoding::Utf16LE: return "utf-16le";
+        case TextEncoding::Utf16BE: return "utf-16be";
+        case TextEncoding::Gbk:     return "gbk";
+        default:                    return "binary";
+    }
+}
+
+// 单文件分类结果：大小、CRC32、文本判断与编码
+struct FileClassification {
+    uint64_t size = 0;
+    uint32_t crc32 = 0;
+    bool is_text = false;
+    TextEncoding encoding = TextEncoding::Binary;
+};
+
+// 单遍内容分类器：按块喂入数据，每个字节只经过一次缓存
+// CRC覆盖全部内容，文本/编码判断只看前kSampleSize字节
+class ContentClassifier {
+public:
+    static constexpr size_t kSampleSize = 64 * 1024;
+
+    void update(const char* data, size_t len) {
+        result.crc32 = crc32_update(result.crc32, data, len);
+        if (result.size < kSampleSize) {
+            size_t n = std::min<size_t>(len, static_cast<size_t>(kSampleSize - result.size));
+            inspect(reinterpret_cast<const unsigned char*>(data), n);
+        }
+        result.size += len;
+    }
+
+    FileClassification finish() {
+        FileClassification out = result;
+        if (bom != TextEncoding::Binary) {
+            out.encoding = bom;
+        } else if (has_control) {
+            out.encoding = TextEncoding::Binary;
+        } else if (!has_high) {
+            out.encoding = TextEncoding::Ascii;
+        } else if (utf8_valid) {
+            out.encoding = TextEncoding::Utf8;  // 样本末尾截断的多字节序列视为有效
+        } else if (gbk_valid) {
+            out.encoding = TextEncoding::Gbk;
+        } else {
+            out.encoding = TextEncoding::Binary;
         }
+        out.is_text = out.encoding != TextEncoding::Binary;
+        return out;
     }
-    // 处理剩余字节
-    if (count > 0) {
-        std::streamsize bytes_read = count;
-        for (std::streamsize i = 0; i < bytes_read; ++i) {
-            crc = (crc >> 8) ^ ((uint32_t)static_cast<uint8_t>(buf[i]) << 24);
-            for (int j = 0; j < 8; ++j) {
-                crc = (crc << 1) ^ ((crc & 0x80000000) ? 0x04C11DB7 : 0);
+
+private:
+    void inspect(const unsigned char* p, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            // 快速路径：连续8个可打印ASCII字节不影响任何判断状态，整字跳过
+            if (sampled >= 3 && utf8_need == 0 && !gbk_trail && i + 8 <= n &&
+                bom != TextEncoding::Utf16LE && bom != TextEncoding::Utf16BE) {
+                uint64_t w;
+                memcpy(&w, p + i, sizeof(w));
+                const uint64_t high = 0x8080808080808080ULL;
+                const uint64_t below_space = (w - 0x2020202020202020ULL) & ~w & high;
+                if (((w & high) | below_space) == 0) {
+                    sampled += 8;
+                    i += 7;
+                    continue;
+                }
+            }
+            unsigned char c = p[i];
+            if (sampled < 3) head[sampled] = c;
+            ++sampled;
+            if (sampled == 2 || sampled == 3) detect_bom();
+            if (bom == TextEncoding::Utf16LE || bom == TextEncoding::Utf16BE) continue;
+
+            if (c < 0x20 && c != '\t' && c != '\n' && c != '\r' && c != '\f' && c != '\v' && c != 0x1B) {
+                has_control = true; // 含NUL等控制字符视为二进制
+            }
+            if (c >= 0x80) has_high = true;
+
+            // UTF-8校验
+            if (utf8_need > 0) {
+                if ((c & 0xC0) == 0x80) --utf8_need; else utf8_valid = false;
+            } else if (c >= 0x80) {
+                if (c >= 0xC2 && c <= 0xDF) utf8_need = 1;
+                else if (c >= 0xE0 && c <= 0xEF) utf8_need = 2;
+                else if (c >= 0xF0 && c <= 0xF4) utf8_need = 3;
+                else utf8_valid = false;
+            }
+
+            // GBK校验：首字节0x81-0xFE，尾字节0x40-0xFE（不含0x7F）
+            if (gbk_trail) {
+                if (c < 0x40 || c > 0xFE || c == 0x7F) gbk_valid = false;
+                gbk_trail = false;
+            } else if (c >= 0x81 && c <= 0xFE) {
+                gbk_trail = true;
+            } else if (c == 0x80 || c == 0xFF) {
+                gbk_valid = false;
             }
         }
     }
-    crc = ~crc;
-    char crc_str[9];
-    snprintf(crc_str, sizeof(crc_str), "%08X", crc);
-    return std::string(crc_str);
+
+    void detect_bom() {
+        if (sampled == 2 && bom == TextEncoding::Binary) {
+            if (head[0] == 0xFF && head[1] == 0xFE) bom = TextEncoding::Utf16LE;
+            else if (head[0] == 0xFE && head[1] == 0xFF) bom = TextEncoding::Utf16BE;
+        } else if (sampled == 3 && head[0] == 0xEF && head[1] == 0xBB && head[2] == 0xBF) {
+            bom = TextEncoding::Utf8Bom;
+        }
+    }
+
+    FileClassification result;
+    unsigned char head[3] = {0, 0, 0};
+    uint64_t sampled = 0;
+    TextEncoding bom = TextEncoding::Binary;
+    bool has_control = false;
+    bool has_high = false;
+    bool utf8_valid = true;
+    int utf8_need = 0;
+    bool gbk_valid = true;
+    bool gbk_trail = false;
+};
+
+// 内存块分类
+inline FileClassification classify_buffer(const char* data, size_t len) {
+    ContentClassifier classifier;
+    classifier.update(data, len);
+    return classifier.finish();
 }
 
-// 判断是否为文本文件（简化版：检查前1024字节是否有不可打印字符）
+// 单遍文件分类：一次打开、一次顺序读，同时得到大小、CRC32、文本判断与编码
+inline bool classify_file(const std::string& file_path, FileClassification& out) {
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file.is_open()) return false;
+    ContentClassifier classifier;
+    std::vector<char> buf(256 * 1024);
+    while (file.read(buf.data(), static_cast<std::streamsize>(buf.size())) || file.gcount() > 0) {
+        classifier.update(buf.data(), static_cast<size_t>(file.gcount()));
+    }
+    if (file.bad()) return false;
+    out = classifier.finish();
+    return true;
+}
+
+// 判断内存块是否为文本（ASCII/UTF-8/UTF-16 BOM/GBK）
+inline bool is_text_buffer(const char* data, size_t len) {
+    return classify_buffer(data, std::min<size_t>(len, ContentClassifier::kSampleSize)).is_text;
+}
+
+// 判断是否为文本文件（只读取分类样本大小的文件头）
 inline bool is_text_file(const std::string& file_path) {
     std::ifstream file(file_path, std::ios::binary);
     if (!file.is_open()) return false;
-    char buf[1024];
-    file.read(buf, sizeof(buf));
-    size_t count = file.gcount();
-    for (size_t i = 0; i < count; ++i) {
-        if (buf[i] == 0) return false; // 二进制空字符
-        if (!isprint(static_cast<unsigned char>(buf[i])) && !isspace(static_cast<unsigned char>(buf[i]))) {
-            return false;
+    std::vector<char> buf(ContentClassifier::kSampleSize);
+    file.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+    return is_text_buffer(buf.data(), static_cast<size_t>(file.gcount()));
+}
+
+// 估算路径所在设备适合的并发读数量
+// 机械盘并发读会互相抢寻道，网络文件系统受往返时延限制，SSD/NVMe可以深队列
+inline size_t detect_io_concurrency(const fs::path& path) {
+    size_t cpu = std::max(1u, std::thread::hardware_concurrency());
+#ifdef __linux__
+    struct statfs sfs;
+    if (statfs(path.c_str(), &sfs) == 0) {
+        switch (static_cast<unsigned long>(sfs.f_type)) {
+            case 0x6969UL:     // NFS
+            case 0xFF534D42UL: // CIFS
+            case 0xFE534D42UL: // SMB2
+            case 0x517BUL:     // SMB
+            case 0x65735546UL: // FUSE（sshfs等）
+                return 4;
         }
     }
-    return true;
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) {
+        // 整盘设备直接有queue目录，分区需要到父设备查找
+        std::string dev = "/sys/dev/block/" + std::to_string(major(st.st_dev)) + ":" + std::to_string(minor(st.st_dev));
+        for (const char* rel : {"/queue/rotational", "/../queue/rotational"}) {
+            std::ifstream f(dev + rel);
+            int rotational = 0;
+            if (f >> rotational) {
+                return rotational ? 2 : std::min<size_t>(cpu * 2, 16);
+            }
+        }
+    }
+#endif
+    return std::min<size_t>(cpu, 8);
 }
 
 // 获取相对路径
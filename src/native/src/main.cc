@@ -7,9 +7,11 @@
 // 自定义头文件（按模块划分，保持原有目录结构）
 #include "./window-info/window_info.h"
 #include "./file-compare/file_compare.h"
+#include "./file-compare/compare_session.h"
 #include "./cursor/cursor.h"
 #include "./screen-freeze/screen_freeze.h"
 #include "./shm/GlobalShm.hpp"
+#include "./shm/ShmRpc.hpp"
 
 // 平台检测 - 包含对应平台的窗口枚举器头文件
 #ifdef _WIN32
@@ -24,27 +26,29 @@
 
 static GlobalShm g;
 static ShmChannel chan;
+static std::mutex g_shm_mutex; // 保护chan的重新打开与等待线程取用
 
 ///////////////////////////// window-info  窗口信息获取 /////////////////////////////////
-Napi::Value GetAllWindows(const Napi::CallbackInfo &info)
+static std::unique_ptr<WindowEnumerator> CreateWindowEnumerator()
 {
-    Napi::Env env = info.Env();
-
-    try
-    {
-        std::unique_ptr<WindowEnumerator> enumerator;
-
 #ifdef _WIN32
-        enumerator = std::make_unique<WindowsWindowEnumerator>();
+    return std::make_unique<WindowsWindowEnumerator>();
 #elif defined(__APPLE__)
-        enumerator = std::make_unique<MacOSWindowEnumerator>();
+    return std::make_unique<MacOSWindowEnumerator>();
 #elif defined(__linux__)
-        enumerator = std::make_unique<LinuxWindowEnumerator>();
+    return std::make_unique<LinuxWindowEnumerator>();
 #else
-        throw std::runtime_error("window-info module is not supported on current platform");
+    throw std::runtime_error("window-info module is not supported on current platform");
 #endif
+}
+
+Napi::Value GetAllWindows(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
 
-        auto windows = enumerator->GetAllWindows();
+    try
+    {
+        auto windows = CreateWindowEnumerator()->GetAllWindows();
         Napi::Array result = Napi::Array::New(env, windows.size());
 
         for (size_t i = 0; i < windows.size(); i++)
@@ -86,6 +90,7 @@ struct ScanFolderWorker : public Napi::AsyncWorker
 {
     std::string folder_path;
     bool ignore_hidden;
+    IgnoreOptions ignore; // 可选忽略规则
     std::unordered_map<std::string, FileInfo> result;
     Napi::Function callback; // 手动保存回调
 
@@ -101,7 +106,7 @@ struct ScanFolderWorker : public Napi::AsyncWorker
     {
         try
         {
-            result = g_file_compare->scan_folder(folder_path, ignore_hidden);
+            result = g_file_compare->scan_folder(folder_path, ignore_hidden, ignore);
         }
         catch (const std::exception &e)
         {
@@ -122,6 +127,7 @@ struct ScanFolderWorker : public Napi::AsyncWorker
             obj.Set(Napi::String::New(env, "size"), Napi::Number::New(env, (double)info.size));
             obj.Set(Napi::String::New(env, "crc32"), Napi::String::New(env, info.crc32));
             obj.Set(Napi::String::New(env, "isText"), Napi::Boolean::New(env, info.is_text));
+            obj.Set(Napi::String::New(env, "encoding"), Napi::String::New(env, info.encoding));
             res.Set(Napi::String::New(env, rel_path), obj);
         }
 
@@ -142,6 +148,8 @@ struct FolderCompareWorker : public Napi::AsyncWorker
     std::string folder_a;
     std::string folder_b;
     bool ignore_hidden;
+    IgnoreOptions ignore; // 可选忽略规则
+    bool detect_renames = true;
     FolderDiffResult result;
     Napi::Function callback; // 手动保存回调
 
@@ -151,7 +159,7 @@ struct FolderCompareWorker : public Napi::AsyncWorker
 
     void Execute() override
     {
-        result = g_file_compare->compare_folders(folder_a, folder_b, ignore_hidden);
+        result = g_file_compare->compare_folders(folder_a, folder_b, ignore_hidden, ignore, detect_renames);
         if (!result.error.empty())
         {
             SetError(result.error);
@@ -164,19 +172,27 @@ struct FolderCompareWorker : public Napi::AsyncWorker
         Napi::Object res = Napi::Object::New(env);
         res.Set(Napi::String::New(env, "error"), Napi::String::New(env, result.error));
         res.Set(Napi::String::New(env, "totalFiles"), Napi::Number::New(env, (double)result.total_files));
+        res.Set(Napi::String::New(env, "sameCount"), Napi::Number::New(env, (double)result.same_count));
+        res.Set(Napi::String::New(env, "skippedSubtrees"), Napi::Number::New(env, (double)result.skipped_subtrees));
+
+        auto fileInfoObj = [&](const FileInfo &info) -> Napi::Object
+        {
+            Napi::Object obj = Napi::Object::New(env);
+            obj.Set(Napi::String::New(env, "fullPath"), Napi::String::New(env, info.full_path));
+            obj.Set(Napi::String::New(env, "relPath"), Napi::String::New(env, info.rel_path));
+            obj.Set(Napi::String::New(env, "size"), Napi::Number::New(env, (double)info.size));
+            obj.Set(Napi::String::New(env, "crc32"), Napi::String::New(env, info.crc32));
+            obj.Set(Napi::String::New(env, "isText"), Napi::Boolean::New(env, info.is_text));
+            obj.Set(Napi::String::New(env, "encoding"), Napi::String::New(env, info.encoding));
+            return obj;
+        };
 
         auto fileInfoToJs = [&](const std::vector<FileInfo> &infos) -> Napi::Array
         {
             Napi::Array arr = Napi::Array::New(env, infos.size());
             for (size_t i = 0; i < infos.size(); ++i)
             {
-                Napi::Object obj = Napi::Object::New(env);
-                obj.Set(Napi::String::New(env, "fullPath"), Napi::String::New(env, infos[i].full_path));
-                obj.Set(Napi::String::New(env, "relPath"), Napi::String::New(env, infos[i].rel_path));
-                obj.Set(Napi::String::New(env, "size"), Napi::Number::New(env, (double)infos[i].size));
-                obj.Set(Napi::String::New(env, "crc32"), Napi::String::New(env, infos[i].crc32));
-                obj.Set(Napi::String::New(env, "isText"), Napi::Boolean::New(env, infos[i].is_text));
-                arr.Set(i, obj);
+                arr.Set(i, fileInfoObj(infos[i]));
             }
             return arr;
         };
@@ -186,6 +202,32 @@ struct FolderCompareWorker : public Napi::AsyncWorker
         diffs.Set(Napi::String::New(env, "deleted"), fileInfoToJs(result.diffs.deleted));
         diffs.Set(Napi::String::New(env, "modified"), fileInfoToJs(result.diffs.modified));
         diffs.Set(Napi::String::New(env, "same"), fileInfoToJs(result.diffs.same));
+
+        // 重命名/移动：from为A侧，to为B侧
+        Napi::Array renamed = Napi::Array::New(env, result.diffs.renamed.size());
+        for (size_t i = 0; i < result.diffs.renamed.size(); ++i)
+        {
+            const RenamedFile &r = result.diffs.renamed[i];
+            Napi::Object obj = Napi::Object::New(env);
+            obj.Set(Napi::String::New(env, "from"), fileInfoObj(r.from));
+            obj.Set(Napi::String::New(env, "to"), fileInfoObj(r.to));
+            obj.Set(Napi::String::New(env, "kind"), Napi::String::New(env, r.moved ? "moved" : "renamed"));
+            obj.Set(Napi::String::New(env, "similarity"), Napi::Number::New(env, r.similarity));
+            renamed.Set(i, obj);
+        }
+        diffs.Set(Napi::String::New(env, "renamed"), renamed);
+
+        Napi::Array renamed_dirs = Napi::Array::New(env, result.diffs.renamed_dirs.size());
+        for (size_t i = 0; i < result.diffs.renamed_dirs.size(); ++i)
+        {
+            const RenamedDir &d = result.diffs.renamed_dirs[i];
+            Napi::Object obj = Napi::Object::New(env);
+            obj.Set(Napi::String::New(env, "from"), Napi::String::New(env, d.from));
+            obj.Set(Napi::String::New(env, "to"), Napi::String::New(env, d.to));
+            obj.Set(Napi::String::New(env, "files"), Napi::Number::New(env, (double)d.files));
+            renamed_dirs.Set(i, obj);
+        }
+        diffs.Set(Napi::String::New(env, "renamedDirs"), renamed_dirs);
         res.Set(Napi::String::New(env, "diffs"), diffs);
 
         callback.Call({env.Null(), res});
@@ -224,6 +266,8 @@ struct FileCompareWorker : public Napi::AsyncWorker
         Napi::Object res = Napi::Object::New(env);
         res.Set(Napi::String::New(env, "relPath"), Napi::String::New(env, result.rel_path));
         res.Set(Napi::String::New(env, "isText"), Napi::Boolean::New(env, result.is_text));
+        res.Set(Napi::String::New(env, "encodingA"), Napi::String::New(env, result.encoding_a));
+        res.Set(Napi::String::New(env, "encodingB"), Napi::String::New(env, result.encoding_b));
         res.Set(Napi::String::New(env, "error"), Napi::String::New(env, result.error));
 
         Napi::Array diffs = Napi::Array::New(env, result.diffs.size());
@@ -245,160 +289,219 @@ struct FileCompareWorker : public Napi::AsyncWorker
     }
 };
 
-// ---------------------- 注册N-API导出函数 ----------------------
-Napi::Value ScanFolder(const Napi::CallbackInfo &info)
+// ---------------------- 4. 有序文件夹比对：按路径顺序分批推送 ----------------------
+struct SortedFolderCompareWorker : public Napi::AsyncWorker
 {
-    Napi::Env env = info.Env();
-    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsBoolean() || !info[2].IsFunction())
+    // 一批条目与JS处理完成的通知
+    struct Delivery
     {
-        Napi::TypeError::New(env, "Params error: (string folderPath, bool ignoreHidden, function callback)").ThrowAsJavaScriptException();
-        return env.Null();
-    }
-
-    std::string folder_path = info[0].As<Napi::String>().Utf8Value();
-    bool ignore_hidden = info[1].As<Napi::Boolean>().Value();
-    Napi::Function callback = info[2].As<Napi::Function>();
+        std::vector<SortedDiffEntry> entries;
+        std::promise<void> done;
+    };
 
-    auto worker = new ScanFolderWorker(env, folder_path, ignore_hidden, callback);
-    worker->Queue();
-    return env.Undefined();
-}
+    std::string folder_a;
+    std::string folder_b;
+    bool ignore_hidden;
+    IgnoreOptions ignore; // 可选忽略规则
+    SortedDiffStats stats;
+    Napi::Function callback; // 手动保存回调
+    Napi::ThreadSafeFunction tsfn; // 分批回调
 
-Napi::Value CompareFolders(const Napi::CallbackInfo &info)
-{
-    Napi::Env env = info.Env();
-    if (info.Length() < 4 || !info[0].IsString() || !info[1].IsString() || !info[2].IsBoolean() || !info[3].IsFunction())
+    SortedFolderCompareWorker(Napi::Env env, std::string a, std::string b, bool ih, Napi::Function on_batch, Napi::Function cb)
+        : Napi::AsyncWorker(env, "sorted-folder-compare-worker"),
+          folder_a(a), folder_b(b), ignore_hidden(ih), callback(cb)
     {
-        Napi::TypeError::New(env, "Params error: (string folderA, string folderB, bool ignoreHidden, function callback)").ThrowAsJavaScriptException();
-        return env.Null();
+        tsfn = Napi::ThreadSafeFunction::New(env, on_batch, "SortedCompareBatch", 0, 1);
     }
 
-    std::string folder_a = info[0].As<Napi::String>().Utf8Value();
-    std::string folder_b = info[1].As<Napi::String>().Utf8Value();
-    bool ignore_hidden = info[2].As<Napi::Boolean>().Value();
-    Napi::Function callback = info[3].As<Napi::Function>();
-
-    auto worker = new FolderCompareWorker(env, folder_a, folder_b, ignore_hidden, callback);
-    worker->Queue();
-    return env.Undefined();
-}
-
-Napi::Value CompareFiles(const Napi::CallbackInfo &info)
-{
-    Napi::Env env = info.Env();
-    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsString() || !info[2].IsFunction())
+    ~SortedFolderCompareWorker()
     {
-        Napi::TypeError::New(env, "Params error: (string fileA, string fileB, function callback)").ThrowAsJavaScriptException();
-        return env.Null();
+        tsfn.Release();
     }
 
-    std::string file_a = info[0].As<Napi::String>().Utf8Value();
-    std::string file_b = info[1].As<Napi::String>().Utf8Value();
-    Napi::Function callback = info[2].As<Napi::Function>();
-
-    auto worker = new FileCompareWorker(env, file_a, file_b, callback);
-    worker->Queue();
-    return env.Undefined();
-}
-
-///////////////////////////// 新增：cursor鼠标坐标 N-API封装 /////////////////////////////////
-// 修复：自定义TrackCursorWorker（适配旧版AsyncWorker，移除override，自己实现数据存储）
-struct TrackCursorWorker : public Napi::AsyncWorker
-{
-    int interval_ms;
-    Napi::Function callback;
-    CursorManager &cursor_mgr;
-    std::atomic<bool> stop_flag;
-    // 自己实现数据存储（替代SetData/GetData）
-    std::string x_data;
-    std::string y_data;
-    std::string error_data;
-    // N-API线程安全回调
-    Napi::ThreadSafeFunction tsfn;
-
-    TrackCursorWorker(Napi::Env env, int interval, Napi::Function cb)
-        : Napi::AsyncWorker(env, "track-cursor-worker"),
-          interval_ms(interval), callback(cb),
-          cursor_mgr(CursorManager::GetInstance()), stop_flag(false)
+    void Execute() override
     {
-        // 创建线程安全函数（用于跨线程调用JS回调）
-        tsfn = Napi::ThreadSafeFunction::New(
-            env,
-            cb,
-            "TrackCursorCallback",
-            0,
-            1);
+        stats = g_file_compare->compare_folders_sorted(folder_a, folder_b, ignore_hidden,
+                                                       [this](std::vector<SortedDiffEntry> &batch)
+        {
+            // 等待JS处理完本批再继续：批次按序且先于最终回调送达，同时限制内存占用
+            Delivery delivery;
+            delivery.entries.swap(batch);
+            std::future<void> done = delivery.done.get_future();
+            auto deliver = [](Napi::Env env, Napi::Function jsCallback, Delivery *d)
+            {
+                try
+                {
+                    jsCallback.Call({EntriesToJs(env, d->entries)});
+                }
+                catch (...)
+                {
+                }
+                d->done.set_value();
+            };
+            if (tsfn.BlockingCall(&delivery, deliver) != napi_ok)
+            {
+                throw std::runtime_error("Failed to deliver sorted compare batch");
+            }
+            done.wait();
+        }, ignore);
+        if (!stats.error.empty())
+        {
+            SetError(stats.error);
+        }
     }
 
-    ~TrackCursorWorker()
+    static Napi::Array EntriesToJs(Napi::Env env, const std::vector<SortedDiffEntry> &entries)
     {
-        tsfn.Release();
+        Napi::Array arr = Napi::Array::New(env, entries.size());
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            const SortedDiffEntry &e = entries[i];
+            Napi::Object obj = Napi::Object::New(env);
+            obj.Set(Napi::String::New(env, "relPath"), Napi::String::New(env, e.rel_path));
+            obj.Set(Napi::String::New(env, "depth"), Napi::Number::New(env, e.depth));
+            obj.Set(Napi::String::New(env, "isDir"), Napi::Boolean::New(env, e.is_dir));
+            obj.Set(Napi::String::New(env, "status"), Napi::Number::New(env, (double)e.status));
+            obj.Set(Napi::String::New(env, "sizeA"), Napi::Number::New(env, (double)e.size_a));
+            obj.Set(Napi::String::New(env, "sizeB"), Napi::Number::New(env, (double)e.size_b));
+            obj.Set(Napi::String::New(env, "mtimeA"), Napi::Number::New(env, (double)e.mtime_a));
+            obj.Set(Napi::String::New(env, "mtimeB"), Napi::Number::New(env, (double)e.mtime_b));
+            obj.Set(Napi::String::New(env, "crcA"), Napi::String::New(env, format_crc32(e.crc_a)));
+            obj.Set(Napi::String::New(env, "crcB"), Napi::String::New(env, format_crc32(e.crc_b)));
+            arr.Set(i, obj);
+        }
+        return arr;
     }
 
-    // 修复：移除override，旧版AsyncWorker没有OnProgress
-    void OnProgress()
+    void OnOK() override
     {
         Napi::Env env = this->Env();
-        Napi::Object result = Napi::Object::New(env);
-        result.Set("x", Napi::Number::New(env, std::stoi(x_data)));
-        result.Set("y", Napi::Number::New(env, std::stoi(y_data)));
-        result.Set("error", Napi::String::New(env, error_data));
-        callback.Call({env.Null(), result});
+        Napi::Object res = Napi::Object::New(env);
+        res.Set(Napi::String::New(env, "added"), Napi::Number::New(env, (double)stats.added));
+        res.Set(Napi::String::New(env, "deleted"), Napi::Number::New(env, (double)stats.deleted));
+        res.Set(Napi::String::New(env, "modified"), Napi::Number::New(env, (double)stats.modified));
+        res.Set(Napi::String::New(env, "same"), Napi::Number::New(env, (double)stats.same));
+        callback.Call({env.Null(), res});
     }
 
-    // 修复：移除override，旧版AsyncWorker没有Cancel
-    void Cancel()
+    void OnError(const Napi::Error &e) override
     {
-        stop_flag = true;
-        cursor_mgr.StopTracking();
-        Napi::AsyncWorker::Cancel();
+        callback.Call({e.Value()});
     }
+};
 
-    void GlobalCleanup()
+// ---------------------- 5. 目录差异树：两侧对齐的扁平先序数组 ----------------------
+struct DiffTreeWorker : public Napi::AsyncWorker
+{
+    std::string folder_a;
+    std::string folder_b;
+    bool ignore_hidden;
+    IgnoreOptions ignore; // 可选忽略规则
+    DirDiffTree tree;
+    Napi::Function callback; // 手动保存回调
+
+    DiffTreeWorker(Napi::Env env, std::string a, std::string b, bool ih, Napi::Function cb)
+        : Napi::AsyncWorker(env, "diff-tree-worker"),
+          folder_a(a), folder_b(b), ignore_hidden(ih), callback(cb) {}
+
+    void Execute() override
     {
-        CursorManager::GetInstance().Cleanup();
+        tree = g_file_compare->diff_tree(folder_a, folder_b, ignore_hidden, ignore);
+        if (!tree.error.empty())
+        {
+            SetError(tree.error);
+        }
     }
 
-    void Execute() override
+    // 数值列用TypedArray返回，避免每个节点构造一个JS对象
+    // flags: bit0目录，bit1左侧存在，bit2右侧存在
+    void OnOK() override
     {
-        try
+        Napi::Env env = this->Env();
+        size_t n = tree.nodes.size();
+        Napi::Uint32Array parent = Napi::Uint32Array::New(env, n);
+        Napi::Uint32Array level = Napi::Uint32Array::New(env, n);
+        Napi::Uint8Array status = Napi::Uint8Array::New(env, n);
+        Napi::Uint8Array flags = Napi::Uint8Array::New(env, n);
+        Napi::Float64Array size_a = Napi::Float64Array::New(env, n);
+        Napi::Float64Array size_b = Napi::Float64Array::New(env, n);
+        Napi::Float64Array mtime_a = Napi::Float64Array::New(env, n);
+        Napi::Float64Array mtime_b = Napi::Float64Array::New(env, n);
+        Napi::Array names = Napi::Array::New(env, n);
+        for (size_t i = 0; i < n; ++i)
         {
-            // 纯C++回调函数（不能用lambda，必须是普通函数）
-            auto cursor_callback_func = [](const CursorPosition &pos, void *user_data)
-            {
-                TrackCursorWorker *worker = static_cast<TrackCursorWorker *>(user_data);
-                if (worker->stop_flag)
-                    return;
+            const DirDiffTree::Node &node = tree.nodes[i];
+            parent[i] = node.parent;
+            level[i] = node.level;
+            status[i] = (uint8_t)node.status;
+            flags[i] = (uint8_t)((node.is_folder ? 1 : 0) | (node.has_left ? 2 : 0) | (node.has_right ? 4 : 0));
+            size_a[i] = (double)node.size_a;
+            size_b[i] = (double)node.size_b;
+            mtime_a[i] = (double)node.mtime_a;
+            mtime_b[i] = (double)node.mtime_b;
+            names.Set(i, Napi::String::New(env, node.name));
+        }
 
-                // 存储数据（自己实现的SetData）
-                worker->x_data = std::to_string(pos.x);
-                worker->y_data = std::to_string(pos.y);
-                worker->error_data = pos.error;
+        Napi::Object res = Napi::Object::New(env);
+        res.Set(Napi::String::New(env, "rootA"), Napi::String::New(env, tree.root_a));
+        res.Set(Napi::String::New(env, "rootB"), Napi::String::New(env, tree.root_b));
+        res.Set(Napi::String::New(env, "parent"), parent);
+        res.Set(Napi::String::New(env, "level"), level);
+        res.Set(Napi::String::New(env, "status"), status);
+        res.Set(Napi::String::New(env, "flags"), flags);
+        res.Set(Napi::String::New(env, "sizeA"), size_a);
+        res.Set(Napi::String::New(env, "sizeB"), size_b);
+        res.Set(Napi::String::New(env, "mtimeA"), mtime_a);
+        res.Set(Napi::String::New(env, "mtimeB"), mtime_b);
+        res.Set(Napi::String::New(env, "names"), names);
+
+        Napi::Object stats = Napi::Object::New(env);
+        stats.Set(Napi::String::New(env, "identicalCount"), Napi::Number::New(env, (double)tree.identical));
+        stats.Set(Napi::String::New(env, "differentCount"), Napi::Number::New(env, (double)tree.different));
+        stats.Set(Napi::String::New(env, "leftOnlyCount"), Napi::Number::New(env, (double)tree.left_only));
+        stats.Set(Napi::String::New(env, "rightOnlyCount"), Napi::Number::New(env, (double)tree.right_only));
+        res.Set(Napi::String::New(env, "stats"), stats);
 
-                // 跨线程调用JS回调
-                auto callback = [](Napi::Env env, Napi::Function jsCallback, const CursorPosition *pos)
-                {
-                    Napi::Object result = Napi::Object::New(env);
-                    result.Set("x", Napi::Number::New(env, pos->x));
-                    result.Set("y", Napi::Number::New(env, pos->y));
-                    result.Set("error", Napi::String::New(env, pos->error));
-                    jsCallback.Call({env.Null(), result});
-                };
+        callback.Call({env.Null(), res});
+    }
 
-                worker->tsfn.BlockingCall(const_cast<CursorPosition *>(&pos), callback);
-            };
+    void OnError(const Napi::Error &e) override
+    {
+        callback.Call({e.Value()});
+    }
+};
 
-            // 构造回调结构体
-            CursorManager::TrackCallback callback{cursor_callback_func, this};
+// ---------------------- 6. 文件夹快照：生成Merkle树快照文件 ----------------------
+struct SnapshotWorker : public Napi::AsyncWorker
+{
+    std::string folder_path;
+    std::string out_path;
+    bool ignore_hidden;
+    IgnoreOptions ignore;     // 可选忽略规则
+    std::string baseline_path; // 可选基线快照：未变化的文件沿用其CRC
+    uint64_t nodes = 0;
+    uint64_t files = 0;
+    Napi::Function callback; // 手动保存回调
 
-            // 启动纯C++监听
-            cursor_mgr.StartTracking(interval_ms, callback);
+    SnapshotWorker(Napi::Env env, std::string p, std::string out, bool ih, Napi::Function cb)
+        : Napi::AsyncWorker(env, "snapshot-worker"),
+          folder_path(p), out_path(out), ignore_hidden(ih), callback(cb) {}
 
-            // 等待停止信号（修复：移除IsCancelled，用stop_flag）
-            while (!stop_flag)
+    void Execute() override
+    {
+        try
+        {
+            std::string error;
+            FolderSnapshot baseline;
+            bool has_baseline = !baseline_path.empty() && FolderSnapshot::load(baseline_path, baseline, error);
+            FolderSnapshot snap = g_file_compare->build_snapshot(folder_path, ignore_hidden, ignore, has_baseline ? &baseline : nullptr);
+            if (!snap.save(out_path, error))
             {
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                SetError(error);
+                return;
             }
+            nodes = snap.size();
+            files = snap.file_count();
         }
         catch (const std::exception &e)
         {
@@ -409,7 +512,11 @@ struct TrackCursorWorker : public Napi::AsyncWorker
     void OnOK() override
     {
         Napi::Env env = this->Env();
-        callback.Call({env.Null(), Napi::String::New(env, "Tracking stopped")});
+        Napi::Object res = Napi::Object::New(env);
+        res.Set(Napi::String::New(env, "path"), Napi::String::New(env, out_path));
+        res.Set(Napi::String::New(env, "nodes"), Napi::Number::New(env, (double)nodes));
+        res.Set(Napi::String::New(env, "files"), Napi::Number::New(env, (double)files));
+        callback.Call({env.Null(), res});
     }
 
     void OnError(const Napi::Error &e) override
@@ -418,126 +525,1565 @@ struct TrackCursorWorker : public Napi::AsyncWorker
     }
 };
 
-// 同步获取鼠标坐标（N-API封装）
-Napi::Value GetCursorPosition(const Napi::CallbackInfo &info)
+// ---------------------- 7. 重复文件查找：逐组流式返回 ----------------------
+struct FindDuplicatesWorker : public Napi::AsyncWorker
 {
-    Napi::Env env = info.Env();
-    Napi::Object result = Napi::Object::New(env);
-
-    try
+    // 一组重复文件与JS处理完成的通知
+    struct Delivery
     {
-        CursorManager &mgr = CursorManager::GetInstance();
-        mgr.Init(); // 初始化X11
-        CursorPosition pos = mgr.GetCursorPosition();
+        DuplicateGroup group;
+        std::promise<void> done;
+    };
 
-        result.Set("x", Napi::Number::New(env, pos.x));
-        result.Set("y", Napi::Number::New(env, pos.y));
-        result.Set("error", Napi::String::New(env, pos.error));
-    }
-    catch (const std::exception &e)
+    std::vector<std::string> roots;
+    DuplicateOptions options;
+    DuplicateStats stats;
+    Napi::Function callback; // 手动保存回调
+    Napi::ThreadSafeFunction tsfn; // 逐组回调
+
+    FindDuplicatesWorker(Napi::Env env, std::vector<std::string> r, Napi::Function on_group, Napi::Function cb)
+        : Napi::AsyncWorker(env, "find-duplicates-worker"),
+          roots(std::move(r)), callback(cb)
     {
-        result.Set("x", Napi::Number::New(env, -1));
-        result.Set("y", Napi::Number::New(env, -1));
-        result.Set("error", Napi::String::New(env, e.what()));
+        tsfn = Napi::ThreadSafeFunction::New(env, on_group, "FindDuplicatesGroup", 0, 1);
     }
 
-    return result;
-}
-
-// 异步监听鼠标坐标（N-API封装）
-Napi::Value TrackCursorAsync(const Napi::CallbackInfo &info)
-{
-    Napi::Env env = info.Env();
-    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsFunction())
+    ~FindDuplicatesWorker()
     {
-        Napi::TypeError::New(env, "Params error: (number intervalMs, function callback)").ThrowAsJavaScriptException();
-        return env.Null();
+        tsfn.Release();
     }
 
-    int interval_ms = info[0].As<Napi::Number>().Int32Value();
-    Napi::Function callback = info[1].As<Napi::Function>();
-
-    try
+    void Execute() override
     {
-        // 初始化CursorManager
-        CursorManager::GetInstance().Init();
-        auto worker = new TrackCursorWorker(env, interval_ms, callback);
-        worker->Queue();
+        stats = g_file_compare->find_duplicates(roots, options, [this](DuplicateGroup &group)
+        {
+            // 等待JS处理完本组再继续，保证所有组先于最终回调送达
+            Delivery delivery;
+            delivery.group = std::move(group);
+            std::future<void> done = delivery.done.get_future();
+            auto deliver = [](Napi::Env env, Napi::Function jsCallback, Delivery *d)
+            {
+                try
+                {
+                    Napi::Object obj = Napi::Object::New(env);
+                    obj.Set(Napi::String::New(env, "size"), Napi::Number::New(env, (double)d->group.size));
+                    obj.Set(Napi::String::New(env, "hash"), Napi::String::New(env, d->group.hash));
+                    Napi::Array paths = Napi::Array::New(env, d->group.paths.size());
+                    for (size_t i = 0; i < d->group.paths.size(); ++i)
+                    {
+                        paths.Set(i, Napi::String::New(env, d->group.paths[i]));
+                    }
+                    obj.Set(Napi::String::New(env, "paths"), paths);
+                    jsCallback.Call({obj});
+                }
+                catch (...)
+                {
+                }
+                d->done.set_value();
+            };
+            if (tsfn.BlockingCall(&delivery, deliver) != napi_ok)
+            {
+                throw std::runtime_error("Failed to deliver duplicate group");
+            }
+            done.wait();
+        });
+        if (!stats.error.empty())
+        {
+            SetError(stats.error);
+        }
     }
-    catch (const std::exception &e)
+
+    void OnOK() override
     {
-        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        Napi::Env env = this->Env();
+        Napi::Object res = Napi::Object::New(env);
+        res.Set(Napi::String::New(env, "files"), Napi::Number::New(env, (double)stats.files));
+        res.Set(Napi::String::New(env, "sizeCandidates"), Napi::Number::New(env, (double)stats.size_candidates));
+        res.Set(Napi::String::New(env, "partialCandidates"), Napi::Number::New(env, (double)stats.partial_candidates));
+        res.Set(Napi::String::New(env, "groups"), Napi::Number::New(env, (double)stats.groups));
+        res.Set(Napi::String::New(env, "duplicateFiles"), Napi::Number::New(env, (double)stats.duplicate_files));
+        res.Set(Napi::String::New(env, "wastedBytes"), Napi::Number::New(env, (double)stats.wasted_bytes));
+        res.Set(Napi::String::New(env, "bytesRead"), Napi::Number::New(env, (double)stats.bytes_read));
+        callback.Call({env.Null(), res});
     }
 
+    void OnError(const Napi::Error &e) override
+    {
+        callback.Call({e.Value()});
+    }
+};
+
+// ---------------------- 8. 二进制区域对比：按块哈希定位不同区间 ----------------------
+struct DiffRegionsWorker : public Napi::AsyncWorker
+{
+    std::string file_a;
+    std::string file_b;
+    uint64_t chunk_size;
+    BinaryRegionDiff result;
+    Napi::Function callback; // 手动保存回调
+
+    DiffRegionsWorker(Napi::Env env, std::string a, std::string b, uint64_t chunk, Napi::Function cb)
+        : Napi::AsyncWorker(env, "diff-regions-worker"),
+          file_a(a), file_b(b), chunk_size(chunk), callback(cb) {}
+
+    void Execute() override
+    {
+        result = g_file_compare->diff_regions(file_a, file_b, chunk_size);
+        if (!result.error.empty())
+        {
+            SetError(result.error);
+        }
+    }
+
+    void OnOK() override
+    {
+        Napi::Env env = this->Env();
+        Napi::Object res = Napi::Object::New(env);
+        res.Set(Napi::String::New(env, "sizeA"), Napi::Number::New(env, (double)result.size_a));
+        res.Set(Napi::String::New(env, "sizeB"), Napi::Number::New(env, (double)result.size_b));
+        res.Set(Napi::String::New(env, "chunkSize"), Napi::Number::New(env, (double)result.chunk_size));
+        res.Set(Napi::String::New(env, "crcA"), Napi::String::New(env, format_crc32(result.crc_a)));
+        res.Set(Napi::String::New(env, "crcB"), Napi::String::New(env, format_crc32(result.crc_b)));
+        Napi::Array ranges = Napi::Array::New(env, result.ranges.size());
+        for (size_t i = 0; i < result.ranges.size(); ++i)
+        {
+            Napi::Object obj = Napi::Object::New(env);
+            obj.Set(Napi::String::New(env, "offset"), Napi::Number::New(env, (double)result.ranges[i].first));
+            obj.Set(Napi::String::New(env, "length"), Napi::Number::New(env, (double)(result.ranges[i].second - result.ranges[i].first)));
+            ranges.Set(i, obj);
+        }
+        res.Set(Napi::String::New(env, "ranges"), ranges);
+        callback.Call({env.Null(), res});
+    }
+
+    void OnError(const Napi::Error &e) override
+    {
+        callback.Call({e.Value()});
+    }
+};
+
+// ---------------------- 9. 实时文件夹对比：inotify增量推送 ----------------------
+// 已启动的会话与其增量回调，按id登记，unwatchCompare时停止并释放
+struct LiveCompare
+{
+    std::unique_ptr<CompareSession> session;
+    Napi::ThreadSafeFunction tsfn;
+};
+static std::mutex g_live_mutex;
+static std::unordered_map<uint32_t, LiveCompare> g_live_sessions;
+static uint32_t g_next_live_id = 1;
+
+struct WatchCompareWorker : public Napi::AsyncWorker
+{
+    std::string folder_a;
+    std::string folder_b;
+    bool ignore_hidden;
+    IgnoreOptions ignore; // 可选忽略规则
+    std::unique_ptr<CompareSession> session;
+    SortedDiffStats stats;
+    Napi::Function callback; // 手动保存回调
+    Napi::ThreadSafeFunction tsfn; // 增量回调（初始结果也分批经此送达）
+
+    WatchCompareWorker(Napi::Env env, std::string a, std::string b, bool ih, Napi::Function on_delta, Napi::Function cb)
+        : Napi::AsyncWorker(env, "watch-compare-worker"),
+          folder_a(a), folder_b(b), ignore_hidden(ih), callback(cb)
+    {
+        tsfn = Napi::ThreadSafeFunction::New(env, on_delta, "WatchCompareDelta", 0, 1);
+    }
+
+    // 增量自带全部数据，不等待JS处理：会话线程不会被界面阻塞
+    static void Deliver(Napi::ThreadSafeFunction &tsfn, CompareDelta &delta)
+    {
+        auto *copy = new CompareDelta(std::move(delta));
+        auto deliver = [](Napi::Env env, Napi::Function jsCallback, CompareDelta *d)
+        {
+            try
+            {
+                Napi::Object obj = Napi::Object::New(env);
+                obj.Set(Napi::String::New(env, "initial"), Napi::Boolean::New(env, d->initial));
+                obj.Set(Napi::String::New(env, "changed"), SortedFolderCompareWorker::EntriesToJs(env, d->changed));
+                Napi::Array removed = Napi::Array::New(env, d->removed.size());
+                for (size_t i = 0; i < d->removed.size(); ++i)
+                {
+                    removed.Set(i, Napi::String::New(env, d->removed[i]));
+                }
+                obj.Set(Napi::String::New(env, "removed"), removed);
+                jsCallback.Call({obj});
+            }
+            catch (...)
+            {
+            }
+            delete d;
+        };
+        if (tsfn.BlockingCall(copy, deliver) != napi_ok)
+        {
+            delete copy;
+        }
+    }
+
+    void Execute() override
+    {
+        try
+        {
+            session = std::make_unique<CompareSession>(*g_file_compare, folder_a, folder_b, ignore_hidden, ignore);
+            Napi::ThreadSafeFunction fn = tsfn;
+            stats = session->start([fn](CompareDelta &delta) mutable { Deliver(fn, delta); });
+        }
+        catch (const std::exception &e)
+        {
+            session.reset();
+            SetError(e.what());
+        }
+    }
+
+    void OnOK() override
+    {
+        Napi::Env env = this->Env();
+        uint32_t id;
+        uint64_t watched = session->watched_dirs();
+        {
+            std::lock_guard<std::mutex> lock(g_live_mutex);
+            id = g_next_live_id++;
+            g_live_sessions[id] = LiveCompare{std::move(session), tsfn};
+        }
+        Napi::Object res = Napi::Object::New(env);
+        res.Set(Napi::String::New(env, "id"), Napi::Number::New(env, id));
+        res.Set(Napi::String::New(env, "watchedDirs"), Napi::Number::New(env, (double)watched));
+        res.Set(Napi::String::New(env, "added"), Napi::Number::New(env, (double)stats.added));
+        res.Set(Napi::String::New(env, "deleted"), Napi::Number::New(env, (double)stats.deleted));
+        res.Set(Napi::String::New(env, "modified"), Napi::Number::New(env, (double)stats.modified));
+        res.Set(Napi::String::New(env, "same"), Napi::Number::New(env, (double)stats.same));
+        callback.Call({env.Null(), res});
+    }
+
+    void OnError(const Napi::Error &e) override
+    {
+        tsfn.Release();
+        callback.Call({e.Value()});
+    }
+};
+
+// ---------------------- 注册N-API导出函数 ----------------------
+// 解析可选的忽略选项：{ ignorePatterns: string[]（gitignore语法）, gitignore: bool（读取各级.gitignore） }
+static bool ParseIgnoreOptions(const Napi::Value &value, IgnoreOptions &out)
+{
+    if (value.IsUndefined() || value.IsNull())
+        return true;
+    if (!value.IsObject() || value.IsFunction())
+        return false;
+    Napi::Object obj = value.As<Napi::Object>();
+    if (obj.Has("ignorePatterns"))
+    {
+        Napi::Value patterns = obj.Get("ignorePatterns");
+        if (!patterns.IsArray())
+            return false;
+        Napi::Array arr = patterns.As<Napi::Array>();
+        for (uint32_t i = 0; i < arr.Length(); ++i)
+        {
+            Napi::Value item = arr.Get(i);
+            if (!item.IsString())
+                return false;
+            out.patterns.push_back(item.As<Napi::String>().Utf8Value());
+        }
+    }
+    if (obj.Has("gitignore"))
+    {
+        out.use_gitignore = obj.Get("gitignore").ToBoolean().Value();
+    }
+    return true;
+}
+// (folderPath, ignoreHidden, [options], callback)
+Napi::Value ScanFolder(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    IgnoreOptions ignore;
+    bool has_options = info.Length() >= 4;
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsBoolean() || !info[info.Length() - 1].IsFunction() ||
+        (has_options && !ParseIgnoreOptions(info[2], ignore)))
+    {
+        Napi::TypeError::New(env, "Params error: (string folderPath, bool ignoreHidden, [object options], function callback)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string folder_path = info[0].As<Napi::String>().Utf8Value();
+    bool ignore_hidden = info[1].As<Napi::Boolean>().Value();
+    Napi::Function callback = info[info.Length() - 1].As<Napi::Function>();
+
+    auto worker = new ScanFolderWorker(env, folder_path, ignore_hidden, callback);
+    worker->ignore = std::move(ignore);
+    worker->Queue();
     return env.Undefined();
 }
 
-// 同步冻结屏幕
-Napi::Value FreezeScreen(const Napi::CallbackInfo &info)
+// (folderA, folderB, ignoreHidden, [options], callback)
+Napi::Value CompareFolders(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    IgnoreOptions ignore;
+    bool has_options = info.Length() >= 5;
+    if (info.Length() < 4 || !info[0].IsString() || !info[1].IsString() || !info[2].IsBoolean() || !info[info.Length() - 1].IsFunction() ||
+        (has_options && !ParseIgnoreOptions(info[3], ignore)))
+    {
+        Napi::TypeError::New(env, "Params error: (string folderA, string folderB, bool ignoreHidden, [object options], function callback)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string folder_a = info[0].As<Napi::String>().Utf8Value();
+    std::string folder_b = info[1].As<Napi::String>().Utf8Value();
+    bool ignore_hidden = info[2].As<Napi::Boolean>().Value();
+    Napi::Function callback = info[info.Length() - 1].As<Napi::Function>();
+
+    auto worker = new FolderCompareWorker(env, folder_a, folder_b, ignore_hidden, callback);
+    worker->ignore = std::move(ignore);
+    // options.detectRenames: 是否做重命名/移动检测（默认开启）
+    if (has_options && info[3].IsObject() && info[3].As<Napi::Object>().Has("detectRenames"))
+    {
+        worker->detect_renames = info[3].As<Napi::Object>().Get("detectRenames").ToBoolean().Value();
+    }
+    worker->Queue();
+    return env.Undefined();
+}
+
+// 有序文件夹比对：onBatch按路径顺序多次收到条目数组，callback最后收到统计
+// (folderA, folderB, ignoreHidden, [options], onBatch, callback)
+Napi::Value CompareFoldersSorted(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    IgnoreOptions ignore;
+    bool has_options = info.Length() >= 6;
+    size_t n = info.Length();
+    if (n < 5 || !info[0].IsString() || !info[1].IsString() || !info[2].IsBoolean() || !info[n - 2].IsFunction() || !info[n - 1].IsFunction() ||
+        (has_options && !ParseIgnoreOptions(info[3], ignore)))
+    {
+        Napi::TypeError::New(env, "Params error: (string folderA, string folderB, bool ignoreHidden, [object options], function onBatch, function callback)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string folder_a = info[0].As<Napi::String>().Utf8Value();
+    std::string folder_b = info[1].As<Napi::String>().Utf8Value();
+    bool ignore_hidden = info[2].As<Napi::Boolean>().Value();
+    Napi::Function on_batch = info[n - 2].As<Napi::Function>();
+    Napi::Function callback = info[n - 1].As<Napi::Function>();
+
+    auto worker = new SortedFolderCompareWorker(env, folder_a, folder_b, ignore_hidden, on_batch, callback);
+    worker->ignore = std::move(ignore);
+    worker->Queue();
+    return env.Undefined();
+}
+
+// (folderA, folderB, ignoreHidden, [options], callback)
+Napi::Value DiffFolderTree(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    IgnoreOptions ignore;
+    bool has_options = info.Length() >= 5;
+    if (info.Length() < 4 || !info[0].IsString() || !info[1].IsString() || !info[2].IsBoolean() || !info[info.Length() - 1].IsFunction() ||
+        (has_options && !ParseIgnoreOptions(info[3], ignore)))
+    {
+        Napi::TypeError::New(env, "Params error: (string folderA, string folderB, bool ignoreHidden, [object options], function callback)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string folder_a = info[0].As<Napi::String>().Utf8Value();
+    std::string folder_b = info[1].As<Napi::String>().Utf8Value();
+    bool ignore_hidden = info[2].As<Napi::Boolean>().Value();
+    Napi::Function callback = info[info.Length() - 1].As<Napi::Function>();
+
+    auto worker = new DiffTreeWorker(env, folder_a, folder_b, ignore_hidden, callback);
+    worker->ignore = std::move(ignore);
+    worker->Queue();
+    return env.Undefined();
+}
+
+// 生成快照文件：(folderPath, outPath, ignoreHidden, [options], callback)
+// options除忽略规则外可带baseline（旧快照路径），生成的快照可直接作为compareFolders的任一侧
+Napi::Value CreateSnapshot(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    IgnoreOptions ignore;
+    bool has_options = info.Length() >= 5;
+    if (info.Length() < 4 || !info[0].IsString() || !info[1].IsString() || !info[2].IsBoolean() || !info[info.Length() - 1].IsFunction() ||
+        (has_options && !ParseIgnoreOptions(info[3], ignore)))
+    {
+        Napi::TypeError::New(env, "Params error: (string folderPath, string outPath, bool ignoreHidden, [object options], function callback)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string folder_path = info[0].As<Napi::String>().Utf8Value();
+    std::string out_path = info[1].As<Napi::String>().Utf8Value();
+    bool ignore_hidden = info[2].As<Napi::Boolean>().Value();
+    Napi::Function callback = info[info.Length() - 1].As<Napi::Function>();
+
+    auto worker = new SnapshotWorker(env, folder_path, out_path, ignore_hidden, callback);
+    worker->ignore = std::move(ignore);
+    if (has_options && info[3].IsObject() && info[3].As<Napi::Object>().Has("baseline"))
+    {
+        Napi::Value baseline = info[3].As<Napi::Object>().Get("baseline");
+        if (baseline.IsString())
+        {
+            worker->baseline_path = baseline.As<Napi::String>().Utf8Value();
+        }
+    }
+    worker->Queue();
+    return env.Undefined();
+}
+
+// 查找重复文件：onGroup每确认一组收到{size, hash, paths}，callback最后收到统计
+// (roots: string[], [options], onGroup, callback)
+// options除忽略规则外可带ignoreHidden与minSize（字节，默认1即排除空文件）
+Napi::Value FindDuplicates(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    DuplicateOptions options;
+    bool has_options = info.Length() >= 4;
+    size_t n = info.Length();
+    if (n < 3 || !info[0].IsArray() || !info[n - 2].IsFunction() || !info[n - 1].IsFunction() ||
+        (has_options && !ParseIgnoreOptions(info[1], options.ignore)))
+    {
+        Napi::TypeError::New(env, "Params error: (string[] roots, [object options], function onGroup, function callback)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::vector<std::string> roots;
+    Napi::Array arr = info[0].As<Napi::Array>();
+    for (uint32_t i = 0; i < arr.Length(); ++i)
+    {
+        Napi::Value item = arr.Get(i);
+        if (!item.IsString())
+        {
+            Napi::TypeError::New(env, "Params error: roots must be string[]").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        roots.push_back(item.As<Napi::String>().Utf8Value());
+    }
+    if (roots.empty())
+    {
+        Napi::TypeError::New(env, "Params error: roots is empty").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (has_options && info[1].IsObject())
+    {
+        Napi::Object obj = info[1].As<Napi::Object>();
+        if (obj.Has("ignoreHidden"))
+        {
+            options.ignore_hidden = obj.Get("ignoreHidden").ToBoolean().Value();
+        }
+        if (obj.Has("minSize") && obj.Get("minSize").IsNumber())
+        {
+            double min_size = obj.Get("minSize").As<Napi::Number>().DoubleValue();
+            options.min_size = min_size > 1 ? (uint64_t)min_size : 1;
+        }
+    }
+
+    Napi::Function on_group = info[n - 2].As<Napi::Function>();
+    Napi::Function callback = info[n - 1].As<Napi::Function>();
+
+    auto worker = new FindDuplicatesWorker(env, std::move(roots), on_group, callback);
+    worker->options = std::move(options);
+    worker->Queue();
+    return env.Undefined();
+}
+
+Napi::Value CompareFiles(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsString() || !info[2].IsFunction())
+    {
+        Napi::TypeError::New(env, "Params error: (string fileA, string fileB, function callback)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string file_a = info[0].As<Napi::String>().Utf8Value();
+    std::string file_b = info[1].As<Napi::String>().Utf8Value();
+    Napi::Function callback = info[2].As<Napi::Function>();
+
+    auto worker = new FileCompareWorker(env, file_a, file_b, callback);
+    worker->Queue();
+    return env.Undefined();
+}
+
+// 二进制区域对比：(fileA, fileB, [chunkSize], callback)，返回不同的字节区间
+Napi::Value DiffFileRegions(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    size_t n = info.Length();
+    if (n < 3 || !info[0].IsString() || !info[1].IsString() || !info[n - 1].IsFunction() ||
+        (n >= 4 && !info[2].IsNumber()))
+    {
+        Napi::TypeError::New(env, "Params error: (string fileA, string fileB, [number chunkSize], function callback)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string file_a = info[0].As<Napi::String>().Utf8Value();
+    std::string file_b = info[1].As<Napi::String>().Utf8Value();
+    uint64_t chunk_size = ChunkedHash::kDefaultChunkSize;
+    if (n >= 4 && info[2].As<Napi::Number>().DoubleValue() > 0)
+    {
+        chunk_size = (uint64_t)info[2].As<Napi::Number>().DoubleValue();
+    }
+    Napi::Function callback = info[n - 1].As<Napi::Function>();
+
+    auto worker = new DiffRegionsWorker(env, file_a, file_b, chunk_size, callback);
+    worker->Queue();
+    return env.Undefined();
+}
+
+// 实时文件夹比对：onDelta先分批收到初始结果（initial为true），之后收到文件变化引起的增量
+// (folderA, folderB, ignoreHidden, [options], onDelta, callback)，callback收到{id, ...统计}
+Napi::Value WatchCompare(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    IgnoreOptions ignore;
+    bool has_options = info.Length() >= 6;
+    size_t n = info.Length();
+    if (n < 5 || !info[0].IsString() || !info[1].IsString() || !info[2].IsBoolean() || !info[n - 2].IsFunction() || !info[n - 1].IsFunction() ||
+        (has_options && !ParseIgnoreOptions(info[3], ignore)))
+    {
+        Napi::TypeError::New(env, "Params error: (string folderA, string folderB, bool ignoreHidden, [object options], function onDelta, function callback)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string folder_a = info[0].As<Napi::String>().Utf8Value();
+    std::string folder_b = info[1].As<Napi::String>().Utf8Value();
+    bool ignore_hidden = info[2].As<Napi::Boolean>().Value();
+    Napi::Function on_delta = info[n - 2].As<Napi::Function>();
+    Napi::Function callback = info[n - 1].As<Napi::Function>();
+
+    auto worker = new WatchCompareWorker(env, folder_a, folder_b, ignore_hidden, on_delta, callback);
+    worker->ignore = std::move(ignore);
+    worker->Queue();
+    return env.Undefined();
+}
+
+// 停止实时比对会话：(id)，会话不存在返回false
+Napi::Value UnwatchCompare(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsNumber())
+    {
+        Napi::TypeError::New(env, "Params error: (number id)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    uint32_t id = info[0].As<Napi::Number>().Uint32Value();
+    LiveCompare live;
+    {
+        std::lock_guard<std::mutex> lock(g_live_mutex);
+        auto it = g_live_sessions.find(id);
+        if (it == g_live_sessions.end())
+        {
+            return Napi::Boolean::New(env, false);
+        }
+        live = std::move(it->second);
+        g_live_sessions.erase(it);
+    }
+    live.session->stop();
+    live.tsfn.Release();
+    return Napi::Boolean::New(env, true);
+}
+
+// 取消进行中的文件夹扫描/比对（被取消的任务回调收到错误）
+Napi::Value CancelScans(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    g_file_compare->cancel_scans();
+    return env.Undefined();
+}
+
+///////////////////////////// 新增：cursor鼠标坐标 N-API封装 /////////////////////////////////
+// 修复：自定义TrackCursorWorker（适配旧版AsyncWorker，移除override，自己实现数据存储）
+struct TrackCursorWorker : public Napi::AsyncWorker
+{
+    int interval_ms;
+    Napi::Function callback;
+    CursorManager &cursor_mgr;
+    std::atomic<bool> stop_flag;
+    // 自己实现数据存储（替代SetData/GetData）
+    std::string x_data;
+    std::string y_data;
+    std::string error_data;
+    // N-API线程安全回调
+    Napi::ThreadSafeFunction tsfn;
+
+    TrackCursorWorker(Napi::Env env, int interval, Napi::Function cb)
+        : Napi::AsyncWorker(env, "track-cursor-worker"),
+          interval_ms(interval), callback(cb),
+          cursor_mgr(CursorManager::GetInstance()), stop_flag(false)
+    {
+        // 创建线程安全函数（用于跨线程调用JS回调）
+        tsfn = Napi::ThreadSafeFunction::New(
+            env,
+            cb,
+            "TrackCursorCallback",
+            0,
+            1);
+    }
+
+    ~TrackCursorWorker()
+    {
+        tsfn.Release();
+    }
+
+    // 修复：移除override，旧版AsyncWorker没有OnProgress
+    void OnProgress()
+    {
+        Napi::Env env = this->Env();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("x", Napi::Number::New(env, std::stoi(x_data)));
+        result.Set("y", Napi::Number::New(env, std::stoi(y_data)));
+        result.Set("error", Napi::String::New(env, error_data));
+        callback.Call({env.Null(), result});
+    }
+
+    // 修复：移除override，旧版AsyncWorker没有Cancel
+    void Cancel()
+    {
+        stop_flag = true;
+        cursor_mgr.StopTracking();
+        Napi::AsyncWorker::Cancel();
+    }
+
+    void GlobalCleanup()
+    {
+        CursorManager::GetInstance().Cleanup();
+    }
+
+    void Execute() override
+    {
+        try
+        {
+            // 纯C++回调函数（不能用lambda，必须是普通函数）
+            auto cursor_callback_func = [](const CursorPosition &pos, void *user_data)
+            {
+                TrackCursorWorker *worker = static_cast<TrackCursorWorker *>(user_data);
+                if (worker->stop_flag)
+                    return;
+
+                // 存储数据（自己实现的SetData）
+                worker->x_data = std::to_string(pos.x);
+                worker->y_data = std::to_string(pos.y);
+                worker->error_data = pos.error;
+
+                // 跨线程调用JS回调
+                auto callback = [](Napi::Env env, Napi::Function jsCallback, const CursorPosition *pos)
+                {
+                    Napi::Object result = Napi::Object::New(env);
+                    result.Set("x", Napi::Number::New(env, pos->x));
+                    result.Set("y", Napi::Number::New(env, pos->y));
+                    result.Set("error", Napi::String::New(env, pos->error));
+                    jsCallback.Call({env.Null(), result});
+                };
+
+                worker->tsfn.BlockingCall(const_cast<CursorPosition *>(&pos), callback);
+            };
+
+            // 构造回调结构体
+            CursorManager::TrackCallback callback{cursor_callback_func, this};
+
+            // 启动纯C++监听
+            cursor_mgr.StartTracking(interval_ms, callback);
+
+            // 等待停止信号（修复：移除IsCancelled，用stop_flag）
+            while (!stop_flag)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+        catch (const std::exception &e)
+        {
+            SetError(e.what());
+        }
+    }
+
+    void OnOK() override
+    {
+        Napi::Env env = this->Env();
+        callback.Call({env.Null(), Napi::String::New(env, "Tracking stopped")});
+    }
+
+    void OnError(const Napi::Error &e) override
+    {
+        callback.Call({e.Value()});
+    }
+};
+
+// 同步获取鼠标坐标（N-API封装）
+Napi::Value GetCursorPosition(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    Napi::Object result = Napi::Object::New(env);
+
+    try
+    {
+        CursorManager &mgr = CursorManager::GetInstance();
+        mgr.Init(); // 初始化X11
+        CursorPosition pos = mgr.GetCursorPosition();
+
+        result.Set("x", Napi::Number::New(env, pos.x));
+        result.Set("y", Napi::Number::New(env, pos.y));
+        result.Set("error", Napi::String::New(env, pos.error));
+    }
+    catch (const std::exception &e)
+    {
+        result.Set("x", Napi::Number::New(env, -1));
+        result.Set("y", Napi::Number::New(env, -1));
+        result.Set("error", Napi::String::New(env, e.what()));
+    }
+
+    return result;
+}
+
+// 异步监听鼠标坐标（N-API封装）
+Napi::Value TrackCursorAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsFunction())
+    {
+        Napi::TypeError::New(env, "Params error: (number intervalMs, function callback)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    int interval_ms = info[0].As<Napi::Number>().Int32Value();
+    Napi::Function callback = info[1].As<Napi::Function>();
+
+    try
+    {
+        // 初始化CursorManager
+        CursorManager::GetInstance().Init();
+        auto worker = new TrackCursorWorker(env, interval_ms, callback);
+        worker->Queue();
+    }
+    catch (const std::exception &e)
+    {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    }
+
+    return env.Undefined();
+}
+
+// 同步冻结屏幕
+Napi::Value FreezeScreen(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    bool result = ScreenFreeze::GetInstance().FreezeScreen();
+    return Napi::Boolean::New(env, result);
+}
+
+// 同步解冻屏幕
+Napi::Value UnFreezeScreen(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    ScreenFreeze::GetInstance().UnFreezeScreen();
+    // 修复1：替换env.Boolean(true)为标准写法
+    return Napi::Boolean::New(env, true);
+}
+
+// 检查是否冻结
+Napi::Value IsScreenFrozen(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    bool is_locked = ScreenFreeze::GetInstance().IsScreenFrozen();
+    // 修复2：替换env.Boolean(is_locked)为标准写法
+    return Napi::Boolean::New(env, is_locked);
+}
+
+// 共享内存
+Napi::Value init(const Napi::CallbackInfo &i)
+{
+    Napi::Env env = i.Env();
+    bool ok = g.open();
+    return Napi::Boolean::New(env, ok);
+}
+
+// openChannel(name[, {populate, hugePages, lock, numaNode}])：选项作用于本进程的映射，生效情况见channelStats().mapping
+Napi::Value openChannel(const Napi::CallbackInfo &i)
+{
+    Napi::Env env = i.Env();
+    std::string name = i[0].As<Napi::String>();
+    ShmMapOptions opt;
+    if (i.Length() > 1 && i[1].IsObject())
+    {
+        Napi::Object o = i[1].As<Napi::Object>();
+        opt.populate = o.Get("populate").ToBoolean();
+        opt.huge_pages = o.Get("hugePages").ToBoolean();
+        opt.lock = o.Get("lock").ToBoolean();
+        if (o.Get("numaNode").IsNumber())
+            opt.numa_node = o.Get("numaNode").As<Napi::Number>().Int32Value();
+    }
+    std::lock_guard<std::mutex> lock(g_shm_mutex);
+    bool ok = chan.open(name.c_str(), 2048, opt);
+    return Napi::Boolean::New(env, ok);
+}
+
+Napi::Value readBinary(const Napi::CallbackInfo &i)
+{
+    Napi::Env env = i.Env();
+    Napi::Number num = i[0].As<Napi::Number>();
+    uint8_t rid = static_cast<uint8_t>(num.Int32Value());  // 明确调用 Int32Value()
+    ShmMessage msg;
+    if (!chan.pop(rid, msg))
+        return env.Null();
+
+    Napi::Object o = Napi::Object::New(env);
+    o.Set("id", (double)msg.id);
+    o.Set("type", (int)msg.channel_type);
+    o.Set("offset", (double)msg.file_offset);
+    o.Set("len", (int)msg.data_len);
+    return o;
+}
+
+// 批量读取的记录格式（小端，8字节对齐，JS可用DataView或BigUint64Array按下标访问）：
+// [0]id u64 | [8]offset u64 | [16]ts u64 | [24]type u32 | [28]len u32 |
+// [32]payloadEnd u64（释放位置） | [40]payloadOffset u32（在payloadBuffer中的偏移） | [44]payloadLen u32
+struct ShmBatchRecord
+{
+    uint64_t id;
+    uint64_t file_offset;
+    uint64_t ts;
+    uint32_t channel_type;
+    uint32_t data_len;
+    uint64_t payload_end;
+    uint32_t payload_offset;
+    uint32_t payload_len;
+};
+static_assert(sizeof(ShmBatchRecord) == 48, "ShmBatchRecord layout is shared with JS");
+static constexpr size_t kShmBatchMax = 4096; // 批量缓冲可容纳的记录数
+
+// 每个JS环境一份的共享内存状态（随环境销毁释放）
+struct ShmEnvState
+{
+    Napi::Reference<Napi::ArrayBuffer> batch; // readBatch复用的缓冲（V8分配，兼容禁止外部缓冲的Electron）
+    std::vector<ShmMessage> scratch = std::vector<ShmMessage>(kShmBatchMax);
+    ShmRpcClient rpc;                              // 本线程的RPC连接
+    Napi::Reference<Napi::ArrayBuffer> rpc_buffer; // rpcCall的响应缓冲
+};
+
+static ShmEnvState &GetShmState(Napi::Env env)
+{
+    ShmEnvState *state = env.GetInstanceData<ShmEnvState>();
+    if (!state)
+    {
+        state = new ShmEnvState();
+        state->batch = Napi::Persistent(Napi::ArrayBuffer::New(env, kShmBatchMax * sizeof(ShmBatchRecord)));
+        state->rpc_buffer = Napi::Persistent(Napi::ArrayBuffer::New(env, SHM_RPC_INLINE));
+        env.SetInstanceData(state);
+    }
+    return *state;
+}
+
+// 批量读取缓冲：返回readBatch写入的ArrayBuffer（每个环境一个，可长期持有）
+Napi::Value batchBuffer(const Napi::CallbackInfo &info)
+{
+    return GetShmState(info.Env()).batch.Value();
+}
+
+// 批量读取：(readerId, maxCount)，最多kShmBatchMax条按ShmBatchRecord格式写入batchBuffer()，返回条数
+// 一次调用可取走整批消息，避免逐条构造对象
+Napi::Value readBatch(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
-    bool result = ScreenFreeze::GetInstance().FreezeScreen();
-    return Napi::Boolean::New(env, result);
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber())
+    {
+        Napi::TypeError::New(env, "Params error: (number readerId, number maxCount)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    uint32_t rid = info[0].As<Napi::Number>().Uint32Value();
+    size_t max_count = std::min<size_t>(info[1].As<Napi::Number>().Uint32Value(), kShmBatchMax);
+    if (!chan.isOpen() || rid >= MAX_READERS)
+    {
+        Napi::Error::New(env, "Channel not opened or invalid readerId").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    ShmEnvState &state = GetShmState(env);
+    size_t n = chan.popBatch((uint8_t)rid, state.scratch.data(), max_count);
+    ShmBatchRecord *out = static_cast<ShmBatchRecord *>(state.batch.Value().Data());
+    const uint8_t *arena = chan.payloadBase();
+    for (size_t k = 0; k < n; ++k)
+    {
+        const ShmMessage &msg = state.scratch[k];
+        const uint8_t *payload = chan.payload(msg);
+        out[k] = ShmBatchRecord{msg.id, msg.file_offset, msg.ts, msg.channel_type, msg.data_len,
+                                payload ? msg.payload_pos + msg.payload_len : 0,
+                                payload ? (uint32_t)(payload - arena) : 0,
+                                payload ? msg.payload_len : 0};
+    }
+    return Napi::Number::New(env, (double)n);
 }
 
-// 同步解冻屏幕
-Napi::Value UnFreezeScreen(const Napi::CallbackInfo &info)
+// 负载区：返回覆盖整个通道负载区的外部ArrayBuffer（零拷贝，按记录中的payloadOffset/payloadLen取视图）
+// 负载区随通道映射常驻，不需要finalizer；运行时禁止外部缓冲（Electron内存沙箱）时返回null，改用copyPayload
+Napi::Value payloadBuffer(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
-    ScreenFreeze::GetInstance().UnFreezeScreen();
-    // 修复1：替换env.Boolean(true)为标准写法
-    return Napi::Boolean::New(env, true);
+    if (!chan.isOpen() || !chan.payloadBase())
+        return env.Null();
+    napi_value buffer;
+    napi_status status = napi_create_external_arraybuffer(env, (void *)chan.payloadBase(), chan.payloadSize(),
+                                                          nullptr, nullptr, &buffer);
+    if (status != napi_ok)
+        return env.Null();
+    return Napi::ArrayBuffer(env, buffer);
 }
 
-// 检查是否冻结
-Napi::Value IsScreenFrozen(const Napi::CallbackInfo &info)
+// 负载复制（禁止外部缓冲时的回退）：(payloadOffset, payloadLen) -> Buffer
+Napi::Value copyPayload(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
-    bool is_locked = ScreenFreeze::GetInstance().IsScreenFrozen();
-    // 修复2：替换env.Boolean(is_locked)为标准写法
-    return Napi::Boolean::New(env, is_locked);
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber())
+    {
+        Napi::TypeError::New(env, "Params error: (number payloadOffset, number payloadLen)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    uint32_t offset = info[0].As<Napi::Number>().Uint32Value();
+    uint32_t len = info[1].As<Napi::Number>().Uint32Value();
+    if (!chan.isOpen() || !chan.payloadBase() || (uint64_t)offset + len > chan.payloadSize())
+    {
+        Napi::RangeError::New(env, "Payload out of range").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Napi::Buffer<uint8_t>::Copy(env, chan.payloadBase() + offset, len);
 }
 
-// 共享内存
-Napi::Value init(const Napi::CallbackInfo &i)
+// 负载持有模式：(readerId, hold)。持有时读到的负载一直有效，直到releasePayload；否则只保留到下一次读取
+Napi::Value holdPayloads(const Napi::CallbackInfo &info)
 {
-    Napi::Env env = i.Env();
-    bool ok = g.open();
-    return Napi::Boolean::New(env, ok);
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsBoolean())
+    {
+        Napi::TypeError::New(env, "Params error: (number readerId, boolean hold)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (!chan.isOpen())
+        return Napi::Boolean::New(env, false);
+    chan.holdPayloads((uint8_t)info[0].As<Napi::Number>().Uint32Value(), info[1].As<Napi::Boolean>().Value());
+    return Napi::Boolean::New(env, true);
 }
 
-Napi::Value openChannel(const Napi::CallbackInfo &i)
+// 释放负载：(readerId, payloadEnd)，payloadEnd取记录中的值（BigInt或Number），释放其之前的全部负载
+Napi::Value releasePayload(const Napi::CallbackInfo &info)
 {
-    Napi::Env env = i.Env();
-    std::string name = i[0].As<Napi::String>();
-    bool ok = chan.open(name.c_str());
-    return Napi::Boolean::New(env, ok);
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[0].IsNumber() || !(info[1].IsBigInt() || info[1].IsNumber()))
+    {
+        Napi::TypeError::New(env, "Params error: (number readerId, bigint payloadEnd)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    uint64_t end = 0;
+    if (info[1].IsBigInt())
+    {
+        bool lossless = true;
+        end = info[1].As<Napi::BigInt>().Uint64Value(&lossless);
+    }
+    else
+    {
+        end = (uint64_t)info[1].As<Napi::Number>().DoubleValue();
+    }
+    if (!chan.isOpen())
+        return Napi::Boolean::New(env, false);
+    chan.releasePayload((uint8_t)info[0].As<Napi::Number>().Uint32Value(), end);
+    return Napi::Boolean::New(env, true);
 }
 
-Napi::Value readBinary(const Napi::CallbackInfo &i)
+// 通道统计（头部常驻计数，任何进程可读）：返回{policy, blockTimeoutMs, spillPath, journalPath, oldestSeq,
+// pushes, drops, overwrites, spills, maxLag, waits, waitMs, journalErrors, readers: [{id, seq, lag, lost}],
+// mapping: {populated, hugePages, locked, numa}}，计数为Number，mapping为本进程映射上实际生效的选项
+Napi::Value channelStats(const Napi::CallbackInfo &info)
 {
-    Napi::Env env = i.Env();
-    Napi::Number num = i[0].As<Napi::Number>();
-    uint8_t rid = static_cast<uint8_t>(num.Int32Value());  // 明确调用 Int32Value()
-    ShmMessage msg;
-    if (!chan.pop(rid, msg))
+    Napi::Env env = info.Env();
+    std::lock_guard<std::mutex> lock(g_shm_mutex);
+    if (!chan.isOpen())
         return env.Null();
+    const ShmChannelHeader *hdr = chan.header();
+    const ShmChannelStats &st = hdr->stats;
+    uint64_t w = chan.writeSeq();
 
     Napi::Object o = Napi::Object::New(env);
-    o.Set("id", (double)msg.id);
-    o.Set("type", (int)msg.channel_type);
-    o.Set("offset", (double)msg.file_offset);
-    o.Set("len", (int)msg.data_len);
+    o.Set("policy", hdr->overflow_policy.load(std::memory_order_relaxed));
+    o.Set("blockTimeoutMs", hdr->block_timeout_ms.load(std::memory_order_relaxed));
+    o.Set("spillPath", std::string(hdr->spill_path, strnlen(hdr->spill_path, DATA_PATH_MAX)));
+    o.Set("journalPath", std::string(hdr->journal_path, strnlen(hdr->journal_path, DATA_PATH_MAX)));
+    o.Set("oldestSeq", (double)chan.oldest());
+    o.Set("pushes", (double)w);
+    o.Set("drops", (double)st.drops.load(std::memory_order_relaxed));
+    o.Set("overwrites", (double)st.overwrites.load(std::memory_order_relaxed));
+    o.Set("spills", (double)st.spills.load(std::memory_order_relaxed));
+    o.Set("maxLag", (double)st.max_lag.load(std::memory_order_relaxed));
+    o.Set("waits", (double)st.waits.load(std::memory_order_relaxed));
+    o.Set("waitMs", st.wait_ns.load(std::memory_order_relaxed) / 1e6);
+    o.Set("journalErrors", (double)st.journal_errors.load(std::memory_order_relaxed));
+
+    Napi::Array readers = Napi::Array::New(env);
+    uint32_t n = 0;
+    for (uint8_t rid = 0; rid < MAX_READERS; rid++)
+    {
+        if (!chan.isAttached(rid))
+            continue;
+        uint64_t seq = chan.readSeq(rid);
+        Napi::Object r = Napi::Object::New(env);
+        r.Set("id", rid);
+        r.Set("seq", (double)seq);
+        r.Set("lag", (double)(w > seq ? w - seq : 0));
+        r.Set("lost", (double)chan.lost(rid));
+        readers.Set(n++, r);
+    }
+    o.Set("readers", readers);
+
+    uint32_t mf = chan.mapFlags();
+    Napi::Object mapping = Napi::Object::New(env);
+    mapping.Set("populated", (mf & SHM_MAP_POPULATED) != 0);
+    mapping.Set("hugePages", (mf & SHM_MAP_HUGE_PAGES) != 0);
+    mapping.Set("locked", (mf & SHM_MAP_LOCKED) != 0);
+    mapping.Set("numa", (mf & SHM_MAP_NUMA) != 0);
+    o.Set("mapping", mapping);
     return o;
 }
 
+// 读者自上次查询以来是否被写端超过而跳过了消息（查询后清除）：(readerId) -> boolean
+Napi::Value takeLagged(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsNumber())
+    {
+        Napi::TypeError::New(env, "Params error: (number readerId)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::lock_guard<std::mutex> lock(g_shm_mutex);
+    if (!chan.isOpen())
+        return Napi::Boolean::New(env, false);
+    return Napi::Boolean::New(env, chan.takeLagged((uint8_t)info[0].As<Napi::Number>().Uint32Value()));
+}
+
+// 读取溢出文件：(path, offset, maxCount) -> {records: [{id, type, offset, len, ts, payload}], next}
+// offset取上一次返回的next（从0开始）；payload为Buffer，无负载时为null；文件不存在返回null
+Napi::Value readSpill(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsNumber() || !info[2].IsNumber())
+    {
+        Napi::TypeError::New(env, "Params error: (string path, number offset, number maxCount)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    uint64_t offset = (uint64_t)info[1].As<Napi::Number>().DoubleValue();
+    uint32_t max_count = info[2].As<Napi::Number>().Uint32Value();
+
+    FILE *fp = ShmSpill::openRead(path.c_str(), offset);
+    if (!fp)
+        return env.Null();
+    Napi::Array records = Napi::Array::New(env);
+    ShmMessage msg;
+    std::vector<uint8_t> payload;
+    uint32_t n = 0;
+    while (n < max_count && ShmSpill::next(fp, msg, payload))
+    {
+        Napi::Object o = Napi::Object::New(env);
+        o.Set("id", (double)msg.id);
+        o.Set("type", (int)msg.channel_type);
+        o.Set("offset", (double)msg.file_offset);
+        o.Set("len", (int)msg.data_len);
+        o.Set("ts", (double)msg.ts);
+        if (payload.empty())
+            o.Set("payload", env.Null());
+        else
+            o.Set("payload", Napi::Buffer<uint8_t>::Copy(env, payload.data(), payload.size()));
+        records.Set(n++, o);
+        offset += ShmSpill::recordSize(msg.payload_len);
+    }
+    fclose(fp);
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("records", records);
+    result.Set("next", (double)offset);
+    return result;
+}
+
+// 读取通道日志中的历史：(path, fromSeq, maxCount) -> {records: [{seq, id, type, offset, len, ts, payload, gap}], next, first}
+// fromSeq早于日志开头时从first开始；next为下一次应读取的序号。日志不存在返回null
+// gap为true表示负载超过日志段容量没有写入（payload为null）；写端切换日志段失败期间的消息没有记录，seq会跳过
+// 追上实时环（next >= channelStats().oldestSeq）后用seekRead切换到环
+Napi::Value readJournal(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsNumber() || !info[2].IsNumber())
+    {
+        Napi::TypeError::New(env, "Params error: (string path, number fromSeq, number maxCount)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    uint64_t from = (uint64_t)info[1].As<Napi::Number>().DoubleValue();
+    uint32_t max_count = info[2].As<Napi::Number>().Uint32Value();
+
+    ShmJournalReader reader;
+    if (!reader.open(path.c_str()))
+        return env.Null();
+    if (from < reader.firstSeq())
+        from = reader.firstSeq();
+    Napi::Array records = Napi::Array::New(env);
+    uint64_t next = from;
+    if (reader.seek(from))
+    {
+        uint64_t seq;
+        ShmMessage msg;
+        const uint8_t *payload;
+        uint32_t len;
+        uint32_t n = 0;
+        while (n < max_count && reader.next(seq, msg, payload, len))
+        {
+            Napi::Object o = Napi::Object::New(env);
+            o.Set("seq", (double)seq);
+            o.Set("id", (double)msg.id);
+            o.Set("type", (int)msg.channel_type);
+            o.Set("offset", (double)msg.file_offset);
+            o.Set("len", (int)msg.data_len);
+            o.Set("ts", (double)msg.ts);
+            if (payload)
+                o.Set("payload", Napi::Buffer<uint8_t>::Copy(env, payload, len));
+            else
+                o.Set("payload", env.Null());
+            o.Set("gap", reader.gap());
+            records.Set(n++, o);
+        }
+        next = reader.position();
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("records", records);
+    result.Set("next", (double)next);
+    result.Set("first", (double)reader.firstSeq());
+    return result;
+}
+
+// 把读者游标移到seq：(readerId, seq) -> boolean，seq已不在环中时返回false（继续从日志读）
+Napi::Value seekRead(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber())
+    {
+        Napi::TypeError::New(env, "Params error: (number readerId, number seq)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::lock_guard<std::mutex> lock(g_shm_mutex);
+    if (!chan.isOpen())
+        return Napi::Boolean::New(env, false);
+    return Napi::Boolean::New(env, chan.seek((uint8_t)info[0].As<Napi::Number>().Uint32Value(),
+                                             (uint64_t)info[1].As<Napi::Number>().DoubleValue()));
+}
+
+// 命名共享内存段的解析参数：(name[, size])，size省略或为0时映射整个段
+static bool ParseRegionArgs(const Napi::CallbackInfo &info, std::string &name, uint32_t &size)
+{
+    if (info.Length() < 1 || !info[0].IsString() || (info.Length() > 1 && !info[1].IsNumber() && !info[1].IsUndefined()))
+    {
+        Napi::TypeError::New(info.Env(), "Params error: (string name, number size?)").ThrowAsJavaScriptException();
+        return false;
+    }
+    name = info[0].As<Napi::String>().Utf8Value();
+    size = info.Length() > 1 && info[1].IsNumber() ? info[1].As<Napi::Number>().Uint32Value() : 0;
+    return true;
+}
+
+static void FinalizeRegion(napi_env, void *, void *hint)
+{
+    ShmHandle *h = static_cast<ShmHandle *>(hint);
+    ShmCrossPlatform::close(h);
+    delete h;
+}
+
+// 映射命名共享内存段：(name[, size]) -> 外部ArrayBuffer，读写直接作用于共享内存
+// 映射在ArrayBuffer被回收时由finalizer关闭；段不存在或size超过段的实际大小时返回null
+// 运行时禁止外部缓冲（Electron内存沙箱）时同样返回null，改用readRegion复制
+Napi::Value mapRegion(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    std::string name;
+    uint32_t size = 0;
+    if (!ParseRegionArgs(info, name, size))
+        return env.Null();
+
+    ShmHandle *h = new ShmHandle{};
+    if (!ShmCrossPlatform::open(h, name.c_str(), size))
+    {
+        delete h;
+        return env.Null();
+    }
+    napi_value buffer;
+    napi_status status = napi_create_external_arraybuffer(env, h->ptr, h->size, FinalizeRegion, h, &buffer);
+    if (status != napi_ok)
+    {
+        ShmCrossPlatform::close(h);
+        delete h;
+        return env.Null();
+    }
+    return Napi::ArrayBuffer(env, buffer);
+}
+
+// 复制命名共享内存段的一部分（禁止外部缓冲时的回退）：(name, offset, length) -> Buffer
+Napi::Value readRegion(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsNumber() || !info[2].IsNumber())
+    {
+        Napi::TypeError::New(env, "Params error: (string name, number offset, number length)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    uint32_t offset = info[1].As<Napi::Number>().Uint32Value();
+    uint32_t len = info[2].As<Napi::Number>().Uint32Value();
+
+    ShmHandle h{};
+    if (!ShmCrossPlatform::open(&h, name.c_str(), 0))
+        return env.Null();
+    if ((uint64_t)offset + len > h.size)
+    {
+        ShmCrossPlatform::close(&h);
+        Napi::RangeError::New(env, "Region out of range").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    Napi::Buffer<uint8_t> out = Napi::Buffer<uint8_t>::Copy(env, static_cast<uint8_t *>(h.ptr) + offset, len);
+    ShmCrossPlatform::close(&h);
+    return out;
+}
+
+// 共享内存读等待线程：所有waitRead请求由同一个原生线程在通道的futex上等待，
+// 结果经ThreadSafeFunction回到JS，不占用libuv线程池
+class ShmReadWaiter
+{
+public:
+    static ShmReadWaiter &Instance()
+    {
+        static ShmReadWaiter waiter;
+        return waiter;
+    }
+
+    void Submit(uint8_t reader, int timeout_ms, Napi::ThreadSafeFunction tsfn)
+    {
+        Request req{reader, timeout_ms >= 0, std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms), tsfn};
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back(req);
+            if (!worker.joinable())
+            {
+                worker = std::thread([this]() { Run(); });
+            }
+        }
+        cv.notify_one();
+        std::lock_guard<std::mutex> shm_lock(g_shm_mutex);
+        chan.wake(); // 打断正在进行的futex等待，按新的请求集合重新计算
+    }
+
+    ~ShmReadWaiter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_one();
+        if (worker.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> shm_lock(g_shm_mutex);
+                if (chan.isOpen())
+                    chan.wake();
+            }
+            worker.join();
+        }
+        for (Request &req : pending)
+            req.tsfn.Release();
+    }
+
+private:
+    struct Request
+    {
+        uint8_t reader;
+        bool timed;
+        std::chrono::steady_clock::time_point deadline;
+        Napi::ThreadSafeFunction tsfn;
+    };
+
+    static void Complete(Request &req, bool ready)
+    {
+        req.tsfn.BlockingCall([ready](Napi::Env env, Napi::Function cb)
+                              { cb.Call({env.Null(), Napi::Boolean::New(env, ready)}); });
+        req.tsfn.Release();
+    }
+
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping)
+        {
+            if (pending.empty())
+            {
+                cv.wait(lock);
+                continue;
+            }
+
+            // 完成已有数据或已超时的请求，其余的取最小读游标与最早截止时间作为本轮等待条件
+            auto now = std::chrono::steady_clock::now();
+            uint64_t min_seq = UINT64_MAX;
+            int wait_ms = -1;
+            ShmChannel view; // 通道映射不会被解除，副本可在锁外等待
+            {
+                std::lock_guard<std::mutex> shm_lock(g_shm_mutex);
+                view = chan;
+                for (size_t k = 0; k < pending.size();)
+                {
+                    Request &req = pending[k];
+                    if (chan.available(req.reader) > 0 || (req.timed && now >= req.deadline))
+                    {
+                        Complete(req, chan.available(req.reader) > 0);
+                        pending[k] = pending.back();
+                        pending.pop_back();
+                        continue;
+                    }
+                    min_seq = std::min(min_seq, chan.readSeq(req.reader));
+                    if (req.timed)
+                    {
+                        int ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(req.deadline - now).count() + 1;
+                        wait_ms = wait_ms < 0 ? ms : std::min(wait_ms, ms);
+                    }
+                    ++k;
+                }
+            }
+            if (pending.empty())
+                continue;
+
+            lock.unlock();
+            view.waitFor(min_seq, wait_ms);
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<Request> pending;
+    std::thread worker;
+    bool stopping = false;
+};
+
+// 阻塞等待读者有新消息：(readerId, timeoutMs, callback)，callback收到(err, ready)
+// timeoutMs<0表示不超时；ready为false表示超时
+Napi::Value waitRead(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 3 || !info[0].IsNumber() || !info[1].IsNumber() || !info[2].IsFunction())
+    {
+        Napi::TypeError::New(env, "Params error: (number readerId, number timeoutMs, function callback)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    uint32_t rid = info[0].As<Napi::Number>().Uint32Value();
+    int timeout_ms = info[1].As<Napi::Number>().Int32Value();
+    {
+        std::lock_guard<std::mutex> lock(g_shm_mutex);
+        if (!chan.isOpen() || rid >= MAX_READERS)
+        {
+            Napi::Error::New(env, "Channel not opened or invalid readerId").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (!chan.isAttached((uint8_t)rid))
+            chan.attach((uint8_t)rid);
+        chan.releaseLastRead((uint8_t)rid);
+    }
+    Napi::ThreadSafeFunction tsfn = Napi::ThreadSafeFunction::New(env, info[2].As<Napi::Function>(), "ShmWaitRead", 0, 1);
+    ShmReadWaiter::Instance().Submit((uint8_t)rid, timeout_ms, tsfn);
+    return env.Undefined();
+}
+
+////////////////////////////////// 共享内存RPC /////////////////////////////////////
+// 服务端运行在本模块的后台线程中，高频查询（光标位置、窗口命中测试）由其它进程经共享内存调用，不经过Electron IPC
+struct RpcHost
+{
+    ShmRpcServer server;
+    std::thread worker;
+    std::atomic<bool> stop{false};
+
+    // 窗口命中测试使用的窗口快照：枚举窗口耗时为毫秒级，快照最多复用kWindowsTtl
+    static constexpr std::chrono::milliseconds kWindowsTtl{200};
+    std::vector<WindowInfo> windows;
+    std::chrono::steady_clock::time_point windows_at;
+
+    uint16_t Handle(uint16_t method, const uint8_t *req, uint32_t len, uint8_t *resp, uint32_t &resp_len)
+    {
+        switch (method)
+        {
+        case SHM_RPC_PING:
+            memcpy(resp, req, len);
+            resp_len = len;
+            return SHM_RPC_OK;
+        case SHM_RPC_CURSOR:
+        {
+            CursorManager &mgr = CursorManager::GetInstance();
+            mgr.Init();
+            CursorPosition pos = mgr.GetCursorPosition();
+            if (!pos.error.empty())
+                return SHM_RPC_E_FAILED;
+            int32_t xy[2] = {pos.x, pos.y};
+            memcpy(resp, xy, sizeof(xy));
+            resp_len = sizeof(xy);
+            return SHM_RPC_OK;
+        }
+        case SHM_RPC_WINDOW_AT:
+        {
+            if (len < 8)
+                return SHM_RPC_E_ARGS;
+            int32_t xy[2];
+            memcpy(xy, req, sizeof(xy));
+            auto now = std::chrono::steady_clock::now();
+            if (windows.empty() || now - windows_at > kWindowsTtl)
+            {
+                windows = CreateWindowEnumerator()->GetVisibleWindows();
+                windows_at = now;
+            }
+            const WindowInfo *hit = nullptr;
+            for (const WindowInfo &w : windows)
+            {
+                if (xy[0] >= w.x && xy[1] >= w.y && xy[0] < w.x + (int64_t)w.width && xy[1] < w.y + (int64_t)w.height &&
+                    (!hit || w.zOrder < hit->zOrder))
+                    hit = &w;
+            }
+            if (!hit)
+                return SHM_RPC_OK;
+            // handle i64 | pid i32 | x i32 | y i32 | width u32 | height u32 | title utf8
+            uint8_t *p = resp;
+            memcpy(p, &hit->handle, 8);
+            memcpy(p + 8, &hit->pid, 4);
+            memcpy(p + 12, &hit->x, 4);
+            memcpy(p + 16, &hit->y, 4);
+            memcpy(p + 20, &hit->width, 4);
+            memcpy(p + 24, &hit->height, 4);
+            uint32_t title = (uint32_t)std::min<size_t>(hit->title.size(), SHM_RPC_INLINE - 28);
+            memcpy(p + 28, hit->title.data(), title);
+            resp_len = 28 + title;
+            return SHM_RPC_OK;
+        }
+        default:
+            return SHM_RPC_E_METHOD;
+        }
+    }
+};
+static std::mutex g_rpc_mutex;
+static std::unique_ptr<RpcHost> g_rpc_host;
+
+// 启动RPC服务端：(name) -> boolean，name为共享内存段名
+Napi::Value rpcServe(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString())
+    {
+        Napi::TypeError::New(env, "Params error: (string name)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    std::lock_guard<std::mutex> lock(g_rpc_mutex);
+    if (g_rpc_host)
+        return Napi::Boolean::New(env, false);
+    auto host = std::make_unique<RpcHost>();
+    if (!host->server.create(name.c_str()))
+        return Napi::Boolean::New(env, false);
+    RpcHost *h = host.get();
+    h->worker = std::thread([h]
+                            { h->server.run([h](uint16_t method, const uint8_t *req, uint32_t len, uint8_t *resp, uint32_t &resp_len)
+                                            {
+                                                try
+                                                {
+                                                    return h->Handle(method, req, len, resp, resp_len);
+                                                }
+                                                catch (const std::exception &)
+                                                {
+                                                    resp_len = 0;
+                                                    return (uint16_t)SHM_RPC_E_FAILED;
+                                                } },
+                                            h->stop); });
+    g_rpc_host = std::move(host);
+    return Napi::Boolean::New(env, true);
+}
+
+// 停止RPC服务端，等待中的客户端调用返回SHM_RPC_E_DISCONNECTED
+Napi::Value rpcStop(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    std::unique_ptr<RpcHost> host;
+    {
+        std::lock_guard<std::mutex> lock(g_rpc_mutex);
+        host = std::move(g_rpc_host);
+    }
+    if (!host)
+        return Napi::Boolean::New(env, false);
+    host->stop = true;
+    host->server.wake();
+    host->worker.join();
+    host->server.close();
+    return Napi::Boolean::New(env, true);
+}
+
+// 客户端连接：(name) -> boolean；每个JS线程一个连接，服务端最多SHM_RPC_CLIENTS个
+Napi::Value rpcConnect(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString())
+    {
+        Napi::TypeError::New(env, "Params error: (string name)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Napi::Boolean::New(env, GetShmState(env).rpc.connect(info[0].As<Napi::String>().Utf8Value().c_str()));
+}
+
+Napi::Value rpcDisconnect(const Napi::CallbackInfo &info)
+{
+    GetShmState(info.Env()).rpc.disconnect();
+    return info.Env().Undefined();
+}
+
+// RPC响应缓冲：rpcCall把响应负载写到这里（每个环境一个，可长期持有其DataView）
+Napi::Value rpcBuffer(const Napi::CallbackInfo &info)
+{
+    return GetShmState(info.Env()).rpc_buffer.Value();
+}
+
+// 同步调用：(method, request?, timeoutMs?) -> 响应长度（负载在rpcBuffer()开头），失败时返回-状态码
+// request为TypedArray/Buffer（最多SHM_RPC_INLINE字节），调用期间阻塞当前线程，通常只有几微秒
+// 服务端卡住时会阻塞到超时（默认50ms），不要在Electron主进程的主线程上以大超时调用
+Napi::Value rpcCall(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsNumber())
+    {
+        Napi::TypeError::New(env, "Params error: (number method, TypedArray request?, number timeoutMs?)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    ShmEnvState &state = GetShmState(env);
+    uint16_t method = (uint16_t)info[0].As<Napi::Number>().Uint32Value();
+    const uint8_t *req = nullptr;
+    uint32_t len = 0;
+    if (info.Length() > 1 && info[1].IsTypedArray())
+    {
+        Napi::TypedArray ta = info[1].As<Napi::TypedArray>();
+        req = static_cast<const uint8_t *>(ta.ArrayBuffer().Data()) + ta.ByteOffset();
+        len = (uint32_t)ta.ByteLength();
+    }
+    int timeout_ms = info.Length() > 2 && info[2].IsNumber() ? info[2].As<Napi::Number>().Int32Value() : 50;
+    uint8_t *resp = static_cast<uint8_t *>(state.rpc_buffer.Value().Data());
+    uint32_t resp_len = 0;
+    uint16_t status = state.rpc.call(method, req, len, resp, resp_len, timeout_ms);
+    return Napi::Number::New(env, status == SHM_RPC_OK ? (double)resp_len : -(double)status);
+}
+
 ////////////////////////////////// 模块初始化 /////////////////////////////////////
 Napi::Object Init(Napi::Env env, Napi::Object exports)
 {
     exports.Set(Napi::String::New(env, "getAllWindows"), Napi::Function::New(env, GetAllWindows));
     exports.Set(Napi::String::New(env, "scanFolder"), Napi::Function::New(env, ScanFolder));
     exports.Set(Napi::String::New(env, "compareFolders"), Napi::Function::New(env, CompareFolders));
+    exports.Set(Napi::String::New(env, "compareFoldersSorted"), Napi::Function::New(env, CompareFoldersSorted));
+    exports.Set(Napi::String::New(env, "diffFolderTree"), Napi::Function::New(env, DiffFolderTree));
+    exports.Set(Napi::String::New(env, "createSnapshot"), Napi::Function::New(env, CreateSnapshot));
+    exports.Set(Napi::String::New(env, "findDuplicates"), Napi::Function::New(env, FindDuplicates));
     exports.Set(Napi::String::New(env, "compareFiles"), Napi::Function::New(env, CompareFiles));
+    exports.Set(Napi::String::New(env, "diffFileRegions"), Napi::Function::New(env, DiffFileRegions));
+    exports.Set(Napi::String::New(env, "watchCompare"), Napi::Function::New(env, WatchCompare));
+    exports.Set(Napi::String::New(env, "unwatchCompare"), Napi::Function::New(env, UnwatchCompare));
+    exports.Set(Napi::String::New(env, "cancelScans"), Napi::Function::New(env, CancelScans));
     exports.Set(Napi::String::New(env, "getCursorPosition"), Napi::Function::New(env, GetCursorPosition));
     exports.Set(Napi::String::New(env, "trackCursorAsync"), Napi::Function::New(env, TrackCursorAsync));
     exports.Set(Napi::String::New(env, "freezeScreen"), Napi::Function::New(env, FreezeScreen));
@@ -546,6 +2092,26 @@ Napi::Object Init(Napi::Env env, Napi::Object exports)
     exports.Set(Napi::String::New(env, "init"), Napi::Function::New(env, init));
     exports.Set(Napi::String::New(env, "openChannel"), Napi::Function::New(env, openChannel));
     exports.Set(Napi::String::New(env, "read"), Napi::Function::New(env, readBinary));
+    exports.Set(Napi::String::New(env, "waitRead"), Napi::Function::New(env, waitRead));
+    exports.Set(Napi::String::New(env, "readBatch"), Napi::Function::New(env, readBatch));
+    exports.Set(Napi::String::New(env, "batchBuffer"), Napi::Function::New(env, batchBuffer));
+    exports.Set(Napi::String::New(env, "payloadBuffer"), Napi::Function::New(env, payloadBuffer));
+    exports.Set(Napi::String::New(env, "copyPayload"), Napi::Function::New(env, copyPayload));
+    exports.Set(Napi::String::New(env, "holdPayloads"), Napi::Function::New(env, holdPayloads));
+    exports.Set(Napi::String::New(env, "releasePayload"), Napi::Function::New(env, releasePayload));
+    exports.Set(Napi::String::New(env, "channelStats"), Napi::Function::New(env, channelStats));
+    exports.Set(Napi::String::New(env, "takeLagged"), Napi::Function::New(env, takeLagged));
+    exports.Set(Napi::String::New(env, "readSpill"), Napi::Function::New(env, readSpill));
+    exports.Set(Napi::String::New(env, "readJournal"), Napi::Function::New(env, readJournal));
+    exports.Set(Napi::String::New(env, "rpcServe"), Napi::Function::New(env, rpcServe));
+    exports.Set(Napi::String::New(env, "rpcStop"), Napi::Function::New(env, rpcStop));
+    exports.Set(Napi::String::New(env, "rpcConnect"), Napi::Function::New(env, rpcConnect));
+    exports.Set(Napi::String::New(env, "rpcDisconnect"), Napi::Function::New(env, rpcDisconnect));
+    exports.Set(Napi::String::New(env, "rpcBuffer"), Napi::Function::New(env, rpcBuffer));
+    exports.Set(Napi::String::New(env, "rpcCall"), Napi::Function::New(env, rpcCall));
+    exports.Set(Napi::String::New(env, "seekRead"), Napi::Function::New(env, seekRead));
+    exports.Set(Napi::String::New(env, "mapRegion"), Napi::Function::New(env, mapRegion));
+    exports.Set(Napi::String::New(env, "readRegion"), Napi::Function::New(env, readRegion));
     return exports;
 }
 
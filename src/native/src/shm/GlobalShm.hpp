@@ -16,7 +16,7 @@ public:
     if (!ShmCrossPlatform::create(&_h, GLOBAL_SHM_NAME, GLOBAL_SHM_SIZE))
       return false;
     _ctrl = (GlobalShmCtrl *)_h.ptr;
-    _ctrl->version = 1;
+    _ctrl->version = SHM_LAYOUT_VERSION;
     _ctrl->channel_count = 0;
     return true;
   }
@@ -42,6 +42,17 @@ public:
     return true;
   }
 
+  // 按通道共享内存名查找登记的data_path，未登记返回nullptr
+  const char *dataPath(const char *shmName) const
+  {
+    for (uint32_t i = 0; i < _ctrl->channel_count && i < MAX_CHANNELS; i++)
+    {
+      if (strncmp(_ctrl->channels[i].shm_name, shmName, SHM_NAME_MAX) == 0)
+        return _ctrl->channels[i].data_path;
+    }
+    return nullptr;
+  }
+
   GlobalShmCtrl *ctrl() { return _ctrl; }
   void close() { ShmCrossPlatform::close(&_h); }
 };
\ No newline at end of file
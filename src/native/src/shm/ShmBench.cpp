@@ -0,0 +1,695 @@
+// 共享内存通道基准测试：吞吐（同进程1写1读、1写N读，跨进程1写N读）、跨进程往返延迟、环满时各溢出策略的表现
+// 结果以JSON写到stdout（或--out指定的文件），进度写到stderr，便于脚本比较不同版本的环实现
+#include "ShmChannel.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <sys/wait.h>
+#endif
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+struct BenchOptions
+{
+  uint64_t messages = 200000;  // 每个吞吐用例写入的消息数（大消息按总量1GB封顶）
+  uint32_t iterations = 20000; // 每个延迟用例的往返次数，另加1/10预热
+  int cpus[2] = {0, -1};       // 延迟用例两端绑定的CPU，-1表示自动选择
+  ShmMapOptions map;
+  std::string only; // throughput/latency/full，空表示全部运行
+  std::string out;
+};
+
+// 消息大小为负载字节数，0表示只有消息槽本身
+static const uint32_t kSizes[] = {0, 64, 1024, 16384};
+static const uint32_t kCapacities[] = {256, 4096, 65536};
+static const uint32_t kFanout[] = {2, 4, 8};
+static const uint32_t kProcessReaders[] = {1, 2, 4};
+static const uint32_t kProcessSizes[] = {64, 1024};
+static const uint32_t kLatencySizes[] = {0, 64, 1024};
+static const uint32_t kStopType = 0xFFFFFFFF; // 延迟用例中通知回显进程退出
+static const int kBlockTimeoutMs = 1000;     // 吞吐用例的阻塞上限：读者异常退出时写端不会永久阻塞
+static const uint64_t kIdleNs = 2000000000ULL;
+
+static uint64_t nowNs()
+{
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static unsigned cpuCount()
+{
+  unsigned n = std::thread::hardware_concurrency();
+  return n ? n : 1;
+}
+
+// 绑定调用线程（fork出的子进程即整个进程）到cpu，不支持的平台返回false
+static bool pinCpu(int cpu)
+{
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  (void)cpu;
+  return false;
+#endif
+}
+
+static std::string segName(const char *tag)
+{
+  static int serial = 0;
+#ifdef _WIN32
+  int pid = _getpid();
+#else
+  int pid = getpid();
+#endif
+  return "ShmBench" + std::to_string(pid) + "_" + tag + std::to_string(serial++);
+}
+
+// 负载区按容量×消息大小分配，最多64MB（读者逐条释放，远小于此也不会成为瓶颈）
+static uint32_t arenaBytes(uint32_t cap, uint32_t size)
+{
+  if (size == 0)
+    return 0;
+  uint64_t bytes = (uint64_t)cap * ((size + 7) & ~7u);
+  bytes = std::min<uint64_t>(bytes, 64u << 20);
+  return (uint32_t)std::max<uint64_t>(bytes, (uint64_t)size * 4);
+}
+
+static uint64_t messageCount(const BenchOptions &o, uint32_t size)
+{
+  return size ? std::min<uint64_t>(o.messages, (1ULL << 30) / size) : o.messages;
+}
+
+// 已排序样本的分位数
+static double percentile(const std::vector<uint64_t> &sorted, double q)
+{
+  if (sorted.empty())
+    return 0;
+  size_t i = std::min(sorted.size() - 1, (size_t)(q * sorted.size()));
+  return (double)sorted[i];
+}
+
+// 极简JSON：结果只有扁平对象与对象数组
+class JsonRow
+{
+public:
+  JsonRow &str(const char *k, const std::string &v)
+  {
+    key(k);
+    _body += "\"" + v + "\"";
+    return *this;
+  }
+  JsonRow &num(const char *k, uint64_t v)
+  {
+    key(k);
+    _body += std::to_string(v);
+    return *this;
+  }
+  JsonRow &real(const char *k, double v)
+  {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.6g", v);
+    key(k);
+    _body += buf;
+    return *this;
+  }
+  JsonRow &flag(const char *k, bool v)
+  {
+    key(k);
+    _body += v ? "true" : "false";
+    return *this;
+  }
+  std::string text() const { return "{" + _body + "}"; }
+
+private:
+  void key(const char *k)
+  {
+    if (!_body.empty())
+      _body += ", ";
+    _body += "\"" + std::string(k) + "\": ";
+  }
+  std::string _body;
+};
+
+struct ReaderResult
+{
+  uint64_t received = 0;
+  uint64_t errors = 0; // 序号不连续或负载内容不符
+  uint64_t end_ns = 0;
+};
+
+// 读者：读取count条消息（或空闲超过kIdleNs），校验序号与负载首8字节（写端写入的是消息id）
+static void readAll(ShmChannel &ch, uint8_t rid, uint64_t count, ReaderResult &res)
+{
+  ShmMessage msg;
+  uint64_t expect = 0;
+  uint64_t idle_since = 0;
+  while (expect < count)
+  {
+    if (!ch.pop(rid, msg))
+    {
+      uint64_t now = nowNs();
+      if (!idle_since)
+        idle_since = now;
+      else if (now - idle_since > kIdleNs)
+        break;
+      ch.wait(rid, 100);
+      continue;
+    }
+    idle_since = 0;
+    res.received++;
+    if (msg.id != expect)
+      res.errors++;
+    if (msg.payload_len >= 8)
+    {
+      uint64_t v;
+      memcpy(&v, ch.payload(msg), sizeof(v));
+      if (v != msg.id)
+        res.errors++;
+    }
+    expect = msg.id + 1;
+  }
+  res.end_ns = nowNs();
+}
+
+// 写端：写入count条size字节的消息，返回被丢弃的条数
+static uint64_t writeAll(ShmChannel &ch, uint64_t count, uint32_t size)
+{
+  std::vector<uint8_t> buf(size ? size : 1, 0x5A);
+  ShmMessage msg{};
+  msg.channel_type = CHANNEL_PROXY;
+  uint64_t dropped = 0;
+  for (uint64_t i = 0; i < count; i++)
+  {
+    msg.id = i;
+    msg.data_len = size;
+    if (size >= 8)
+      memcpy(buf.data(), &i, sizeof(i));
+    if (!(size ? ch.pushPayload(msg, buf.data(), size) : ch.push(msg)))
+      dropped++;
+  }
+  return dropped;
+}
+
+static bool createChannel(ShmChannel &ch, const std::string &name, const BenchOptions &o, uint32_t cap, uint32_t size)
+{
+  if (!ch.create(name.c_str(), cap, arenaBytes(cap, size), o.map))
+  {
+    fprintf(stderr, "create %s (cap=%u, size=%u) failed\n", name.c_str(), cap, size);
+    return false;
+  }
+  return true;
+}
+
+// 吞吐结果的公共字段
+static JsonRow throughputRow(const char *mode, uint32_t readers, uint32_t size, uint64_t count,
+                             uint64_t ns, const ShmChannel &ch, uint64_t dropped, const ReaderResult *res)
+{
+  uint64_t received = 0, errors = 0;
+  for (uint32_t i = 0; i < readers; i++)
+  {
+    received += res[i].received;
+    errors += res[i].errors;
+  }
+  double sec = ns / 1e9;
+  const ShmChannelStats &st = ch.header()->stats;
+  JsonRow row;
+  row.str("mode", mode)
+      .num("writers", 1)
+      .num("readers", readers)
+      .num("capacity", ch.capacity())
+      .num("msg_bytes", size)
+      .num("messages", count)
+      .real("seconds", sec)
+      .real("msgs_per_sec", count / sec)
+      .real("mb_per_sec", (double)count * (size + sizeof(ShmMessage)) / sec / (1 << 20))
+      .num("received", received)
+      .num("dropped", dropped)
+      .num("errors", errors)
+      .num("writer_waits", st.waits.load(std::memory_order_relaxed))
+      .real("writer_wait_ms", st.wait_ns.load(std::memory_order_relaxed) / 1e6)
+      .num("map_flags", ch.mapFlags());
+  return row;
+}
+
+// 同进程：1个写线程、readers个读线程，各读者持有自己的映射
+static bool runThreads(const BenchOptions &o, uint32_t readers, uint32_t cap, uint32_t size, std::vector<std::string> &rows)
+{
+  std::string name = segName("thr");
+  ShmChannel ch;
+  if (!createChannel(ch, name, o, cap, size))
+    return false;
+  ch.setOverflowPolicy(SHM_OVERFLOW_BLOCK, kBlockTimeoutMs);
+  uint64_t count = messageCount(o, size);
+
+  std::vector<ShmChannel> views(readers);
+  std::vector<ReaderResult> res(readers);
+  for (uint32_t i = 0; i < readers; i++)
+  {
+    if (!views[i].open(name.c_str()) || !views[i].attach((uint8_t)i, false))
+    {
+      fprintf(stderr, "threads   1w/%ur: open reader %u failed\n", readers, i);
+      ch.close();
+      ShmChannel::remove(name.c_str());
+      return false;
+    }
+  }
+
+  std::vector<std::thread> threads;
+  uint64_t t0 = nowNs();
+  for (uint32_t i = 0; i < readers; i++)
+    threads.emplace_back([&, i] { readAll(views[i], (uint8_t)i, count, res[i]); });
+  uint64_t dropped = writeAll(ch, count, size);
+  for (auto &t : threads)
+    t.join();
+  uint64_t t1 = t0;
+  for (auto &r : res)
+    t1 = std::max(t1, r.end_ns);
+
+  JsonRow row = throughputRow("threads", readers, size, count, t1 - t0, ch, dropped, res.data());
+  rows.push_back(row.text());
+  fprintf(stderr, "threads   1w/%ur cap=%-6u size=%-6u %12.0f msg/s\n", readers, ch.capacity(), size,
+          count / ((t1 - t0) / 1e9));
+  for (auto &v : views)
+    v.close();
+  ch.close();
+  ShmChannel::remove(name.c_str());
+  return true;
+}
+
+#ifndef _WIN32
+static bool readFull(int fd, void *buf, size_t len)
+{
+  uint8_t *p = (uint8_t *)buf;
+  while (len > 0)
+  {
+    ssize_t n = read(fd, p, len);
+    if (n <= 0)
+      return false;
+    p += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+// 跨进程：写端在本进程（绑定到CPU 0），readers个子进程各自打开通道读取（依次绑定到后续CPU）
+static bool runProcesses(const BenchOptions &o, uint32_t readers, uint32_t cap, uint32_t size, std::vector<std::string> &rows)
+{
+  std::string name = segName("proc");
+  ShmChannel ch;
+  if (!createChannel(ch, name, o, cap, size))
+    return false;
+  ch.setOverflowPolicy(SHM_OVERFLOW_BLOCK, kBlockTimeoutMs);
+  uint64_t count = messageCount(o, size);
+  unsigned ncpu = cpuCount();
+
+  int ready[2], done[2];
+  if (pipe(ready) != 0 || pipe(done) != 0)
+    return false;
+  std::vector<pid_t> pids;
+  for (uint32_t i = 0; i < readers; i++)
+  {
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+      ::close(ready[0]);
+      ::close(done[0]);
+      pinCpu((int)((i + 1) % ncpu));
+      ShmChannel view;
+      ReaderResult res;
+      char ok = view.open(name.c_str()) && view.attach((uint8_t)i, false);
+      if (write(ready[1], &ok, 1) != 1)
+        _exit(1);
+      if (ok)
+        readAll(view, (uint8_t)i, count, res);
+      _exit(write(done[1], &res, sizeof(res)) == sizeof(res) ? 0 : 1);
+    }
+    if (pid > 0)
+      pids.push_back(pid);
+  }
+  ::close(ready[1]);
+  ::close(done[1]);
+
+  bool ok = pids.size() == readers;
+  for (uint32_t i = 0; ok && i < readers; i++)
+  {
+    char c = 0;
+    ok = readFull(ready[0], &c, 1) && c;
+  }
+  std::vector<ReaderResult> res(readers);
+  uint64_t dropped = 0, t0 = 0, t1 = 0;
+  if (ok)
+  {
+    t0 = nowNs();
+    std::thread writer([&] {
+      pinCpu(0);
+      dropped = writeAll(ch, count, size);
+    });
+    writer.join();
+    for (uint32_t i = 0; ok && i < readers; i++)
+      ok = readFull(done[0], &res[i], sizeof(ReaderResult));
+    t1 = nowNs();
+  }
+  ch.wake();
+  for (pid_t pid : pids)
+    waitpid(pid, nullptr, 0);
+  ::close(ready[0]);
+  ::close(done[0]);
+
+  if (ok)
+  {
+    JsonRow row = throughputRow("processes", readers, size, count, t1 - t0, ch, dropped, res.data());
+    rows.push_back(row.text());
+    fprintf(stderr, "processes 1w/%ur cap=%-6u size=%-6u %12.0f msg/s\n", readers, ch.capacity(), size,
+            count / ((t1 - t0) / 1e9));
+  }
+  else
+    fprintf(stderr, "processes 1w/%ur size=%u: reader process failed\n", readers, size);
+  ch.close();
+  ShmChannel::remove(name.c_str());
+  return ok;
+}
+
+// 往返延迟：本进程在ping通道写入，子进程读出后原样写回pong通道，两端通过通道自身的等待路径收消息
+static bool runLatency(const BenchOptions &o, uint32_t size, std::vector<std::string> &rows)
+{
+  const uint32_t cap = 1024;
+  std::string ping_name = segName("ping"), pong_name = segName("pong");
+  ShmChannel ping, pong;
+  if (!createChannel(ping, ping_name, o, cap, size) || !createChannel(pong, pong_name, o, cap, size))
+    return false;
+  ping.setOverflowPolicy(SHM_OVERFLOW_BLOCK, kBlockTimeoutMs);
+  pong.setOverflowPolicy(SHM_OVERFLOW_BLOCK, kBlockTimeoutMs);
+  pong.attach(0, false);
+
+  int ready[2];
+  if (pipe(ready) != 0)
+    return false;
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    ::close(ready[0]);
+    char state = pinCpu(o.cpus[1]) ? 2 : 1;
+    ShmChannel in, out;
+    if (!in.open(ping_name.c_str()) || !out.open(pong_name.c_str()) || !in.attach(0, false))
+      state = 0;
+    if (write(ready[1], &state, 1) != 1 || !state)
+      _exit(1);
+    ShmMessage msg;
+    uint64_t idle_since = 0;
+    for (;;)
+    {
+      if (!in.pop(0, msg))
+      {
+        uint64_t now = nowNs();
+        if (!idle_since)
+          idle_since = now;
+        else if (now - idle_since > kIdleNs)
+          break;
+        in.wait(0, 100);
+        continue;
+      }
+      idle_since = 0;
+      if (msg.channel_type == kStopType)
+        break;
+      out.pushPayload(msg, in.payload(msg), msg.payload_len);
+    }
+    _exit(0);
+  }
+  ::close(ready[1]);
+  char state = 0;
+  bool ok = pid > 0 && readFull(ready[0], &state, 1) && state;
+  ::close(ready[0]);
+
+  uint32_t warmup = o.iterations / 10;
+  std::vector<uint64_t> samples;
+  samples.reserve(o.iterations);
+  bool pinned = false;
+  if (ok)
+  {
+    std::thread client([&] {
+      pinned = pinCpu(o.cpus[0]);
+      std::vector<uint8_t> buf(size ? size : 1, 0x5A);
+      ShmMessage msg{}, reply;
+      msg.channel_type = CHANNEL_PROXY;
+      for (uint64_t i = 0; ok && i < warmup + o.iterations; i++)
+      {
+        msg.id = i;
+        uint64_t t0 = nowNs();
+        if (!(size ? ping.pushPayload(msg, buf.data(), size) : ping.push(msg)))
+        {
+          ok = false;
+          break;
+        }
+        for (;;)
+        {
+          if (pong.pop(0, reply))
+          {
+            if (reply.id == i)
+              break;
+            continue;
+          }
+          if (nowNs() - t0 > kIdleNs)
+          {
+            ok = false;
+            break;
+          }
+          pong.wait(0, 100);
+        }
+        if (ok && i >= warmup)
+          samples.push_back(nowNs() - t0);
+      }
+    });
+    client.join();
+    ShmMessage stop{};
+    stop.channel_type = kStopType;
+    ping.push(stop);
+  }
+  if (pid > 0)
+    waitpid(pid, nullptr, 0);
+
+  if (ok)
+  {
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (uint64_t s : samples)
+      sum += s;
+    JsonRow row;
+    row.num("msg_bytes", size)
+        .num("capacity", cap)
+        .num("iterations", samples.size())
+        .num("cpu_client", o.cpus[0])
+        .num("cpu_echo", o.cpus[1])
+        .flag("pinned", pinned && state == 2)
+        .real("mean_us", sum / samples.size() / 1e3)
+        .real("p50_us", percentile(samples, 0.5) / 1e3)
+        .real("p99_us", percentile(samples, 0.99) / 1e3)
+        .real("p999_us", percentile(samples, 0.999) / 1e3)
+        .real("max_us", samples.back() / 1e3)
+        .num("map_flags", ping.mapFlags());
+    rows.push_back(row.text());
+    fprintf(stderr, "latency   size=%-6u p50=%.1fus p99=%.1fus p99.9=%.1fus\n", size, percentile(samples, 0.5) / 1e3,
+            percentile(samples, 0.99) / 1e3, percentile(samples, 0.999) / 1e3);
+  }
+  else
+    fprintf(stderr, "latency   size=%u: echo process failed\n", size);
+  ping.close();
+  pong.close();
+  ShmChannel::remove(ping_name.c_str());
+  ShmChannel::remove(pong_name.c_str());
+  return ok;
+}
+#endif
+
+// 环满：读者接入后不再读取，写入容量+256条消息，记录每次写入的耗时与各策略的计数
+static bool runFull(const BenchOptions &o, uint32_t policy, const char *label, std::vector<std::string> &rows)
+{
+  const uint32_t cap = 1024, size = 64, extra = 256;
+  std::string name = segName("full");
+  ShmChannel ch, reader;
+  if (!createChannel(ch, name, o, cap, size) || !reader.open(name.c_str()) || !reader.attach(0, false))
+    return false;
+  std::string spill = (std::filesystem::temp_directory_path() / (name + ".spill")).string();
+  if (!ch.setOverflowPolicy(policy, 1, spill.c_str()))
+  {
+    fprintf(stderr, "full ring %s: setOverflowPolicy failed\n", label);
+    return false;
+  }
+
+  std::vector<uint8_t> buf(size, 0x5A);
+  std::vector<uint64_t> samples;
+  ShmMessage msg{};
+  uint64_t accepted = 0, total = ch.capacity() + extra;
+  for (uint64_t i = 0; i < total; i++)
+  {
+    msg.id = i;
+    uint64_t t0 = nowNs();
+    accepted += ch.pushPayload(msg, buf.data(), size);
+    samples.push_back(nowNs() - t0);
+  }
+  // 读一条：覆盖策略下读者从仍在环中的最旧消息继续，lost为被跳过的条数
+  ShmMessage first{};
+  bool got = reader.pop(0, first);
+  std::sort(samples.begin(), samples.end());
+
+  const ShmChannelStats &st = ch.header()->stats;
+  JsonRow row;
+  row.str("policy", label)
+      .num("capacity", ch.capacity())
+      .num("msg_bytes", size)
+      .num("pushes", total)
+      .num("accepted", accepted)
+      .num("drops", st.drops.load(std::memory_order_relaxed))
+      .num("overwrites", st.overwrites.load(std::memory_order_relaxed))
+      .num("spills", st.spills.load(std::memory_order_relaxed))
+      .num("waits", st.waits.load(std::memory_order_relaxed))
+      .real("wait_ms", st.wait_ns.load(std::memory_order_relaxed) / 1e6)
+      .num("reader_lost", reader.lost(0))
+      .num("first_read_id", got ? first.id : 0)
+      .real("push_p50_us", percentile(samples, 0.5) / 1e3)
+      .real("push_p99_us", percentile(samples, 0.99) / 1e3)
+      .real("push_max_us", samples.back() / 1e3);
+  rows.push_back(row.text());
+  fprintf(stderr, "full ring %-11s accepted=%llu/%llu p99=%.1fus\n", label, (unsigned long long)accepted,
+          (unsigned long long)total, percentile(samples, 0.99) / 1e3);
+
+  reader.close();
+  ch.close();
+  ShmChannel::remove(name.c_str());
+  std::error_code ec;
+  std::filesystem::remove(spill, ec);
+  return true;
+}
+
+static void usage()
+{
+  fprintf(stderr,
+          "usage: shm_bench [--quick] [--messages N] [--iterations N] [--cpus A,B]\n"
+          "                 [--populate] [--huge-pages] [--lock] [--numa NODE]\n"
+          "                 [--only throughput|latency|full] [--out FILE]\n");
+}
+
+static bool parseArgs(int argc, char **argv, BenchOptions &o)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    std::string a = argv[i];
+    bool has_value = i + 1 < argc;
+    if (a == "--quick")
+    {
+      o.messages = 20000;
+      o.iterations = 2000;
+    }
+    else if (a == "--messages" && has_value)
+      o.messages = strtoull(argv[++i], nullptr, 10);
+    else if (a == "--iterations" && has_value)
+      o.iterations = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    else if (a == "--cpus" && has_value && sscanf(argv[++i], "%d,%d", &o.cpus[0], &o.cpus[1]) == 2)
+      ;
+    else if (a == "--populate")
+      o.map.populate = true;
+    else if (a == "--huge-pages")
+      o.map.huge_pages = true;
+    else if (a == "--lock")
+      o.map.lock = true;
+    else if (a == "--numa" && has_value)
+      o.map.numa_node = atoi(argv[++i]);
+    else if (a == "--only" && has_value)
+      o.only = argv[++i];
+    else if (a == "--out" && has_value)
+      o.out = argv[++i];
+    else
+      return false;
+  }
+  if (o.cpus[1] < 0)
+    o.cpus[1] = cpuCount() > 1 ? 1 : 0;
+  return o.messages > 0 && o.iterations > 0;
+}
+
+static std::string jsonArray(const std::vector<std::string> &rows)
+{
+  std::string s = "[";
+  for (size_t i = 0; i < rows.size(); i++)
+    s += (i ? ",\n    " : "\n    ") + rows[i];
+  return s + (rows.empty() ? "]" : "\n  ]");
+}
+
+int main(int argc, char **argv)
+{
+  BenchOptions o;
+  if (!parseArgs(argc, argv, o))
+  {
+    usage();
+    return 2;
+  }
+  auto enabled = [&](const char *section) { return o.only.empty() || o.only == section; };
+  bool ok = true;
+  std::vector<std::string> throughput, latency, full;
+
+  if (enabled("throughput"))
+  {
+    for (uint32_t cap : kCapacities)
+      for (uint32_t size : kSizes)
+        ok &= runThreads(o, 1, cap, size, throughput);
+    for (uint32_t readers : kFanout)
+      ok &= runThreads(o, readers, 4096, 64, throughput);
+#ifndef _WIN32
+    for (uint32_t size : kProcessSizes)
+      for (uint32_t readers : kProcessReaders)
+        ok &= runProcesses(o, readers, 4096, size, throughput);
+#endif
+  }
+#ifndef _WIN32
+  if (enabled("latency"))
+    for (uint32_t size : kLatencySizes)
+      ok &= runLatency(o, size, latency);
+#else
+  if (enabled("latency"))
+    fprintf(stderr, "latency: cross-process cases need fork(), skipped on Windows\n");
+#endif
+  if (enabled("full"))
+  {
+    ok &= runFull(o, SHM_OVERFLOW_DROP_NEWEST, "drop_newest", full);
+    ok &= runFull(o, SHM_OVERFLOW_OVERWRITE, "overwrite", full);
+    ok &= runFull(o, SHM_OVERFLOW_BLOCK, "block", full);
+    ok &= runFull(o, SHM_OVERFLOW_SPILL, "spill", full);
+  }
+
+  JsonRow meta;
+  meta.str("benchmark", "shm_channel")
+      .num("layout_version", SHM_LAYOUT_VERSION)
+      .num("cpus", cpuCount())
+      .num("slot_bytes", sizeof(ShmSlot))
+      .num("messages", o.messages)
+      .num("iterations", o.iterations)
+      .flag("populate", o.map.populate)
+      .flag("huge_pages", o.map.huge_pages)
+      .flag("lock", o.map.lock)
+      .real("numa_node", o.map.numa_node)
+      .flag("ok", ok);
+  std::string json = "{\n  \"meta\": " + meta.text() + ",\n  \"throughput\": " + jsonArray(throughput) +
+                     ",\n  \"latency\": " + jsonArray(latency) + ",\n  \"full_ring\": " + jsonArray(full) + "\n}\n";
+
+  FILE *f = o.out.empty() ? stdout : fopen(o.out.c_str(), "w");
+  if (!f)
+  {
+    fprintf(stderr, "cannot write %s\n", o.out.c_str());
+    return 1;
+  }
+  fputs(json.c_str(), f);
+  if (f != stdout)
+    fclose(f);
+  return ok ? 0 : 1;
+}
@@ -1,59 +1,759 @@
 #pragma once
 #include "ShmCrossPlatform.hpp"
+#include "ShmSpill.hpp"
+#include "ShmJournal.hpp"
 
+// 单写多读（SPMC）广播通道
+// 写端：push只由一个进程/线程调用；环满的判断以最慢的已接入读者为准
+// 读端：每个readerId一个独立游标，各自读到全部消息；读者被写端超过一圈时跳到最旧的可用消息
+// 环满时按头部的overflow_policy处理（见SHM_OVERFLOW_*），丢弃、覆盖与等待都计入头部统计
 class ShmChannel
 {
 private:
   ShmHandle _h{};
   ShmChannelHeader *_hdr{};
-  ShmMessage *_buf{};
+  ShmSlot *_slots{};
+  uint8_t *_payload{};
+  uint64_t _mask = 0;
+  uint64_t _min_read = 0;    // 写端缓存的最慢读者游标，看似已满及每kLagSample条时刷新
+  uint64_t _min_release = 0; // 写端缓存的最慢负载释放位置
+  ShmSpill _spill;           // 写端的溢出文件（SHM_OVERFLOW_SPILL）
+  ShmJournal *_journal{};    // 写端的日志（由调用方持有）
+  ShmWakeSignal _notify_sig; // 读者在notify上等待（Linux以外需要的唤醒对象）
+  ShmWakeSignal _space_sig;  // 写端在space上等待
+
+  static constexpr int kSpinChecks = 64;  // 进入futex休眠前的自旋检查次数
+  static constexpr uint64_t kLagSample = 64; // 每写入这么多条刷新一次最慢读者，用于统计最大落后量
+
+  // 写端独占的统计计数：单写者无需原子读改写
+  static void bump(std::atomic<uint64_t> &counter, uint64_t n = 1)
+  {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  static uint32_t roundCapacity(uint32_t cap)
+  {
+    uint32_t n = 2;
+    while (n < cap && n < (1u << 30))
+      n <<= 1;
+    return n;
+  }
+
+  static uint64_t totalSize(uint32_t cap, uint32_t payload)
+  {
+    return sizeof(ShmChannelHeader) + (uint64_t)cap * sizeof(ShmSlot) + payload;
+  }
+
+  void bind()
+  {
+    _hdr = (ShmChannelHeader *)_h.ptr;
+    _slots = (ShmSlot *)((char *)_h.ptr + sizeof(ShmChannelHeader));
+    _payload = _hdr->payload_size ? (uint8_t *)(_slots + _hdr->capacity) : nullptr;
+    _mask = _hdr->capacity - 1;
+    _min_read = 0;
+    _min_release = _hdr->payload_head.load(std::memory_order_acquire);
+    // 打开失败时等待退化为短休眠轮询
+    _notify_sig.open(_h.name, "notify");
+    _space_sig.open(_h.name, "space");
+  }
+
+  // 已接入读者中最小的负载释放位置（没有读者时为head）
+  uint64_t minPayloadRelease(uint64_t head) const
+  {
+    uint64_t m = head;
+    for (int i = 0; i < MAX_READERS; i++)
+    {
+      const ShmReaderCursor &c = _hdr->readers[i];
+      if (!c.active.load(std::memory_order_acquire))
+        continue;
+      uint64_t r = c.payload_release.load(std::memory_order_acquire);
+      if (r < m)
+        m = r;
+    }
+    return m;
+  }
+
+  // 写端判断环是否已满；顺带定期刷新最慢读者并记录最大落后量
+  bool ringFull()
+  {
+    uint64_t w = _hdr->write_seq.load(std::memory_order_relaxed);
+    if (w - _min_read < _hdr->capacity && (w & (kLagSample - 1)) != 0)
+      return false;
+    _min_read = minReadSeq(w);
+    uint64_t lag = w - _min_read;
+    if (lag > _hdr->stats.max_lag.load(std::memory_order_relaxed))
+      _hdr->stats.max_lag.store(lag, std::memory_order_relaxed);
+    return lag >= _hdr->capacity;
+  }
+
+  uint32_t policy() const { return _hdr->overflow_policy.load(std::memory_order_relaxed); }
+
+  // 阻塞策略：等待ready()成立，最长block_timeout_ms；其他策略直接返回false
+  template <typename Ready>
+  bool waitRoom(Ready ready)
+  {
+    if (policy() != SHM_OVERFLOW_BLOCK)
+      return false;
+    int timeout_ms = _hdr->block_timeout_ms.load(std::memory_order_relaxed);
+    // 写端即将休眠：先提交日志，等待期间日志读端也能读到已写入的记录
+    if (_journal)
+      _journal->commit();
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(timeout_ms);
+    bool ok = false;
+    _hdr->writer_waiting.store(1, std::memory_order_relaxed);
+    // 与spaceFreed中推进游标后检查writer_waiting配对（Dekker式），保证不丢唤醒
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (;;)
+    {
+      uint32_t token = _hdr->space.load(std::memory_order_acquire);
+      if (ready())
+      {
+        ok = true;
+        break;
+      }
+      int remaining = -1;
+      if (timeout_ms >= 0)
+      {
+        auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0)
+          break;
+        remaining = (int)left;
+      }
+      _space_sig.wait(&_hdr->space, token, remaining);
+    }
+    _hdr->writer_waiting.store(0, std::memory_order_relaxed);
+    bump(_hdr->stats.waits);
+    bump(_hdr->stats.wait_ns, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  std::chrono::steady_clock::now() - start).count());
+    return ok;
+  }
+
+  // 无法写入时按策略收尾：溢出策略写入溢出文件，其余计为丢弃；返回消息是否得到保留
+  bool overflowed(const ShmMessage &msg, const void *data, uint32_t len)
+  {
+    if (policy() == SHM_OVERFLOW_SPILL && _spill.append(msg, data, len))
+    {
+      bump(_hdr->stats.spills);
+      return true;
+    }
+    bump(_hdr->stats.drops);
+    return false;
+  }
+
+  // 写入槽位并发布（接了日志时先追加到日志）
+  void publish(const ShmMessage &msg)
+  {
+    uint64_t w = _hdr->write_seq.load(std::memory_order_relaxed);
+    if (_journal && !_journal->append(w, msg, payload(msg), msg.payload_len))
+      bump(_hdr->stats.journal_errors);
+    if (w - _min_read >= _hdr->capacity)
+      bump(_hdr->stats.overwrites);
+    ShmSlot &slot = _slots[w & _mask];
+    // 顺序锁写法：先清stamp，写入内容，再以release发布新stamp
+    slot.stamp.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.msg = msg;
+    slot.stamp.store(w + 1, std::memory_order_release);
+    _hdr->write_seq.store(w + 1, std::memory_order_release);
+    // 与waitFor中登记waiters后重查write_seq配对（Dekker式），保证不丢唤醒
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_hdr->waiters.load(std::memory_order_relaxed))
+      wake();
+  }
+
+  // 读端推进游标或释放负载后调用：阻塞策略下唤醒等待空间的写端
+  void spaceFreed()
+  {
+    if (policy() != SHM_OVERFLOW_BLOCK)
+      return;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_hdr->writer_waiting.load(std::memory_order_relaxed))
+    {
+      _hdr->space.fetch_add(1, std::memory_order_release);
+      _space_sig.wake(&_hdr->space, 1);
+    }
+  }
+
+  // 读者被写端超过：游标跳到target，记录跳过的条数
+  static void skipTo(ShmReaderCursor &c, uint64_t r, uint64_t target)
+  {
+    c.seq.store(target, std::memory_order_release);
+    if (target > r)
+    {
+      c.lost.fetch_add(target - r, std::memory_order_relaxed);
+      c.lagged.store(1, std::memory_order_release);
+    }
+  }
+
+  // 每次读取调用后的负载释放：非持有模式下释放上一次读取的负载，本次读到的负载保留到下一次读取
+  // 没有读到消息时也要释放，否则读空后最后一批负载一直占着负载区，写端可能因此停住
+  void consumed(ShmReaderCursor &c, const ShmMessage *msgs, size_t n)
+  {
+    if (n)
+      spaceFreed();
+    if (c.payload_hold.load(std::memory_order_relaxed))
+      return;
+    uint64_t pending = c.payload_pending.load(std::memory_order_relaxed);
+    if (c.payload_release.load(std::memory_order_relaxed) != pending)
+    {
+      c.payload_release.store(pending, std::memory_order_release);
+      if (!n)
+        spaceFreed();
+    }
+    for (size_t k = n; k-- > 0;)
+    {
+      if (msgs[k].payload_len)
+      {
+        c.payload_pending.store(msgs[k].payload_pos + msgs[k].payload_len, std::memory_order_relaxed);
+        break;
+      }
+    }
+  }
+
+  // 已接入读者中最小的游标（没有读者时为写序号，不产生背压）
+  uint64_t minReadSeq(uint64_t w) const
+  {
+    uint64_t m = w;
+    for (int i = 0; i < MAX_READERS; i++)
+    {
+      const ShmReaderCursor &c = _hdr->readers[i];
+      if (!c.active.load(std::memory_order_acquire))
+        continue;
+      uint64_t r = c.seq.load(std::memory_order_acquire);
+      if (r < m)
+        m = r;
+    }
+    return m;
+  }
+
+  // 仍在环中的最旧序号
+  uint64_t oldestSeq() const
+  {
+    uint64_t w = _hdr->write_seq.load(std::memory_order_acquire);
+    uint64_t base = _hdr->base_seq.load(std::memory_order_relaxed);
+    return w > base + _hdr->capacity ? w - _hdr->capacity : base;
+  }
+
+  void attachAt(ShmReaderCursor &c, uint64_t seq)
+  {
+    // 负载只保护接入之后写入的部分：接入前的消息可用payloadIntact判断负载是否已被复用
+    uint64_t head = _hdr->payload_head.load(std::memory_order_acquire);
+    c.payload_release.store(head, std::memory_order_relaxed);
+    c.payload_pending.store(head, std::memory_order_relaxed);
+    c.seq.store(seq, std::memory_order_release);
+    c.active.store(1, std::memory_order_release);
+  }
 
 public:
-  bool create(const char *name, uint32_t cap = 2048)
+  // cap向上取整为2的幂；payload_bytes为负载区大小（按缓存行取整，0表示不带负载区）
+  // opt为映射选项（预先缺页、大页、锁定、NUMA），实际生效的选项见mapFlags()
+  bool create(const char *name, uint32_t cap = 2048, uint32_t payload_bytes = 0,
+              const ShmMapOptions &opt = ShmMapOptions())
   {
-    uint32_t total = sizeof(ShmChannelHeader) + cap * sizeof(ShmMessage);
-    if (!ShmCrossPlatform::create(&_h, name, total))
+    cap = roundCapacity(cap);
+    payload_bytes = (payload_bytes + SHM_CACHE_LINE - 1) / SHM_CACHE_LINE * SHM_CACHE_LINE;
+    uint64_t total = totalSize(cap, payload_bytes);
+    if (total > UINT32_MAX || !ShmCrossPlatform::create(&_h, name, (uint32_t)total, opt))
       return false;
-    _hdr = (ShmChannelHeader *)_h.ptr;
-    _buf = (ShmMessage *)((char *)_h.ptr + sizeof(ShmChannelHeader));
-    _hdr->capacity = cap;
-    _hdr->wpos = _hdr->msg_count = 0;
+    ShmChannelHeader *hdr = (ShmChannelHeader *)_h.ptr;
+    hdr->capacity = cap;
+    hdr->payload_size = payload_bytes;
+    hdr->overflow_policy.store(SHM_OVERFLOW_DROP_NEWEST, std::memory_order_relaxed);
+    hdr->block_timeout_ms.store(0, std::memory_order_relaxed);
+    hdr->spill_path[0] = '\0';
+    hdr->journal_path[0] = '\0';
+    hdr->base_seq.store(0, std::memory_order_relaxed);
+    hdr->space.store(0, std::memory_order_relaxed);
+    hdr->writer_waiting.store(0, std::memory_order_relaxed);
+    hdr->stats.drops.store(0, std::memory_order_relaxed);
+    hdr->stats.overwrites.store(0, std::memory_order_relaxed);
+    hdr->stats.spills.store(0, std::memory_order_relaxed);
+    hdr->stats.max_lag.store(0, std::memory_order_relaxed);
+    hdr->stats.waits.store(0, std::memory_order_relaxed);
+    hdr->stats.wait_ns.store(0, std::memory_order_relaxed);
+    hdr->stats.journal_errors.store(0, std::memory_order_relaxed);
+    hdr->payload_head.store(0, std::memory_order_relaxed);
+    hdr->write_seq.store(0, std::memory_order_relaxed);
+    hdr->notify.store(0, std::memory_order_relaxed);
+    hdr->waiters.store(0, std::memory_order_relaxed);
     for (int i = 0; i < MAX_READERS; i++)
-      _hdr->rpos[i] = 0;
+    {
+      hdr->readers[i].seq.store(0, std::memory_order_relaxed);
+      hdr->readers[i].active.store(0, std::memory_order_relaxed);
+      hdr->readers[i].payload_hold.store(0, std::memory_order_relaxed);
+      hdr->readers[i].payload_release.store(0, std::memory_order_relaxed);
+      hdr->readers[i].payload_pending.store(0, std::memory_order_relaxed);
+      hdr->readers[i].lost.store(0, std::memory_order_relaxed);
+      hdr->readers[i].lagged.store(0, std::memory_order_relaxed);
+    }
+    ShmSlot *slots = (ShmSlot *)((char *)_h.ptr + sizeof(ShmChannelHeader));
+    for (uint32_t i = 0; i < cap; i++)
+      slots[i].stamp.store(0, std::memory_order_relaxed);
+    // magic最后写入：打开方看到magic即可认为头部已初始化
+    std::atomic_thread_fence(std::memory_order_release);
+    hdr->magic = SHM_CHANNEL_MAGIC;
+    bind();
     return true;
   }
 
-  bool open(const char *name, uint32_t cap = 2048)
+  // 容量取自创建方写入的头部，cap参数仅为兼容保留
+  bool open(const char *name, uint32_t cap = 2048, const ShmMapOptions &opt = ShmMapOptions())
   {
-    uint32_t total = sizeof(ShmChannelHeader) + cap * sizeof(ShmMessage);
-    if (!ShmCrossPlatform::open(&_h, name, total))
+    (void)cap;
+    if (!ShmCrossPlatform::open(&_h, name, sizeof(ShmChannelHeader)))
       return false;
-    _hdr = (ShmChannelHeader *)_h.ptr;
-    _buf = (ShmMessage *)((char *)_h.ptr + sizeof(ShmChannelHeader));
+    ShmChannelHeader *hdr = (ShmChannelHeader *)_h.ptr;
+    uint32_t real_cap = hdr->capacity;
+    uint32_t payload = hdr->payload_size;
+    bool valid = hdr->magic == SHM_CHANNEL_MAGIC && real_cap >= 2 && (real_cap & (real_cap - 1)) == 0 &&
+                 totalSize(real_cap, payload) <= UINT32_MAX;
+    ShmCrossPlatform::close(&_h);
+    if (!valid || !ShmCrossPlatform::open(&_h, name, (uint32_t)totalSize(real_cap, payload), opt))
+      return false;
+    bind();
     return true;
   }
 
-  bool push(const ShmMessage &msg)
+  // 设置环满时的策略（写端调用）：timeout_ms为阻塞策略的最长等待（<0不超时），
+  // spill_path为溢出文件（通常在GlobalShm登记的data_path旁加.spill后缀），溢出策略下打开失败返回false
+  bool setOverflowPolicy(uint32_t overflow_policy, int timeout_ms = 0, const char *spill_path = nullptr)
   {
-    if (_hdr->msg_count >= _hdr->capacity)
+    if (overflow_policy > SHM_OVERFLOW_SPILL)
+      return false;
+    _spill.close();
+    if (overflow_policy == SHM_OVERFLOW_SPILL && (!spill_path || !_spill.open(spill_path)))
       return false;
-    _buf[_hdr->wpos] = msg;
-    _hdr->wpos = (_hdr->wpos + 1) % _hdr->capacity;
-    __sync_add_and_fetch(&_hdr->msg_count, 1);
+    strncpy(_hdr->spill_path, spill_path ? spill_path : "", DATA_PATH_MAX - 1);
+    _hdr->spill_path[DATA_PATH_MAX - 1] = '\0';
+    _hdr->block_timeout_ms.store(timeout_ms, std::memory_order_relaxed);
+    _hdr->overflow_policy.store(overflow_policy, std::memory_order_release);
     return true;
   }
 
-  bool pop(uint8_t readerId, ShmMessage &out)
+  // 写入一条消息；环满时按溢出策略处理，返回false表示消息被丢弃
+  bool push(const ShmMessage &msg)
+  {
+    if (ringFull() && policy() != SHM_OVERFLOW_OVERWRITE && !waitRoom([this] { return !ringFull(); }))
+      return overflowed(msg, payload(msg), msg.payload_len);
+    publish(msg);
+    return true;
+  }
+
+  // 在负载区分配len字节（连续、8字节对齐），写入msg的payload字段并返回写入地址
+  // 调用方写完数据后push(msg)；最慢的读者尚未释放足够空间时返回nullptr
+  uint8_t *allocPayload(uint32_t len, ShmMessage &msg)
+  {
+    const uint64_t size = _hdr->payload_size;
+    if (!_payload || len == 0 || len > size)
+      return nullptr;
+    uint64_t head = _hdr->payload_head.load(std::memory_order_relaxed);
+    uint64_t start = head;
+    if (start % size + len > size)
+      start += size - start % size; // 尾部放不下：跳到负载区开头
+    uint64_t end = (start + len + 7) & ~(uint64_t)7;
+    // 覆盖策略不等待读者释放，读者可用payloadIntact判断负载是否已被复用
+    if (end - _min_release > size && policy() != SHM_OVERFLOW_OVERWRITE)
+    {
+      _min_release = minPayloadRelease(head);
+      if (end - _min_release > size)
+        return nullptr;
+    }
+    _hdr->payload_head.store(end, std::memory_order_release);
+    msg.payload_pos = start;
+    msg.payload_len = len;
+    return _payload + start % size;
+  }
+
+  // 复制负载后写入消息；环或负载区已满时按溢出策略处理，返回false表示消息被丢弃
+  bool pushPayload(ShmMessage msg, const void *data, uint32_t len)
+  {
+    if (len == 0)
+      return push(msg);
+    if (!_payload || len > _hdr->payload_size)
+      return overflowed(msg, data, len);
+    uint8_t *dst = nullptr;
+    auto reserve = [&] {
+      if (ringFull() && policy() != SHM_OVERFLOW_OVERWRITE)
+        return false;
+      dst = allocPayload(len, msg);
+      return dst != nullptr;
+    };
+    if (!reserve() && !waitRoom(reserve))
+      return overflowed(msg, data, len);
+    memcpy(dst, data, len);
+    publish(msg);
+    return true;
+  }
+
+  // 消息负载在映射中的地址（无负载返回nullptr）
+  const uint8_t *payload(const ShmMessage &msg) const
+  {
+    return msg.payload_len && _payload ? _payload + msg.payload_pos % _hdr->payload_size : nullptr;
+  }
+
+  // 负载是否仍未被复用（只对接入前写入、不受回收保护的消息有意义）
+  bool payloadIntact(const ShmMessage &msg) const
+  {
+    return _hdr->payload_head.load(std::memory_order_acquire) <= msg.payload_pos + _hdr->payload_size;
+  }
+
+  // 持有模式：负载不再随下一次读取自动释放，需调用releasePayload
+  void holdPayloads(uint8_t readerId, bool hold)
+  {
+    if (readerId >= MAX_READERS)
+      return;
+    ShmReaderCursor &c = _hdr->readers[readerId];
+    if (!hold)
+      c.payload_release.store(c.payload_pending.load(std::memory_order_relaxed), std::memory_order_release);
+    c.payload_hold.store(hold ? 1 : 0, std::memory_order_release);
+    spaceFreed();
+  }
+
+  // 释放end（消息的payload_pos + payload_len）之前的所有负载
+  void releasePayload(uint8_t readerId, uint64_t end)
   {
     if (readerId >= MAX_READERS)
+      return;
+    ShmReaderCursor &c = _hdr->readers[readerId];
+    if (end > _hdr->payload_head.load(std::memory_order_acquire))
+      return;
+    if (end > c.payload_release.load(std::memory_order_relaxed))
+      c.payload_release.store(end, std::memory_order_release);
+    if (end > c.payload_pending.load(std::memory_order_relaxed))
+      c.payload_pending.store(end, std::memory_order_relaxed);
+    spaceFreed();
+  }
+
+  // 唤醒所有等待者（写端在有读者休眠时自动调用；也可用于打断等待）
+  void wake()
+  {
+    _hdr->notify.fetch_add(1, std::memory_order_release);
+    _notify_sig.wake(&_hdr->notify, _hdr->waiters.load(std::memory_order_seq_cst));
+  }
+
+  // 等待写序号超过seq（即序号seq的消息已发布），timeout_ms<0不超时
+  // 先短暂自旋以保持微秒级延迟，之后在futex（其他平台为命名唤醒信号）上休眠，空闲时不占CPU
+  // 返回时条件是否满足以返回值为准：被wake()打断时可能提前返回false
+  bool waitFor(uint64_t seq, int timeout_ms)
+  {
+    for (int i = 0; i < kSpinChecks; i++)
+    {
+      if (_hdr->write_seq.load(std::memory_order_acquire) > seq)
+        return true;
+      std::this_thread::yield();
+    }
+    if (timeout_ms == 0)
       return false;
-    if (_hdr->msg_count == 0)
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    _hdr->waiters.fetch_add(1, std::memory_order_seq_cst);
+    bool ready = false;
+    for (;;)
+    {
+      uint32_t token = _hdr->notify.load(std::memory_order_acquire);
+      if (_hdr->write_seq.load(std::memory_order_seq_cst) > seq)
+      {
+        ready = true;
+        break;
+      }
+      int remaining = -1;
+      if (timeout_ms > 0)
+      {
+        auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0)
+          break;
+        remaining = (int)left;
+      }
+      _notify_sig.wait(&_hdr->notify, token, remaining);
+      // notify变化说明被唤醒：重查一次后返回，由调用方决定是否继续等待
+      if (_hdr->notify.load(std::memory_order_acquire) != token)
+      {
+        ready = _hdr->write_seq.load(std::memory_order_acquire) > seq;
+        break;
+      }
+    }
+    _hdr->waiters.fetch_sub(1, std::memory_order_release);
+    return ready;
+  }
+
+  // 非持有模式下提前释放上一次读取的负载：读者即将休眠时调用，否则写端可能在负载区上一直等待
+  void releaseLastRead(uint8_t readerId)
+  {
+    if (readerId < MAX_READERS)
+      consumed(_hdr->readers[readerId], nullptr, 0);
+  }
+
+  // 阻塞等待readerId有可读消息，超时返回false（视为一次读取：上一次读取的负载随之释放）
+  bool wait(uint8_t readerId, int timeout_ms)
+  {
+    if (readerId >= MAX_READERS)
+      return false;
+    ShmReaderCursor &c = _hdr->readers[readerId];
+    if (!c.active.load(std::memory_order_relaxed))
+      attach(readerId);
+    consumed(c, nullptr, 0);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    for (;;)
+    {
+      if (waitFor(c.seq.load(std::memory_order_relaxed), timeout_ms))
+        return true;
+      if (timeout_ms >= 0)
+      {
+        auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0)
+          return false;
+        timeout_ms = (int)left;
+      }
+    }
+  }
+
+  // 读者游标（下一条要读的序号）
+  uint64_t readSeq(uint8_t readerId) const
+  {
+    return readerId < MAX_READERS ? _hdr->readers[readerId].seq.load(std::memory_order_acquire) : 0;
+  }
+
+  // 接入读者：from_oldest为true时从环中最旧的消息开始，否则只接收之后写入的消息
+  bool attach(uint8_t readerId, bool from_oldest = true)
+  {
+    if (readerId >= MAX_READERS)
       return false;
-    out = _buf[_hdr->rpos[readerId]];
-    _hdr->rpos[readerId] = (_hdr->rpos[readerId] + 1) % _hdr->capacity;
-    __sync_sub_and_fetch(&_hdr->msg_count, 1);
+    attachAt(_hdr->readers[readerId], from_oldest ? oldestSeq() : _hdr->write_seq.load(std::memory_order_acquire));
     return true;
   }
 
-  void close() { ShmCrossPlatform::close(&_h); }
-};
\ No newline at end of file
+  // 把读者游标移到seq（读完日志中的历史后切换到实时环）；seq已不在环中或尚未写入时返回false
+  bool seek(uint8_t readerId, uint64_t seq)
+  {
+    if (readerId >= MAX_READERS || seq < oldestSeq() || seq > _hdr->write_seq.load(std::memory_order_acquire))
+      return false;
+    attachAt(_hdr->readers[readerId], seq);
+    // 移动期间写端又超过了seq：交给下一次读取按被超过处理
+    return true;
+  }
+
+  // 接入日志（写端，create之后、写入之前调用）：写序号从日志末尾继续，
+  // 并把日志中最新的至多capacity条装回环中，写端重启后读者无需生产方重发即可接着读
+  bool attachJournal(ShmJournal *journal)
+  {
+    if (!journal || !journal->isOpen() || _hdr->write_seq.load(std::memory_order_relaxed) != 0)
+      return false;
+    uint64_t end = journal->nextSeq();
+    uint64_t start = end > _hdr->capacity ? end - _hdr->capacity : 0;
+    ShmJournalReader reader;
+    if (!reader.open(journal->path().c_str()) || !reader.seek(start > reader.firstSeq() ? start : reader.firstSeq()))
+      start = end;
+    else
+      start = reader.position();
+    _hdr->base_seq.store(start, std::memory_order_relaxed);
+    _hdr->write_seq.store(start, std::memory_order_release);
+    _min_read = start;
+    uint64_t seq;
+    ShmMessage msg;
+    const uint8_t *data;
+    uint32_t len;
+    while (_hdr->write_seq.load(std::memory_order_relaxed) < end && reader.next(seq, msg, data, len))
+    {
+      // 日志段之间有缺口：环从缺口之后重新装载，保证环内序号与日志序号一致
+      if (seq != _hdr->write_seq.load(std::memory_order_relaxed))
+      {
+        _hdr->base_seq.store(seq, std::memory_order_relaxed);
+        _hdr->write_seq.store(seq, std::memory_order_release);
+        _min_read = seq;
+      }
+      msg.payload_len = 0;
+      uint8_t *dst = len ? allocPayload(len, msg) : nullptr;
+      if (dst)
+        memcpy(dst, data, len);
+      publish(msg);
+    }
+    if (_hdr->write_seq.load(std::memory_order_relaxed) != end)
+    {
+      // 历史没能完整装回：环从日志末尾开始为空
+      _hdr->base_seq.store(end, std::memory_order_relaxed);
+      _hdr->write_seq.store(end, std::memory_order_release);
+      _min_read = end;
+    }
+    strncpy(_hdr->journal_path, journal->path().c_str(), DATA_PATH_MAX - 1);
+    _hdr->journal_path[DATA_PATH_MAX - 1] = '\0';
+    _journal = journal;
+    return true;
+  }
+
+  // 断开读者，不再对写端产生背压
+  void detach(uint8_t readerId)
+  {
+    if (readerId >= MAX_READERS)
+      return;
+    _hdr->readers[readerId].active.store(0, std::memory_order_release);
+    spaceFreed();
+  }
+
+  // 读者自上次查询以来是否被写端超过（查询后清除标记）
+  bool takeLagged(uint8_t readerId)
+  {
+    return readerId < MAX_READERS && _hdr->readers[readerId].lagged.exchange(0, std::memory_order_acq_rel);
+  }
+
+  // 读者因被超过而跳过的消息总数
+  uint64_t lost(uint8_t readerId) const
+  {
+    return readerId < MAX_READERS ? _hdr->readers[readerId].lost.load(std::memory_order_relaxed) : 0;
+  }
+
+  // 读取readerId的下一条消息（未接入的读者自动从最旧的消息接入）
+  bool pop(uint8_t readerId, ShmMessage &out)
+  {
+    if (readerId >= MAX_READERS)
+      return false;
+    ShmReaderCursor &c = _hdr->readers[readerId];
+    if (!c.active.load(std::memory_order_relaxed))
+      attach(readerId);
+    for (;;)
+    {
+      uint64_t r = c.seq.load(std::memory_order_relaxed);
+      const ShmSlot &slot = _slots[r & _mask];
+      uint64_t stamp = slot.stamp.load(std::memory_order_acquire);
+      if (stamp == r + 1)
+      {
+        out = slot.msg;
+        // 复制期间被写端覆盖则stamp已变化
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.stamp.load(std::memory_order_relaxed) == stamp)
+        {
+          c.seq.store(r + 1, std::memory_order_release);
+          consumed(c, &out, 1);
+          return true;
+        }
+      }
+      else if (stamp <= r)
+      {
+        // 尚未写入、正在写入，或写端刚发布而本次读到的是旧stamp：下次再读
+        consumed(c, nullptr, 0);
+        return false;
+      }
+      // 被写端超过一圈：跳到最旧的可用消息
+      uint64_t oldest = oldestSeq();
+      skipTo(c, r, oldest > r ? oldest : r + 1);
+    }
+  }
+
+  // 批量读取：一次取得写序号，连续复制最多max条后统一校验并只更新一次游标，返回条数
+  size_t popBatch(uint8_t readerId, ShmMessage *out, size_t max)
+  {
+    if (readerId >= MAX_READERS || max == 0)
+      return 0;
+    ShmReaderCursor &c = _hdr->readers[readerId];
+    if (!c.active.load(std::memory_order_relaxed))
+      attach(readerId);
+    for (;;)
+    {
+      uint64_t r = c.seq.load(std::memory_order_relaxed);
+      uint64_t w = _hdr->write_seq.load(std::memory_order_acquire);
+      if (w <= r)
+      {
+        consumed(c, nullptr, 0);
+        return 0;
+      }
+      if (w - r > _hdr->capacity)
+      {
+        // 已被写端超过一圈：跳到最旧的可用消息
+        skipTo(c, r, w - _hdr->capacity);
+        continue;
+      }
+      size_t n = w - r < max ? (size_t)(w - r) : max;
+      size_t k = 0;
+      for (; k < n; k++)
+      {
+        const ShmSlot &slot = _slots[(r + k) & _mask];
+        if (slot.stamp.load(std::memory_order_acquire) != r + k + 1)
+          break;
+        out[k] = slot.msg;
+      }
+      // 复制期间被覆盖的消息及其之后的都不算数
+      std::atomic_thread_fence(std::memory_order_acquire);
+      for (size_t i = 0; i < k; i++)
+      {
+        if (_slots[(r + i) & _mask].stamp.load(std::memory_order_relaxed) != r + i + 1)
+        {
+          k = i;
+          break;
+        }
+      }
+      if (k == 0)
+      {
+        // 首条即不匹配：尚未发布完成则返回，被覆盖则按pop的规则跳过
+        uint64_t stamp = _slots[r & _mask].stamp.load(std::memory_order_acquire);
+        if (stamp <= r + 1)
+        {
+          consumed(c, nullptr, 0);
+          return 0;
+        }
+        uint64_t oldest = oldestSeq();
+        skipTo(c, r, oldest > r ? oldest : r + 1);
+        continue;
+      }
+      c.seq.store(r + k, std::memory_order_release);
+      consumed(c, out, k);
+      return k;
+    }
+  }
+
+  // readerId尚未读取的消息数
+  uint64_t available(uint8_t readerId) const
+  {
+    if (readerId >= MAX_READERS)
+      return 0;
+    uint64_t w = _hdr->write_seq.load(std::memory_order_acquire);
+    uint64_t r = _hdr->readers[readerId].seq.load(std::memory_order_acquire);
+    return w > r ? w - r : 0;
+  }
+
+  bool isOpen() const { return _hdr != nullptr; }
+  bool isAttached(uint8_t readerId) const
+  {
+    return readerId < MAX_READERS && _hdr->readers[readerId].active.load(std::memory_order_acquire);
+  }
+  uint32_t capacity() const { return _hdr ? _hdr->capacity : 0; }
+  const uint8_t *payloadBase() const { return _payload; }
+  uint32_t payloadSize() const { return _hdr ? _hdr->payload_size : 0; }
+  uint64_t writeSeq() const { return _hdr->write_seq.load(std::memory_order_acquire); }
+  uint64_t oldest() const { return oldestSeq(); }
+  const ShmChannelHeader *header() const { return _hdr; }
+  // 本进程映射上实际生效的选项（SHM_MAP_*）
+  uint32_t mapFlags() const { return _hdr ? _h.map_flags : 0; }
+
+  // 提交日志中不足一组的记录，使其对日志读端可见（写端线程调用）
+  // 写端空闲时调用（如等待下一条数据前）；force为false时只在距上次提交超过group_ms时提交，可放在写端循环中周期调用
+  void flush(bool force = true)
+  {
+    if (!_journal)
+      return;
+    if (force)
+      _journal->commit();
+    else
+      _journal->commitIfDue();
+  }
+
+  void close()
+  {
+    if (_journal)
+      _journal->commit();
+    _journal = nullptr;
+    _spill.close();
+    _notify_sig.close();
+    _space_sig.close();
+    ShmCrossPlatform::close(&_h);
+    _hdr = nullptr;
+    _slots = nullptr;
+  }
+
+  // 删除通道段及其唤醒信号的名字（已打开的各方不受影响）
+  static void remove(const char *name)
+  {
+    ShmCrossPlatform::remove(name);
+    ShmWakeSignal::remove(name, "notify");
+    ShmWakeSignal::remove(name, "space");
+  }
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include <stdint.h>
 #include <string.h>
+#include <atomic>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -17,6 +18,17 @@
 #define CHANNEL_NAME_MAX 32
 #define DATA_PATH_MAX 256
 
+// 共享内存布局版本（GlobalShmCtrl.version），布局不兼容时递增
+#define SHM_LAYOUT_VERSION 6
+#define SHM_CHANNEL_MAGIC 0x53484D43 // "SHMC"
+#define SHM_CACHE_LINE 64
+
+// 环满（或负载区满）时的写端策略，存放在通道头部
+#define SHM_OVERFLOW_DROP_NEWEST 0 // 丢弃新消息（默认）
+#define SHM_OVERFLOW_BLOCK 1       // 等待读者腾出空间，最长block_timeout_ms，超时丢弃
+#define SHM_OVERFLOW_OVERWRITE 2   // 覆盖最旧的消息，被超过的读者置lagged标记
+#define SHM_OVERFLOW_SPILL 3       // 写入spill_path溢出文件
+
 #define CHANNEL_PROXY 1
 #define CHANNEL_API 2
 #define CHANNEL_FILE_DIFF 3
@@ -28,15 +40,70 @@ struct ShmMessage
   uint32_t channel_type;
   uint64_t file_offset;
   uint32_t data_len;
+  uint32_t payload_len; // 通道负载区中的负载长度，0表示无负载
   uint64_t ts;
+  uint64_t payload_pos; // 负载的绝对位置（单调递增，对负载区大小取模即为偏移）
+};
+
+// 跨进程原子变量需无锁实现（与地址无关）
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shm requires lock-free 64-bit atomics");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shm requires lock-free 32-bit atomics");
+
+// 读端游标：每个读者独占一条缓存行，读者之间、读者与写端互不干扰
+// 负载回收按位置划代：写端只复用所有已接入读者payload_release之前的字节
+struct alignas(SHM_CACHE_LINE) ShmReaderCursor
+{
+  std::atomic<uint64_t> seq;             // 下一条要读的消息序号
+  std::atomic<uint32_t> active;          // 1表示已接入，参与写端背压
+  std::atomic<uint32_t> payload_hold;    // 1表示由读者显式释放负载，否则负载在下一次读取时自动释放
+  std::atomic<uint64_t> payload_release; // 已释放的负载位置
+  std::atomic<uint64_t> payload_pending; // 上一次读取到的负载末尾（下一次读取时释放）
+  std::atomic<uint64_t> lost;            // 被写端超过而跳过的消息总数
+  std::atomic<uint32_t> lagged;          // 1表示自上次查询以来被写端超过过
+};
+
+// 写端统计：只由写端更新，任何进程可读（写入条数即write_seq）
+struct ShmChannelStats
+{
+  std::atomic<uint64_t> drops;      // 丢弃的消息数（丢弃新消息、阻塞超时、溢出文件写入失败）
+  std::atomic<uint64_t> overwrites; // 覆盖了未读消息的写入次数
+  std::atomic<uint64_t> spills;     // 写入溢出文件的消息数
+  std::atomic<uint64_t> max_lag;    // 观察到的最慢读者最大落后条数
+  std::atomic<uint64_t> waits;      // 阻塞策略下的等待次数
+  std::atomic<uint64_t> wait_ns;    // 阻塞等待累计耗时
+  std::atomic<uint64_t> journal_errors; // 写入日志失败的消息数
+};
+
+// 环形缓冲槽：stamp为序号+1（0表示空或正在写入），写端release发布、读端acquire读取
+struct ShmSlot
+{
+  std::atomic<uint64_t> stamp;
+  ShmMessage msg;
 };
 
+// 单写多读广播环：每个读者独立消费全部消息
+// 写序号单调递增（64位不回绕），槽位 = 序号 & (capacity - 1)
+// 映射布局：头部 | capacity个槽 | payload_size字节的负载区
 struct ShmChannelHeader
 {
-  uint32_t capacity;
-  uint32_t wpos;
-  uint32_t rpos[MAX_READERS];
-  uint32_t msg_count;
+  uint32_t magic;
+  uint32_t capacity;     // 2的幂
+  uint32_t payload_size; // 负载区字节数（0表示无负载区）
+  std::atomic<uint32_t> overflow_policy; // SHM_OVERFLOW_*
+  std::atomic<int32_t> block_timeout_ms; // 阻塞策略的最长等待（<0不超时）
+  char spill_path[DATA_PATH_MAX];        // 溢出文件路径
+  char journal_path[DATA_PATH_MAX];      // 日志路径（段文件前缀，未接日志为空）
+  std::atomic<uint64_t> base_seq;        // 环中第一条消息的序号（接日志恢复时不为0）
+  alignas(SHM_CACHE_LINE) std::atomic<uint64_t> write_seq; // 已发布的消息数
+  std::atomic<uint64_t> payload_head;                       // 负载区下一个分配位置（写端独占）
+  // 阻塞等待：读者登记waiters后在notify（futex字）上休眠，写端只在waiters非0时递增notify并唤醒
+  alignas(SHM_CACHE_LINE) std::atomic<uint32_t> notify;
+  std::atomic<uint32_t> waiters;
+  // 阻塞策略：写端置writer_waiting后在space上休眠，读者推进游标或释放负载后唤醒
+  alignas(SHM_CACHE_LINE) std::atomic<uint32_t> space;
+  std::atomic<uint32_t> writer_waiting;
+  alignas(SHM_CACHE_LINE) ShmChannelStats stats;
+  ShmReaderCursor readers[MAX_READERS];
 };
 
 struct GlobalShmCtrl
@@ -53,6 +120,23 @@ struct GlobalShmCtrl
   } channels[MAX_CHANNELS];
 };
 
+// 段映射选项：大通道在首条消息前就建好页表并常驻内存，避免热路径上的缺页与换出
+struct ShmMapOptions
+{
+  bool populate = false;  // 预先缺页（Linux用MAP_POPULATE/MADV_POPULATE_*，其他平台逐页预触；打开已有段时只读预触）
+  bool huge_pages = false; // 透明大页建议（MADV_HUGEPAGE，段大小按2MB取整），仅Linux
+  bool lock = false;       // mlock/VirtualLock锁定常驻，受RLIMIT_MEMLOCK/工作集限制可能失败
+  int numa_node = -1;      // 首选NUMA节点（Linux为mbind MPOL_PREFERRED，Windows为CreateFileMappingNuma），-1不指定
+  bool owner_only = false; // 仅创建时有效：段只允许当前用户访问（POSIX为0600，Windows为只授权所有者与SYSTEM的DACL）
+};
+
+// ShmHandle.map_flags：实际生效的映射选项，请求了但未生效的选项对应位为0
+#define SHM_MAP_POPULATED 0x1
+#define SHM_MAP_HUGE_PAGES 0x2
+#define SHM_MAP_LOCKED 0x4
+#define SHM_MAP_NUMA 0x8
+#define SHM_HUGE_PAGE_SIZE (2u * 1024 * 1024)
+
 struct ShmHandle
 {
 #ifdef _WIN32
@@ -62,5 +146,6 @@ struct ShmHandle
 #endif
   void *ptr;
   uint32_t size;
+  uint32_t map_flags;
   char name[SHM_NAME_MAX];
 };
\ No newline at end of file
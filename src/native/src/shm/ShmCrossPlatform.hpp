@@ -1,50 +1,207 @@
 #pragma once
 #include "ShmCommon.h"
+#ifdef _WIN32
+#include <sddl.h>
+#endif
+#include <stdio.h>
+#include <thread>
+#include <chrono>
+#include <string>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#elif !defined(_WIN32)
+#include <errno.h>
+#include <poll.h>
+#endif
 
 class ShmCrossPlatform
 {
 public:
-  static bool create(ShmHandle *h, const char *name, uint32_t size)
+  static bool create(ShmHandle *h, const char *name, uint32_t size, const ShmMapOptions &opt = ShmMapOptions())
   {
     strncpy(h->name, name, SHM_NAME_MAX - 1);
-    h->size = size;
     h->ptr = nullptr;
+    h->map_flags = 0;
+#if defined(__linux__)
+    // 段按大页取整，内核才能以PMD映射整段
+    if (opt.huge_pages)
+    {
+      uint64_t rounded = ((uint64_t)size + SHM_HUGE_PAGE_SIZE - 1) / SHM_HUGE_PAGE_SIZE * SHM_HUGE_PAGE_SIZE;
+      if (rounded <= UINT32_MAX)
+        size = (uint32_t)rounded;
+    }
+#endif
+    h->size = size;
 
 #ifdef _WIN32
-    h->hMap = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, size, name);
+    // 仅限本用户：受保护的DACL只授权对象所有者与SYSTEM，不继承会话默认的宽松权限
+    SECURITY_ATTRIBUTES sa = {sizeof(sa), nullptr, FALSE};
+    if (opt.owner_only &&
+        !ConvertStringSecurityDescriptorToSecurityDescriptorA("D:P(A;;GA;;;OW)(A;;GA;;;SY)", SDDL_REVISION_1,
+                                                              &sa.lpSecurityDescriptor, nullptr))
+      return false;
+    LPSECURITY_ATTRIBUTES psa = opt.owner_only ? &sa : nullptr;
+    if (opt.numa_node >= 0)
+    {
+      h->hMap = CreateFileMappingNumaA(INVALID_HANDLE_VALUE, psa, PAGE_READWRITE, 0, size, name, (DWORD)opt.numa_node);
+      if (h->hMap)
+        h->map_flags |= SHM_MAP_NUMA;
+    }
+    else
+      h->hMap = CreateFileMappingA(INVALID_HANDLE_VALUE, psa, PAGE_READWRITE, 0, size, name);
+    DWORD err = GetLastError();
+    if (sa.lpSecurityDescriptor)
+      LocalFree(sa.lpSecurityDescriptor);
+    // 同名对象已存在时沿用的是它原有的权限，不能当作仅限本用户的段
+    if (h->hMap && opt.owner_only && err == ERROR_ALREADY_EXISTS)
+    {
+      CloseHandle(h->hMap);
+      h->hMap = nullptr;
+    }
     if (!h->hMap)
       return false;
     h->ptr = MapViewOfFile(h->hMap, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!h->ptr)
+    {
+      CloseHandle(h->hMap);
+      return false;
+    }
+    applyOptions(h, opt, false, true);
 #else
-    h->fd = shm_open(name, O_CREAT | O_RDWR, 0666);
+    // 仅限本用户：先删掉同名旧段再独占创建，不沿用别人预先建好的宽权限段（删不掉时创建失败）
+    if (opt.owner_only)
+      shm_unlink(name);
+    h->fd = shm_open(name, O_CREAT | O_RDWR | (opt.owner_only ? O_EXCL : 0), opt.owner_only ? 0600 : 0666);
     if (h->fd < 0)
       return false;
     ftruncate(h->fd, size);
-    h->ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, h->fd, 0);
+    // 大页建议与NUMA策略须在首次缺页前设置，这两种情况下改为映射后再预触
+    bool early = false;
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    early = opt.populate && !opt.huge_pages && opt.numa_node < 0;
+    if (early)
+      flags |= MAP_POPULATE;
 #endif
-    return h->ptr != nullptr;
+    h->ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, h->fd, 0);
+    if (h->ptr == MAP_FAILED)
+    {
+      h->ptr = nullptr;
+      ::close(h->fd);
+      return false;
+    }
+    applyOptions(h, opt, early, true);
+#endif
+    return true;
   }
 
-  static bool open(ShmHandle *h, const char *name, uint32_t size)
+  // size为0时映射整个段，并把实际大小写回h->size；size超过段的实际大小时失败（访问段外的映射会触发SIGBUS）
+  // 映射选项只作用于本进程的映射（预触、锁定）；NUMA策略与大页建议对段内尚未分配的页生效
+  static bool open(ShmHandle *h, const char *name, uint32_t size, const ShmMapOptions &opt = ShmMapOptions())
   {
     strncpy(h->name, name, SHM_NAME_MAX - 1);
     h->size = size;
     h->ptr = nullptr;
+    h->map_flags = 0;
 
 #ifdef _WIN32
     h->hMap = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
     if (!h->hMap)
       return false;
-    h->ptr = MapViewOfFile(h->hMap, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    h->ptr = MapViewOfFile(h->hMap, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (h->ptr)
+    {
+      MEMORY_BASIC_INFORMATION info;
+      uint64_t actual = 0;
+      if (VirtualQuery(h->ptr, &info, sizeof(info)) == sizeof(info))
+        actual = (uint64_t)info.RegionSize;
+      if (size == 0 && actual <= UINT32_MAX)
+        h->size = (uint32_t)actual;
+      if (h->size == 0 || h->size > actual)
+      {
+        UnmapViewOfFile(h->ptr);
+        h->ptr = nullptr;
+      }
+    }
+    if (!h->ptr)
+      CloseHandle(h->hMap);
 #else
     h->fd = shm_open(name, O_RDWR, 0666);
     if (h->fd < 0)
       return false;
-    h->ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, h->fd, 0);
+    struct stat st;
+    if (fstat(h->fd, &st) != 0 || (uint64_t)st.st_size < h->size)
+      h->size = 0;
+    else if (size == 0 && (uint64_t)st.st_size <= UINT32_MAX)
+      h->size = (uint32_t)st.st_size;
+    if (h->size > 0)
+      h->ptr = mmap(nullptr, h->size, PROT_READ | PROT_WRITE, MAP_SHARED, h->fd, 0);
+    if (!h->ptr || h->ptr == MAP_FAILED)
+    {
+      h->ptr = nullptr;
+      ::close(h->fd);
+    }
 #endif
+    if (h->ptr)
+      applyOptions(h, opt, false, false);
     return h->ptr != nullptr;
   }
 
+  // 跨进程等待：*addr仍等于expected时休眠，直到被唤醒或超时（timeout_ms<0不超时）
+  // Linux用共享futex；其他平台没有跨进程的地址等待原语，退化为最长1ms的休眠，调用方需循环重查
+  static void waitAddress(std::atomic<uint32_t> *addr, uint32_t expected, int timeout_ms)
+  {
+#if defined(__linux__)
+    struct timespec ts;
+    struct timespec *pts = nullptr;
+    if (timeout_ms >= 0)
+    {
+      ts.tv_sec = timeout_ms / 1000;
+      ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+      pts = &ts;
+    }
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAIT, expected, pts, nullptr, 0);
+#else
+    if (addr->load(std::memory_order_acquire) != expected || timeout_ms == 0)
+      return;
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms < 0 || timeout_ms > 1 ? 1 : timeout_ms));
+#endif
+  }
+
+  // 忙等循环中的CPU提示，降低自旋对同核超线程与功耗的影响
+  static inline void cpuRelax()
+  {
+#if defined(_MSC_VER)
+    YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+  }
+
+  // 唤醒所有在addr上等待的线程/进程
+  static void wakeAddress(std::atomic<uint32_t> *addr)
+  {
+#if defined(__linux__)
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+#else
+    (void)addr;
+#endif
+  }
+
+  // 删除段名（已映射的进程不受影响）；Windows上段随最后一个句柄关闭而释放，无需删除
+  static void remove(const char *name)
+  {
+#ifdef _WIN32
+    (void)name;
+#else
+    shm_unlink(name);
+#endif
+  }
+
   static void close(ShmHandle *h)
   {
     if (!h->ptr)
@@ -58,4 +215,200 @@ public:
 #endif
     h->ptr = nullptr;
   }
-};
\ No newline at end of file
+
+private:
+  // 按选项调整刚建立的映射，结果记入h->map_flags；populated表示映射时已由MAP_POPULATE预先缺页
+  // creating为false（打开已有段）时对端可能已在收发，只能读预触
+  static void applyOptions(ShmHandle *h, const ShmMapOptions &opt, bool populated, bool creating)
+  {
+    if (populated)
+      h->map_flags |= SHM_MAP_POPULATED;
+#if defined(__linux__)
+    if (opt.huge_pages && madvise(h->ptr, h->size, MADV_HUGEPAGE) == 0 && shmemHugePagesAllowed())
+      h->map_flags |= SHM_MAP_HUGE_PAGES;
+    if (opt.numa_node >= 0 && bindNode(h->ptr, h->size, opt.numa_node))
+      h->map_flags |= SHM_MAP_NUMA;
+#endif
+    if (opt.populate && !populated)
+    {
+      prefault(h->ptr, h->size, creating);
+      h->map_flags |= SHM_MAP_POPULATED;
+    }
+    if (opt.lock)
+    {
+#ifdef _WIN32
+      bool locked = VirtualLock(h->ptr, h->size) != 0;
+#else
+      bool locked = mlock(h->ptr, h->size) == 0;
+#endif
+      if (locked)
+        h->map_flags |= SHM_MAP_LOCKED;
+    }
+  }
+
+  // 逐页触发缺页：write为true时写入原值（只用于刚创建、还没有其他进程映射的段），
+  // 否则只读取——非原子的读后写会覆盖对端同时写入的序号、槽位标记或读游标
+  static void prefault(void *ptr, uint32_t size, bool write)
+  {
+#if defined(__linux__) && defined(MADV_POPULATE_WRITE)
+    if (madvise(ptr, size, write ? MADV_POPULATE_WRITE : MADV_POPULATE_READ) == 0)
+      return;
+#endif
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    size_t page = si.dwPageSize;
+#else
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+    volatile uint8_t *p = (volatile uint8_t *)ptr;
+    uint8_t sink = 0;
+    for (size_t off = 0; off < size; off += page)
+    {
+      if (write)
+        p[off] = p[off];
+      else
+        sink ^= p[off];
+    }
+    (void)sink;
+  }
+
+#if defined(__linux__)
+  // shmem_enabled为never/deny时MADV_HUGEPAGE不报错但不会分配大页
+  static bool shmemHugePagesAllowed()
+  {
+    FILE *f = fopen("/sys/kernel/mm/transparent_hugepage/shmem_enabled", "r");
+    if (!f)
+      return false;
+    char buf[128] = {0};
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+    return !strstr(buf, "[never]") && !strstr(buf, "[deny]");
+  }
+
+  // 直接调用mbind，不依赖libnuma；MPOL_PREFERRED在节点内存不足时回退到其他节点
+  static bool bindNode(void *ptr, uint32_t size, int node)
+  {
+    const int bits = (int)sizeof(unsigned long) * 8;
+    unsigned long mask[16] = {0};
+    if (node >= bits * 16)
+      return false;
+    mask[node / bits] |= 1UL << (node % bits);
+    const int mpol_preferred = 1;
+    return syscall(SYS_mbind, ptr, (unsigned long)size, mpol_preferred, mask, (unsigned long)(bits * 16), 0) == 0;
+  }
+#endif
+};
+
+// 跨进程唤醒信号：Linux直接在共享内存字上futex等待，不需要内核对象；
+// 其他平台没有跨进程的地址等待原语，改用按段名命名的计数信号（Windows为命名信号量，其他POSIX为命名管道），
+// wake(count)放行count次，放行时尚未进入等待的登记者在之后的wait中立即返回，不会丢失唤醒
+// 信号打开失败时退化为waitAddress的短休眠轮询
+class ShmWakeSignal
+{
+private:
+#ifdef _WIN32
+  HANDLE _sem = nullptr;
+#elif !defined(__linux__)
+  int _fd = -1;
+
+  static std::string fifoPath(const char *name, const char *tag)
+  {
+    std::string path = "/tmp/";
+    for (const char *p = name; *p; p++)
+      path += *p == '/' ? '_' : *p;
+    return path + "." + tag + ".wake";
+  }
+#endif
+
+public:
+  // 创建或打开name段上名为tag的信号（同一段的各方须使用相同的tag）
+  bool open(const char *name, const char *tag)
+  {
+    close();
+#ifdef _WIN32
+    std::string sem_name = std::string(name) + "." + tag;
+    _sem = CreateSemaphoreA(nullptr, 0, 0x7FFFFFFF, sem_name.c_str());
+    return _sem != nullptr;
+#elif !defined(__linux__)
+    std::string path = fifoPath(name, tag);
+    if (mkfifo(path.c_str(), 0666) != 0 && errno != EEXIST)
+      return false;
+    _fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    return _fd >= 0;
+#else
+    (void)name;
+    (void)tag;
+    return true;
+#endif
+  }
+
+  // *addr仍等于expected时休眠，直到被wake放行或超时（timeout_ms<0不超时）；可能被此前多余的放行提前唤醒，调用方需循环重查
+  void wait(std::atomic<uint32_t> *addr, uint32_t expected, int timeout_ms)
+  {
+#ifdef _WIN32
+    if (!_sem)
+      return ShmCrossPlatform::waitAddress(addr, expected, timeout_ms);
+    if (addr->load(std::memory_order_acquire) != expected || timeout_ms == 0)
+      return;
+    WaitForSingleObject(_sem, timeout_ms < 0 ? INFINITE : (DWORD)timeout_ms);
+#elif !defined(__linux__)
+    if (_fd < 0)
+      return ShmCrossPlatform::waitAddress(addr, expected, timeout_ms);
+    if (addr->load(std::memory_order_acquire) != expected || timeout_ms == 0)
+      return;
+    struct pollfd pfd = {_fd, POLLIN, 0};
+    if (poll(&pfd, 1, timeout_ms) > 0)
+    {
+      char b;
+      (void)!::read(_fd, &b, 1); // 被其他等待者先取走时读不到，按提前唤醒处理
+    }
+#else
+    ShmCrossPlatform::waitAddress(addr, expected, timeout_ms);
+#endif
+  }
+
+  // 唤醒addr上的等待者；count为已登记的等待者数（Linux以外按此放行）
+  void wake(std::atomic<uint32_t> *addr, uint32_t count)
+  {
+#ifdef _WIN32
+    if (_sem && count)
+      ReleaseSemaphore(_sem, (LONG)count, nullptr);
+#elif !defined(__linux__)
+    if (_fd >= 0 && count)
+    {
+      // 管道缓冲写满说明等待者已有足够多的放行
+      char buf[64] = {0};
+      (void)!::write(_fd, buf, count < sizeof(buf) ? count : sizeof(buf));
+    }
+#else
+    (void)count;
+#endif
+    ShmCrossPlatform::wakeAddress(addr);
+  }
+
+  void close()
+  {
+#ifdef _WIN32
+    if (_sem)
+      CloseHandle(_sem);
+    _sem = nullptr;
+#elif !defined(__linux__)
+    if (_fd >= 0)
+      ::close(_fd);
+    _fd = -1;
+#endif
+  }
+
+  // 删除信号的名字（与ShmCrossPlatform::remove配合）；Windows上随最后一个句柄关闭而释放
+  static void remove(const char *name, const char *tag)
+  {
+#if !defined(_WIN32) && !defined(__linux__)
+    unlink(fifoPath(name, tag).c_str());
+#else
+    (void)name;
+    (void)tag;
+#endif
+  }
+};
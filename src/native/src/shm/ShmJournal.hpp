@@ -0,0 +1,550 @@
+#pragma once
+#include "ShmCommon.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#define SHM_JOURNAL_MAGIC 0x4E524A53     // "SJRN"
+#define SHM_JOURNAL_REC_MAGIC 0x43524A53 // "SJRC"
+#define SHM_JOURNAL_GAP_MAGIC 0x47524A53 // "SJRG"：缺口记录，只有消息头，负载超过段容量未写入
+#define SHM_JOURNAL_VERSION 1
+#define SHM_JOURNAL_INDEX 4096 // 每段稀疏索引条数
+#define SHM_JOURNAL_STRIDE 256 // 每隔多少条记录登记一次索引（单段最多INDEX * STRIDE条）
+
+// 日志段头部：段文件固定大小，创建时预分配
+// 读端只读取序号小于committed_seq的记录；写端每次组提交后更新
+struct ShmJournalSegment
+{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t base_seq;                       // 本段第一条记录的序号
+  uint64_t size;                           // 段文件大小
+  std::atomic<uint64_t> committed;         // 已提交记录的末尾偏移（恢复的起点）
+  std::atomic<uint64_t> committed_seq;     // 已提交的下一个序号
+  std::atomic<uint32_t> sealed;            // 1表示写端已切换到下一段
+  uint64_t index[SHM_JOURNAL_INDEX];       // 第k * STRIDE条记录的偏移
+};
+
+// 日志记录：记录头 | payload_len字节负载 | 补齐到8字节
+// magic最后写入：进程崩溃后从committed向后扫描，magic与序号都对得上的记录即为完整记录
+// 段内序号连续；段切换失败期间的消息没有记录，表现为相邻两段之间的序号缺口
+struct ShmJournalRecord
+{
+  std::atomic<uint32_t> magic;
+  uint32_t payload_len;
+  uint64_t seq;
+  ShmMessage msg;
+};
+
+// 文件映射（日志段）
+struct ShmFileMap
+{
+#ifdef _WIN32
+  HANDLE file = INVALID_HANDLE_VALUE;
+  HANDLE map = nullptr;
+#else
+  int fd = -1;
+#endif
+  uint8_t *ptr = nullptr;
+  uint64_t size = 0;
+
+  // size为0时映射已有文件的全部内容；create时新建并预分配size字节
+  bool open(const char *path, uint64_t want, bool create, bool writable)
+  {
+    close();
+#ifdef _WIN32
+    file = CreateFileA(path, writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                       FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                       create ? CREATE_NEW : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+      return false;
+    LARGE_INTEGER len;
+    if (create)
+      len.QuadPart = (LONGLONG)want;
+    else if (!GetFileSizeEx(file, &len))
+      len.QuadPart = 0;
+    size = (uint64_t)len.QuadPart;
+    if (size > 0)
+      map = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, len.HighPart, len.LowPart, nullptr);
+    if (map)
+      ptr = (uint8_t *)MapViewOfFile(map, writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, 0);
+#else
+    fd = ::open(path, (writable ? O_RDWR : O_RDONLY) | (create ? O_CREAT | O_EXCL : 0), 0644);
+    if (fd < 0)
+      return false;
+    if (create)
+    {
+      // 预分配磁盘空间：稀疏文件在磁盘满时写映射会触发SIGBUS
+#if defined(__linux__)
+      bool ok = posix_fallocate(fd, 0, (off_t)want) == 0;
+#else
+      bool ok = ftruncate(fd, (off_t)want) == 0;
+#endif
+      size = ok ? want : 0;
+    }
+    else
+    {
+      struct stat st;
+      size = fstat(fd, &st) == 0 ? (uint64_t)st.st_size : 0;
+    }
+    if (size > 0)
+    {
+      void *p = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+      ptr = p == MAP_FAILED ? nullptr : (uint8_t *)p;
+    }
+#endif
+    if (!ptr)
+    {
+      close();
+      if (create)
+        remove(path);
+      return false;
+    }
+    return true;
+  }
+
+  // 接管other的映射，other不再持有
+  void take(ShmFileMap &other)
+  {
+    close();
+    *this = other;
+    other = ShmFileMap();
+  }
+
+  // 把[off, off + len)刷到磁盘；wait为false时只发起写回
+  void sync(uint64_t off, uint64_t len, bool wait)
+  {
+    if (!ptr || len == 0)
+      return;
+    const uint64_t page = 4096;
+    uint64_t begin = off / page * page;
+#ifdef _WIN32
+    FlushViewOfFile(ptr + begin, (SIZE_T)(off + len - begin));
+    if (wait)
+      FlushFileBuffers(file);
+#else
+    msync(ptr + begin, off + len - begin, wait ? MS_SYNC : MS_ASYNC);
+#endif
+  }
+
+  void close()
+  {
+#ifdef _WIN32
+    if (ptr)
+      UnmapViewOfFile(ptr);
+    if (map)
+      CloseHandle(map);
+    if (file != INVALID_HANDLE_VALUE)
+      CloseHandle(file);
+    map = nullptr;
+    file = INVALID_HANDLE_VALUE;
+#else
+    if (ptr)
+      munmap(ptr, size);
+    if (fd >= 0)
+      ::close(fd);
+    fd = -1;
+#endif
+    ptr = nullptr;
+    size = 0;
+  }
+};
+
+// 日志段文件：<base>.<20位起始序号>.jseg，与base同目录
+struct ShmJournalFiles
+{
+  static constexpr uint64_t kDataStart = (sizeof(ShmJournalSegment) + 4095) / 4096 * 4096;
+
+  static uint64_t recordSize(uint32_t payload_len)
+  {
+    return sizeof(ShmJournalRecord) + ((payload_len + 7u) & ~7u);
+  }
+
+  static std::string segmentPath(const std::string &base, uint64_t seq)
+  {
+    char num[32];
+    snprintf(num, sizeof(num), "%020llu", (unsigned long long)seq);
+    return base + "." + num + ".jseg";
+  }
+
+  // 按起始序号升序列出已有的段
+  static std::vector<uint64_t> list(const std::string &base)
+  {
+    namespace fs = std::filesystem;
+    std::vector<uint64_t> segs;
+    fs::path p(base);
+    fs::path dir = p.has_parent_path() ? p.parent_path() : fs::path(".");
+    std::string prefix = p.filename().string() + ".";
+    const std::string suffix = ".jseg";
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec))
+    {
+      std::string name = it->path().filename().string();
+      if (name.size() != prefix.size() + 20 + suffix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+          name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+        continue;
+      std::string num = name.substr(prefix.size(), 20);
+      if (num.find_first_not_of("0123456789") != std::string::npos)
+        continue;
+      segs.push_back(strtoull(num.c_str(), nullptr, 10));
+    }
+    std::sort(segs.begin(), segs.end());
+    return segs;
+  }
+
+  static bool valid(const ShmFileMap &map)
+  {
+    const ShmJournalSegment *seg = (const ShmJournalSegment *)map.ptr;
+    return map.size >= kDataStart && seg->magic == SHM_JOURNAL_MAGIC && seg->version == SHM_JOURNAL_VERSION &&
+           seg->size == map.size && seg->committed.load(std::memory_order_acquire) <= map.size;
+  }
+};
+
+// 日志选项
+struct ShmJournalOptions
+{
+  uint64_t segment_bytes = 64ull << 20; // 段文件大小
+  uint32_t group_records = 256;         // 累计这么多条提交一次
+  uint32_t group_ms = 10;               // 或距上次提交超过这么久（追加与commitIfDue时检查，没有定时器）
+  uint32_t max_segments = 0;            // 保留的段数，0表示不删除
+  bool sync = false;                    // 提交时等待落盘（否则只发起写回）
+};
+
+// 通道日志（写端）：按序号追加消息，组提交后对读端可见并异步刷盘；段写满时切换到新段
+// 提交只发生在写端线程上：写端空闲时需调用commitIfDue()（或ShmChannel::flush），否则最后不足一组的记录要等到下一次追加或close
+// 进程崩溃后open从最后一段的committed向后扫描完整记录，恢复耗时与一个提交组的大小相当
+class ShmJournal
+{
+private:
+  std::string _base;
+  ShmJournalOptions _opt;
+  ShmFileMap _map;
+  ShmJournalSegment *_seg = nullptr;
+  std::vector<uint64_t> _segments;
+  uint64_t _offset = 0; // 下一条记录的偏移
+  uint64_t _synced = 0; // 已发起刷盘的末尾
+  uint64_t _next = 0;   // 下一条记录的序号
+  uint32_t _pending = 0;
+  bool _roll_failed = false; // 上次段切换失败：之后的追加都先重试切换，不再写入旧段
+  std::chrono::steady_clock::time_point _last_commit;
+
+  // 新段初始化完成后才封口并替换当前段（读端看到封口时下一段已可读），失败时当前段保持不变
+  // 段文件先以临时名创建，段头落盘后再改为正式名：崩溃不会留下没有有效段头的正式段
+  bool createSegment(uint64_t seq)
+  {
+    std::string path = ShmJournalFiles::segmentPath(_base, seq);
+    std::string tmp = path + ".tmp";
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec) || ec)
+      return false;
+    remove(tmp.c_str()); // 上次崩溃遗留
+    ShmFileMap map;
+    if (!map.open(tmp.c_str(), _opt.segment_bytes, true, true))
+      return false;
+    ShmJournalSegment *seg = (ShmJournalSegment *)map.ptr;
+    seg->version = SHM_JOURNAL_VERSION;
+    seg->base_seq = seq;
+    seg->size = map.size;
+    seg->committed.store(ShmJournalFiles::kDataStart, std::memory_order_relaxed);
+    seg->committed_seq.store(seq, std::memory_order_relaxed);
+    seg->sealed.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    seg->magic = SHM_JOURNAL_MAGIC;
+    map.sync(0, ShmJournalFiles::kDataStart, true);
+    std::filesystem::rename(tmp, path, ec);
+    if (ec)
+    {
+      map.close();
+      remove(tmp.c_str());
+      return false;
+    }
+    if (_seg)
+    {
+      _seg->sealed.store(1, std::memory_order_release);
+      _map.sync(0, ShmJournalFiles::kDataStart, _opt.sync);
+    }
+    _map.take(map);
+    _seg = seg;
+    _offset = _synced = ShmJournalFiles::kDataStart;
+    _segments.push_back(seq);
+    return true;
+  }
+
+  // 从committed向后找回已写完但未提交的记录
+  void recover()
+  {
+    _offset = _seg->committed.load(std::memory_order_relaxed);
+    _next = _seg->committed_seq.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      if (_offset + sizeof(ShmJournalRecord) > _map.size)
+        break;
+      const ShmJournalRecord *rec = (const ShmJournalRecord *)(_map.ptr + _offset);
+      uint64_t n = _next - _seg->base_seq;
+      uint32_t magic = rec->magic.load(std::memory_order_acquire);
+      if ((magic != SHM_JOURNAL_REC_MAGIC && magic != SHM_JOURNAL_GAP_MAGIC) || rec->seq != _next ||
+          _offset + ShmJournalFiles::recordSize(rec->payload_len) > _map.size || n >= (uint64_t)SHM_JOURNAL_INDEX * SHM_JOURNAL_STRIDE)
+        break;
+      if (n % SHM_JOURNAL_STRIDE == 0)
+        _seg->index[n / SHM_JOURNAL_STRIDE] = _offset;
+      _offset += ShmJournalFiles::recordSize(rec->payload_len);
+      _next++;
+    }
+    _synced = ShmJournalFiles::kDataStart;
+    _pending = 1;
+    commit();
+  }
+
+  // 切换到从seq开始的新段
+  bool roll(uint64_t seq)
+  {
+    commit();
+    if (!createSegment(seq))
+      return false;
+    while (_opt.max_segments && _segments.size() > _opt.max_segments)
+    {
+      remove(ShmJournalFiles::segmentPath(_base, _segments.front()).c_str());
+      _segments.erase(_segments.begin());
+    }
+    return true;
+  }
+
+public:
+  ~ShmJournal() { close(); }
+
+  // 打开或创建base对应的日志；已有日志时恢复到最后一条完整记录，之后从nextSeq()继续追加
+  bool open(const char *base, const ShmJournalOptions &opt = ShmJournalOptions())
+  {
+    close();
+    _base = base;
+    _opt = opt;
+    if (_opt.segment_bytes < ShmJournalFiles::kDataStart * 2)
+      _opt.segment_bytes = ShmJournalFiles::kDataStart * 2;
+    _segments = ShmJournalFiles::list(_base);
+    _roll_failed = false;
+    _last_commit = std::chrono::steady_clock::now();
+    // 末尾没有有效段头的段（旧版本创建段时崩溃、段头未落盘）不含已提交的记录：删除后从前一段恢复
+    uint64_t next = 0;
+    while (!_segments.empty())
+    {
+      std::string path = ShmJournalFiles::segmentPath(_base, _segments.back());
+      bool mapped = _map.open(path.c_str(), 0, false, true);
+      if (mapped && ShmJournalFiles::valid(_map))
+        break;
+      _map.close();
+      std::error_code ec;
+      if (!mapped && std::filesystem::file_size(path, ec) != 0)
+        return false; // 无法打开（如没有权限），不能当作空段删除
+      next = _segments.back();
+      remove(path.c_str());
+      _segments.pop_back();
+    }
+    if (_segments.empty())
+    {
+      _next = next;
+      return createSegment(next);
+    }
+    _seg = (ShmJournalSegment *)_map.ptr;
+    recover();
+    if (_seg->sealed.load(std::memory_order_relaxed))
+      return roll(_next);
+    return true;
+  }
+
+  bool isOpen() const { return _seg != nullptr; }
+  uint64_t nextSeq() const { return _next; }
+  uint64_t firstSeq() const { return _segments.empty() ? _next : _segments.front(); }
+  const std::string &path() const { return _base; }
+
+  // 追加一条记录，seq必须等于nextSeq()；达到组大小或间隔时自动提交
+  // 返回false表示本条没有完整写入，序号仍然前进，日志与通道的write_seq保持一致：
+  // 负载超过段容量时只写消息头（缺口记录）；新段创建失败时本条不写入，下次追加重试切换
+  bool append(uint64_t seq, const ShmMessage &msg, const void *payload, uint32_t len)
+  {
+    if (!_seg || seq != _next)
+      return false;
+    if (!payload)
+      len = 0;
+    uint32_t magic = SHM_JOURNAL_REC_MAGIC;
+    if (ShmJournalFiles::kDataStart + ShmJournalFiles::recordSize(len) > _opt.segment_bytes)
+    {
+      magic = SHM_JOURNAL_GAP_MAGIC;
+      len = 0;
+    }
+    uint64_t need = ShmJournalFiles::recordSize(len);
+    uint64_t n = seq - _seg->base_seq;
+    if (_roll_failed || _offset + need > _map.size || n >= (uint64_t)SHM_JOURNAL_INDEX * SHM_JOURNAL_STRIDE)
+    {
+      _roll_failed = !roll(seq);
+      if (_roll_failed)
+      {
+        _next++;
+        return false;
+      }
+      n = 0;
+    }
+    if (n % SHM_JOURNAL_STRIDE == 0)
+      _seg->index[n / SHM_JOURNAL_STRIDE] = _offset;
+    ShmJournalRecord *rec = (ShmJournalRecord *)(_map.ptr + _offset);
+    rec->payload_len = len;
+    rec->seq = seq;
+    rec->msg = msg;
+    if (len)
+      memcpy((uint8_t *)(rec + 1), payload, len);
+    rec->magic.store(magic, std::memory_order_release);
+    _offset += need;
+    _next++;
+    // 慢速写入时每条都会超过间隔而立即提交；高速写入时只在组内少数位置读时钟
+    ++_pending;
+    if (_pending >= _opt.group_records ||
+        ((_pending & 15) == 1 && std::chrono::steady_clock::now() - _last_commit >= std::chrono::milliseconds(_opt.group_ms)))
+      commit();
+    return magic == SHM_JOURNAL_REC_MAGIC;
+  }
+
+  // 有未提交记录且距上次提交超过group_ms时提交，返回是否提交；供写端空闲时周期调用
+  bool commitIfDue()
+  {
+    if (_pending == 0 || std::chrono::steady_clock::now() - _last_commit < std::chrono::milliseconds(_opt.group_ms))
+      return false;
+    commit();
+    return true;
+  }
+
+  // 组提交：发布committed_seq并刷盘
+  void commit()
+  {
+    if (!_seg || _pending == 0)
+      return;
+    _seg->committed.store(_offset, std::memory_order_relaxed);
+    _seg->committed_seq.store(_next, std::memory_order_release);
+    _map.sync(_synced, _offset - _synced, false);
+    _map.sync(0, ShmJournalFiles::kDataStart, _opt.sync);
+    if (_opt.sync)
+      _map.sync(_synced, _offset - _synced, true);
+    _synced = _offset;
+    _pending = 0;
+    _last_commit = std::chrono::steady_clock::now();
+  }
+
+  void close()
+  {
+    commit();
+    _map.close();
+    _seg = nullptr;
+  }
+};
+
+// 日志读端：seek到历史序号后顺序读取已提交的记录，当前段封口后自动进入下一段
+class ShmJournalReader
+{
+private:
+  std::string _base;
+  std::vector<uint64_t> _segments;
+  size_t _cur = 0;
+  ShmFileMap _map;
+  const ShmJournalSegment *_seg = nullptr;
+  uint64_t _offset = 0;
+  uint64_t _seq = 0;
+  bool _gap = false;
+
+  bool mapSegment(size_t i)
+  {
+    _seg = nullptr;
+    if (!_map.open(ShmJournalFiles::segmentPath(_base, _segments[i]).c_str(), 0, false, false) || !ShmJournalFiles::valid(_map))
+    {
+      _map.close();
+      return false;
+    }
+    _cur = i;
+    _seg = (const ShmJournalSegment *)_map.ptr;
+    _offset = ShmJournalFiles::kDataStart;
+    _seq = _seg->base_seq;
+    return true;
+  }
+
+public:
+  bool open(const char *base)
+  {
+    _map.close();
+    _seg = nullptr;
+    _base = base;
+    _segments = ShmJournalFiles::list(_base);
+    return !_segments.empty();
+  }
+
+  // 日志中最早的序号（更早的段已被删除）
+  uint64_t firstSeq() const { return _segments.empty() ? 0 : _segments.front(); }
+  // 下一次next()将返回的序号（段之间有缺口时next()返回的序号会跳过缺口）
+  uint64_t position() const { return _seq; }
+  // 上一次next()读到的是缺口记录：消息头完整，负载没有写入日志
+  bool gap() const { return _gap; }
+
+  // 定位到seq；seq早于日志开头或晚于已提交的末尾时返回false
+  // seq落在两段之间的缺口内时定位到下一段开头，position()为实际位置
+  bool seek(uint64_t seq)
+  {
+    if (_segments.empty() || seq < _segments.front())
+      return false;
+    size_t i = std::upper_bound(_segments.begin(), _segments.end(), seq) - _segments.begin() - 1;
+    if (!mapSegment(i))
+      return false;
+    uint64_t committed = _seg->committed_seq.load(std::memory_order_acquire);
+    if (seq > committed)
+      return _seg->sealed.load(std::memory_order_acquire) && i + 1 < _segments.size() && mapSegment(i + 1);
+    // 从不晚于seq、且已提交的最近一个索引点向后逐条跳过
+    uint64_t n = seq - _seg->base_seq;
+    uint64_t k = n / SHM_JOURNAL_STRIDE;
+    while (k > 0 && _seg->base_seq + k * SHM_JOURNAL_STRIDE >= committed)
+      k--;
+    _offset = k ? _seg->index[k] : ShmJournalFiles::kDataStart;
+    _seq = _seg->base_seq + k * SHM_JOURNAL_STRIDE;
+    while (_seq < seq)
+    {
+      const ShmJournalRecord *rec = (const ShmJournalRecord *)(_map.ptr + _offset);
+      _offset += ShmJournalFiles::recordSize(rec->payload_len);
+      _seq++;
+    }
+    return true;
+  }
+
+  // 读取下一条已提交的记录；payload指向映射内部，在下一次next/seek之前有效
+  bool next(uint64_t &seq, ShmMessage &msg, const uint8_t *&payload, uint32_t &payload_len)
+  {
+    for (;;)
+    {
+      if (!_seg)
+        return false;
+      if (_seq < _seg->committed_seq.load(std::memory_order_acquire))
+      {
+        const ShmJournalRecord *rec = (const ShmJournalRecord *)(_map.ptr + _offset);
+        if (rec->seq != _seq || _offset + ShmJournalFiles::recordSize(rec->payload_len) > _map.size)
+          return false;
+        seq = rec->seq;
+        msg = rec->msg;
+        _gap = rec->magic.load(std::memory_order_acquire) == SHM_JOURNAL_GAP_MAGIC;
+        payload_len = rec->payload_len;
+        payload = payload_len ? (const uint8_t *)(rec + 1) : nullptr;
+        _offset += ShmJournalFiles::recordSize(rec->payload_len);
+        _seq++;
+        return true;
+      }
+      // 本段已读完：写端封口后进入下一段（必要时重新列出段文件）
+      if (!_seg->sealed.load(std::memory_order_acquire) || _seq < _seg->committed_seq.load(std::memory_order_acquire))
+        return false;
+      size_t i = _cur + 1;
+      if (i >= _segments.size())
+      {
+        _segments = ShmJournalFiles::list(_base);
+        i = std::upper_bound(_segments.begin(), _segments.end(), _seg->base_seq) - _segments.begin();
+      }
+      // 下一段起始序号大于_seq说明写端切换段失败过，中间的消息没有记录，直接跳过
+      if (i >= _segments.size() || _segments[i] < _seq || !mapSegment(i))
+        return false;
+    }
+  }
+};
@@ -0,0 +1,365 @@
+#pragma once
+#include "ShmCrossPlatform.hpp"
+#include <functional>
+#ifndef _WIN32
+#include <errno.h>
+#include <signal.h>
+#endif
+
+// 共享内存RPC：每个客户端独占一对单生产者单消费者帧环（请求/响应），调用方与服务端都先自旋再futex休眠
+// 帧为定长256字节：16字节头 + 内联负载，请求与响应的负载均为小端定长字段
+#define SHM_RPC_MAGIC 0x43505253 // "SRPC"
+#define SHM_RPC_CLIENTS 8        // 同时连接的客户端数
+#define SHM_RPC_DEPTH 8          // 每个方向的帧环深度（2的幂）
+#define SHM_RPC_INLINE 240       // 每帧负载上限
+
+// 状态码（E_TIMEOUT与E_DISCONNECTED只由客户端本地产生）
+#define SHM_RPC_OK 0
+#define SHM_RPC_E_METHOD 1
+#define SHM_RPC_E_ARGS 2
+#define SHM_RPC_E_FAILED 3
+#define SHM_RPC_E_TIMEOUT 4
+#define SHM_RPC_E_DISCONNECTED 5
+
+// 内置方法
+#define SHM_RPC_PING 1      // 请求任意字节，原样返回
+#define SHM_RPC_CURSOR 2    // 响应：x i32 | y i32
+#define SHM_RPC_WINDOW_AT 3 // 请求：x i32 | y i32；响应：handle i64 | pid i32 | x i32 | y i32 | width u32 | height u32 | title utf8（未命中时长度为0）
+
+struct ShmRpcFrame
+{
+  uint32_t call_id;
+  uint16_t method;
+  uint16_t status; // 响应状态，SHM_RPC_OK或SHM_RPC_E_*
+  uint32_t len;    // 负载长度
+  uint32_t reserved;
+  uint8_t data[SHM_RPC_INLINE];
+};
+static_assert(sizeof(ShmRpcFrame) == 256, "ShmRpcFrame layout");
+
+// 单向帧环：head由生产者推进，同时是消费者休眠的futex字；tail由消费者推进
+struct ShmRpcRing
+{
+  alignas(SHM_CACHE_LINE) std::atomic<uint32_t> head;
+  std::atomic<uint32_t> waiting; // 消费者在head上休眠
+  alignas(SHM_CACHE_LINE) std::atomic<uint32_t> tail;
+  ShmRpcFrame frames[SHM_RPC_DEPTH];
+};
+
+struct ShmRpcPair
+{
+  alignas(SHM_CACHE_LINE) std::atomic<uint32_t> owner; // 0表示空闲，否则为客户端进程号
+  ShmRpcRing request;
+  ShmRpcRing response;
+};
+
+struct ShmRpcHeader
+{
+  uint32_t magic;
+  std::atomic<uint32_t> running; // 服务端在线
+  // 服务端休眠：置server_waiting后在doorbell上等待，客户端提交请求后发现有休眠则递增并唤醒
+  alignas(SHM_CACHE_LINE) std::atomic<uint32_t> doorbell;
+  std::atomic<uint32_t> server_waiting;
+  ShmRpcPair pairs[SHM_RPC_CLIENTS];
+};
+
+// 单核机器上自旋只会抢占对端的时间片，直接休眠
+inline bool shmRpcCanSpin()
+{
+  static const bool multi = std::thread::hardware_concurrency() > 1;
+  return multi;
+}
+
+// 服务端：轮询所有已连接客户端的请求环，处理函数的返回值作为响应状态
+class ShmRpcServer
+{
+public:
+  // (method, 请求负载, 请求长度, 响应缓冲[SHM_RPC_INLINE], 响应长度) -> 状态码
+  using Handler = std::function<uint16_t(uint16_t, const uint8_t *, uint32_t, uint8_t *, uint32_t &)>;
+
+private:
+  ShmHandle _h{};
+  ShmRpcHeader *_hdr{};
+
+  // 响应环已满时丢弃：此时环里全是客户端超时后未取走的迟到响应，覆盖会破坏客户端正在读取的帧
+  static void respond(ShmRpcRing &ring, const ShmRpcFrame &frame)
+  {
+    uint32_t h = ring.head.load(std::memory_order_relaxed);
+    if (h - ring.tail.load(std::memory_order_acquire) >= SHM_RPC_DEPTH)
+      return;
+    ring.frames[h & (SHM_RPC_DEPTH - 1)] = frame;
+    ring.head.store(h + 1, std::memory_order_release);
+    // 与客户端置waiting后重查head配对（Dekker式）
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (ring.waiting.load(std::memory_order_relaxed))
+      ShmCrossPlatform::wakeAddress(&ring.head);
+  }
+
+  bool pending() const
+  {
+    for (const ShmRpcPair &p : _hdr->pairs)
+    {
+      if (p.owner.load(std::memory_order_relaxed) &&
+          p.request.head.load(std::memory_order_acquire) != p.request.tail.load(std::memory_order_relaxed))
+        return true;
+    }
+    return false;
+  }
+
+public:
+  // 段只允许当前用户访问，其他本地用户不能调用方法或篡改请求/响应环
+  bool create(const char *name)
+  {
+    ShmMapOptions opt;
+    opt.owner_only = true;
+    if (!ShmCrossPlatform::create(&_h, name, sizeof(ShmRpcHeader), opt))
+      return false;
+    _hdr = (ShmRpcHeader *)_h.ptr;
+    memset((void *)_hdr, 0, sizeof(ShmRpcHeader));
+    _hdr->magic = SHM_RPC_MAGIC;
+    _hdr->running.store(1, std::memory_order_release);
+    return true;
+  }
+
+  // 处理所有已到达的请求，返回处理条数
+  size_t poll(const Handler &handler)
+  {
+    size_t n = 0;
+    ShmRpcFrame resp;
+    for (ShmRpcPair &p : _hdr->pairs)
+    {
+      if (!p.owner.load(std::memory_order_acquire))
+        continue;
+      ShmRpcRing &req = p.request;
+      uint32_t t = req.tail.load(std::memory_order_relaxed);
+      while (t != req.head.load(std::memory_order_acquire))
+      {
+        const ShmRpcFrame &in = req.frames[t & (SHM_RPC_DEPTH - 1)];
+        resp.call_id = in.call_id;
+        resp.method = in.method;
+        resp.reserved = 0;
+        resp.len = 0;
+        resp.status = in.len > SHM_RPC_INLINE ? SHM_RPC_E_ARGS : handler(in.method, in.data, in.len, resp.data, resp.len);
+        if (resp.len > SHM_RPC_INLINE)
+          resp.len = 0;
+        req.tail.store(++t, std::memory_order_release);
+        respond(p.response, resp);
+        n++;
+      }
+    }
+    return n;
+  }
+
+  // 服务循环，直到stop为true：最后一次请求后忙等spin_us微秒以保持微秒级延迟，之后在doorbell上休眠
+  void run(const Handler &handler, const std::atomic<bool> &stop, int spin_us = 50)
+  {
+    if (!shmRpcCanSpin())
+      spin_us = 0;
+    auto idle_since = std::chrono::steady_clock::now();
+    while (!stop.load(std::memory_order_relaxed))
+    {
+      if (poll(handler))
+      {
+        idle_since = std::chrono::steady_clock::now();
+        continue;
+      }
+      if (std::chrono::steady_clock::now() - idle_since < std::chrono::microseconds(spin_us))
+      {
+        for (int i = 0; i < 64; i++)
+          ShmCrossPlatform::cpuRelax();
+        continue;
+      }
+      _hdr->server_waiting.store(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      uint32_t token = _hdr->doorbell.load(std::memory_order_acquire);
+      if (!pending() && !stop.load(std::memory_order_relaxed))
+        ShmCrossPlatform::waitAddress(&_hdr->doorbell, token, 100);
+      _hdr->server_waiting.store(0, std::memory_order_relaxed);
+      idle_since = std::chrono::steady_clock::now();
+    }
+  }
+
+  // 打断run中的休眠（配合stop使用）
+  void wake()
+  {
+    if (!_hdr)
+      return;
+    _hdr->doorbell.fetch_add(1, std::memory_order_release);
+    ShmCrossPlatform::wakeAddress(&_hdr->doorbell);
+  }
+
+  bool isOpen() const { return _hdr != nullptr; }
+
+  // 下线并唤醒所有等待响应的客户端，使其返回SHM_RPC_E_DISCONNECTED
+  void close()
+  {
+    if (!_hdr)
+      return;
+    _hdr->running.store(0, std::memory_order_seq_cst);
+    for (ShmRpcPair &p : _hdr->pairs)
+      ShmCrossPlatform::wakeAddress(&p.response.head);
+    ShmCrossPlatform::close(&_h);
+    _hdr = nullptr;
+  }
+};
+
+// 客户端：连接时占用一对帧环，由单个线程发起同步调用
+class ShmRpcClient
+{
+private:
+  ShmHandle _h{};
+  ShmRpcHeader *_hdr{};
+  ShmRpcPair *_pair{};
+  uint32_t _next_call = 0;
+
+  static uint32_t selfId()
+  {
+#ifdef _WIN32
+    return (uint32_t)GetCurrentProcessId();
+#else
+    return (uint32_t)getpid();
+#endif
+  }
+
+  // 占用者进程已退出的帧环可以回收（仅POSIX能可靠判断）
+  static bool stale(uint32_t owner)
+  {
+#ifdef _WIN32
+    (void)owner;
+    return false;
+#else
+    return kill((pid_t)owner, 0) != 0 && errno == ESRCH;
+#endif
+  }
+
+public:
+  ~ShmRpcClient() { disconnect(); }
+
+  bool connect(const char *name)
+  {
+    disconnect();
+    if (!ShmCrossPlatform::open(&_h, name, sizeof(ShmRpcHeader)))
+      return false;
+    _hdr = (ShmRpcHeader *)_h.ptr;
+    uint32_t self = selfId();
+    if (_hdr->magic == SHM_RPC_MAGIC)
+    {
+      for (int pass = 0; pass < 2 && !_pair; pass++)
+      {
+        for (ShmRpcPair &p : _hdr->pairs)
+        {
+          uint32_t owner = p.owner.load(std::memory_order_relaxed);
+          if ((owner == 0 || (pass == 1 && stale(owner))) && p.owner.compare_exchange_strong(owner, self))
+          {
+            _pair = &p;
+            break;
+          }
+        }
+      }
+    }
+    if (!_pair)
+    {
+      ShmCrossPlatform::close(&_h);
+      _hdr = nullptr;
+      return false;
+    }
+    // 丢弃上一个占用者遗留的响应；调用号从不同起点开始，避免与遗留请求的响应混淆
+    _pair->response.tail.store(_pair->response.head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    _next_call = self * 2654435761u + (uint32_t)std::chrono::steady_clock::now().time_since_epoch().count();
+    return true;
+  }
+
+  bool isConnected() const { return _pair != nullptr && _hdr->running.load(std::memory_order_relaxed); }
+
+  // 同步调用：响应负载写入resp（容量SHM_RPC_INLINE），返回状态码
+  // 先忙等spin_us微秒，之后在响应环上休眠，直到超时（timeout_ms<0不超时）
+  uint16_t call(uint16_t method, const void *req, uint32_t len, uint8_t *resp, uint32_t &resp_len,
+                int timeout_ms = 1000, int spin_us = 20)
+  {
+    resp_len = 0;
+    if (!_pair || !_hdr->running.load(std::memory_order_acquire))
+      return SHM_RPC_E_DISCONNECTED;
+    if (len > SHM_RPC_INLINE)
+      return SHM_RPC_E_ARGS;
+    // 提交前丢弃之前超时调用的迟到响应，为本次响应腾出空间
+    ShmRpcRing &rs = _pair->response;
+    rs.tail.store(rs.head.load(std::memory_order_acquire), std::memory_order_release);
+    ShmRpcRing &rq = _pair->request;
+    uint32_t h = rq.head.load(std::memory_order_relaxed);
+    if (h - rq.tail.load(std::memory_order_acquire) >= SHM_RPC_DEPTH)
+      return SHM_RPC_E_DISCONNECTED; // 之前超时的请求仍未被处理：服务端没有在消费
+    ShmRpcFrame &out = rq.frames[h & (SHM_RPC_DEPTH - 1)];
+    uint32_t id = ++_next_call;
+    out.call_id = id;
+    out.method = method;
+    out.status = 0;
+    out.len = len;
+    if (len)
+      memcpy(out.data, req, len);
+    rq.head.store(h + 1, std::memory_order_release);
+    // 与服务端置server_waiting后重查请求配对（Dekker式）
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_hdr->server_waiting.load(std::memory_order_relaxed))
+    {
+      _hdr->doorbell.fetch_add(1, std::memory_order_release);
+      ShmCrossPlatform::wakeAddress(&_hdr->doorbell);
+    }
+
+    if (!shmRpcCanSpin())
+      spin_us = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto spin_end = start + std::chrono::microseconds(spin_us);
+    auto deadline = start + std::chrono::milliseconds(timeout_ms);
+    for (uint32_t iter = 0;; iter++)
+    {
+      uint32_t t = rs.tail.load(std::memory_order_relaxed);
+      uint32_t head = rs.head.load(std::memory_order_acquire);
+      if (head != t)
+      {
+        const ShmRpcFrame &in = rs.frames[t & (SHM_RPC_DEPTH - 1)];
+        bool mine = in.call_id == id;
+        uint16_t status = in.status;
+        if (mine)
+        {
+          resp_len = in.len;
+          if (resp_len)
+            memcpy(resp, in.data, resp_len);
+        }
+        rs.tail.store(t + 1, std::memory_order_release);
+        if (mine)
+          return status;
+        continue; // 之前超时调用的迟到响应
+      }
+      if (!_hdr->running.load(std::memory_order_acquire))
+        return SHM_RPC_E_DISCONNECTED;
+      if ((iter & 63) != 0)
+      {
+        ShmCrossPlatform::cpuRelax();
+        continue;
+      }
+      auto now = std::chrono::steady_clock::now();
+      if (timeout_ms >= 0 && now >= deadline)
+        return SHM_RPC_E_TIMEOUT;
+      if (now < spin_end)
+        continue;
+      int remaining = -1;
+      if (timeout_ms >= 0)
+        remaining = (int)std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count();
+      rs.waiting.store(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (rs.head.load(std::memory_order_relaxed) == head)
+        ShmCrossPlatform::waitAddress(&rs.head, head, remaining);
+      rs.waiting.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void disconnect()
+  {
+    if (_pair)
+      _pair->owner.store(0, std::memory_order_release);
+    _pair = nullptr;
+    if (_hdr)
+      ShmCrossPlatform::close(&_h);
+    _hdr = nullptr;
+  }
+};
@@ -0,0 +1,108 @@
+#pragma once
+#include "ShmCommon.h"
+#include <stdio.h>
+#include <vector>
+
+#define SHM_SPILL_MAGIC 0x4C505353 // "SSPL"
+
+// 溢出文件记录：记录头 | payload_len字节负载 | 补齐到8字节
+struct ShmSpillRecord
+{
+  uint32_t magic;
+  uint32_t reserved;
+  ShmMessage msg;
+};
+
+// 通道溢出文件：写端追加记录，读端按偏移顺序读取
+class ShmSpill
+{
+private:
+  FILE *_fp = nullptr;
+
+  static bool seek(FILE *fp, uint64_t offset)
+  {
+#ifdef _WIN32
+    return _fseeki64(fp, (long long)offset, SEEK_SET) == 0;
+#else
+    return fseeko(fp, (off_t)offset, SEEK_SET) == 0;
+#endif
+  }
+
+public:
+  static uint64_t recordSize(uint32_t payload_len)
+  {
+    return sizeof(ShmSpillRecord) + ((payload_len + 7u) & ~7u);
+  }
+
+  bool open(const char *path)
+  {
+    close();
+    _fp = fopen(path, "ab");
+    return _fp != nullptr;
+  }
+
+  bool isOpen() const { return _fp != nullptr; }
+
+  // 追加一条记录并立即刷新，读端随后即可读到
+  bool append(const ShmMessage &msg, const void *payload, uint32_t len)
+  {
+    if (!_fp)
+      return false;
+    ShmSpillRecord rec{};
+    rec.magic = SHM_SPILL_MAGIC;
+    rec.msg = msg;
+    rec.msg.payload_len = payload ? len : 0;
+    static const uint8_t pad[8] = {};
+    uint32_t padding = ((rec.msg.payload_len + 7u) & ~7u) - rec.msg.payload_len;
+    bool ok = fwrite(&rec, sizeof(rec), 1, _fp) == 1 &&
+              (rec.msg.payload_len == 0 || fwrite(payload, rec.msg.payload_len, 1, _fp) == 1) &&
+              (padding == 0 || fwrite(pad, padding, 1, _fp) == 1);
+    return fflush(_fp) == 0 && ok;
+  }
+
+  void close()
+  {
+    if (_fp)
+      fclose(_fp);
+    _fp = nullptr;
+  }
+
+  // 打开溢出文件用于读取并定位到offset（记录边界），失败返回nullptr
+  static FILE *openRead(const char *path, uint64_t offset)
+  {
+    FILE *fp = fopen(path, "rb");
+    if (fp && !seek(fp, offset))
+    {
+      fclose(fp);
+      fp = nullptr;
+    }
+    return fp;
+  }
+
+  // 读取下一条完整记录；文件结束、记录尚未写完或格式不符时返回false（读位置回到记录开头）
+  static bool next(FILE *fp, ShmMessage &msg, std::vector<uint8_t> &payload)
+  {
+    long long start;
+#ifdef _WIN32
+    start = _ftelli64(fp);
+#else
+    start = (long long)ftello(fp);
+#endif
+    ShmSpillRecord rec;
+    if (fread(&rec, sizeof(rec), 1, fp) == 1 && rec.magic == SHM_SPILL_MAGIC)
+    {
+      uint32_t padded = (rec.msg.payload_len + 7u) & ~7u;
+      payload.resize(padded);
+      if (padded == 0 || fread(payload.data(), padded, 1, fp) == 1)
+      {
+        payload.resize(rec.msg.payload_len);
+        msg = rec.msg;
+        return true;
+      }
+    }
+    clearerr(fp);
+    if (start >= 0)
+      seek(fp, (uint64_t)start);
+    return false;
+  }
+};